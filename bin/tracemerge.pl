@@ -0,0 +1,86 @@
+#!/usr/bin/perl
+
+#
+#  This file is part of MADNESS.
+#
+#  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#
+#  For more information please contact:
+#
+#  Robert J. Harrison
+#  Oak Ridge National Laboratory
+#  One Bethel Valley Road
+#  P.O. Box 2008, MS-6367
+#
+#  email: harrisonrj@ornl.gov
+#  tel:   865-241-3937
+#  fax:   865-572-0680
+#
+
+# Merges the per-process traces written with MAD_TRACE=<prefix> into one
+# Chrome trace (printed to stdout).
+#
+# Each file's timestamps are relative to a barrier at initialize, which fixes
+# the offset between the clocks.  The header also holds the time between that
+# barrier and a second one at finalize; the timestamps of each process are
+# scaled so that this interval matches rank 0, which corrects for drift.
+
+use strict;
+
+&usage() if $#ARGV == -1;
+
+my %sync;     # rank -> sync_us
+my %events;   # rank -> list of events
+
+foreach my $file (@ARGV) {
+  open(my $fh, "<", $file) || die "cannot open $file";
+  my $header = <$fh>;
+  ($header =~ /"rank":(\d+)/) || die "$file is not a MADNESS trace";
+  my $rank = $1;
+  ($header =~ /"sync_us":([-+0-9.eE]+)/) || die "$file has no sync_us";
+  $sync{$rank} = $1;
+  my @lines;
+  while (my $line = <$fh>) {
+    chomp $line;
+    next unless $line =~ /^\{/;
+    $line =~ s/,$//;
+    push @lines, $line;
+  }
+  close($fh);
+  $events{$rank} = \@lines;
+}
+
+my @ranks = sort { $a <=> $b } keys %sync;
+my $ref   = $sync{$ranks[0]};
+
+print "[\n";
+my $first = 1;
+foreach my $rank (@ranks) {
+  my $scale = ($sync{$rank} > 0) ? $ref / $sync{$rank} : 1.0;
+  foreach my $line (@{$events{$rank}}) {
+    $line =~ s/"(ts|dur)":([-+0-9.eE]+)/sprintf("\"%s\":%.3f", $1, $2*$scale)/ge;
+    print ",\n" unless $first;
+    print $line;
+    $first = 0;
+  }
+}
+print "\n]\n";
+
+sub usage {
+  print "usage: tracemerge.pl <prefix>.0.json <prefix>.1.json ... > trace.json\n";
+  exit 1;
+}
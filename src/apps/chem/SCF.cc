@@ -39,6 +39,7 @@
 
 #include "SCF.h"
 #include <cmath>
+#include <algorithm>
 #include <madness/mra/qmprop.h>
 #include <chem/nemo.h>
 #include <chem/SCFOperators.h>
@@ -233,7 +234,10 @@ namespace madness {
     
     void SCF::save_mos(World& world) {
         PROFILE_MEMBER_FUNC(SCF);
-        archive::ParallelOutputArchive ar(world, "restartdata", param.nio);
+        // the previous checkpoint must be complete before its files are replaced
+        if (mos_saved && !mos_saved->get())
+            print("warning: failed to write restartdata on process", world.rank());
+        archive::AsyncParallelOutputArchive ar(world, "restartdata");
         ar & current_energy & param.spin_restricted;
         ar & (unsigned int) (amo.size());
         ar & aeps & aocc & aset;
@@ -245,6 +249,7 @@ namespace madness {
             for (unsigned int i = 0; i < bmo.size(); ++i)
                 ar & bmo[i];
         }
+        mos_saved.reset(new Future<bool>(ar.close()));
 
         tensorT Saoamo = matrix_inner(world, ao, amo);
         tensorT Saobmo = (!param.spin_restricted) ? matrix_inner(world, ao, bmo) : tensorT();
@@ -265,6 +270,7 @@ namespace madness {
         amo.clear();
         bmo.clear();
         
+        if (mos_saved) mos_saved->get();
         archive::ParallelInputArchive ar(world, "restartdata");
         
         /*
@@ -1211,6 +1217,7 @@ namespace madness {
         int nmo = evals.dim(0);
         std::vector < poperatorT > ops(nmo);
         double tol = FunctionDefaults < 3 > ::get_thresh();
+        std::vector<double> mu(nmo);
         for (int i = 0; i < nmo; ++i) {
             double eps = evals(i);
             if (eps > 0) {
@@ -1219,10 +1226,16 @@ namespace madness {
                 }
                 eps = -0.1;
             }
-            
-            ops[i] = poperatorT(
-                                BSHOperatorPtr3D(world, sqrt(-2.0 * eps), param.lo, tol));
+            mu[i] = sqrt(-2.0 * eps);
+        }
+
+        // The family covers the eigenvalues drifting up to 4x closer to zero
+        if (nmo > 0) {
+            const double mu_min = *std::min_element(mu.begin(), mu.end());
+            if (!bsh_family || !bsh_family->covers(mu_min) || bsh_family->get_eps() != tol)
+                bsh_family.reset(new BSHOperatorFamily<3>(world, 0.5 * mu_min, param.lo, tol));
         }
+        for (int i = 0; i < nmo; ++i) ops[i] = bsh_family->get(mu[i]);
         
         return ops;
     }
@@ -2636,7 +2649,8 @@ namespace madness {
             }
         }
 
-        
+        // Keep the operator blocks of this protocol step for later jobs
+        GaussianConvolution1DCache<double>::save(world);
     }        // end solve function
 
 
@@ -133,6 +133,12 @@ namespace madness {
         double operator()(const coordT& x) const {
             return aobasis.eval_guess_density(molecule, x[0], x[1], x[2]);
         }
+
+        bool supports_vectorized() const {return true;}
+
+        void operator()(const Vector<double*,3>& xvals, double* restrict fvals, int npts) const {
+            aobasis.eval_guess_density(molecule, npts, xvals[0], xvals[1], xvals[2], fvals);
+        }
         
         std::vector<coordT> special_points() const {return molecule.get_all_coords_vec();}
     };
@@ -150,6 +156,12 @@ namespace madness {
         double operator()(const coordT& x) const {
             return aofunc(x[0], x[1], x[2]);
         }
+
+        bool supports_vectorized() const {return true;}
+
+        void operator()(const Vector<double*,3>& xvals, double* restrict fvals, int npts) const {
+            aofunc(npts, xvals[0], xvals[1], xvals[2], fvals);
+        }
         
         std::vector<coordT> special_points() const {
             return std::vector<coordT>(1,aofunc.get_coords_vec());
@@ -173,6 +185,23 @@ namespace madness {
             return -atom.q * smoothed_potential(r*molecule.get_rcut()[iatom])
                 *molecule.get_rcut()[iatom];
         }
+
+        bool supports_vectorized() const {return true;}
+
+        void operator()(const Vector<double*,3>& xvals, double* restrict fvals, int npts) const {
+            const Atom& atom=molecule.get_atom(iatom);
+            const double rcut=molecule.get_rcut()[iatom];
+            const double* restrict x=xvals[0];
+            const double* restrict y=xvals[1];
+            const double* restrict z=xvals[2];
+            std::vector<double> r(npts);
+            for (int i=0; i<npts; ++i) {
+                const double dx=x[i]-atom.x, dy=y[i]-atom.y, dz=z[i]-atom.z;
+                r[i]=sqrt(dx*dx + dy*dy + dz*dz)*rcut;
+            }
+            smoothed_potential(npts, r.data(), fvals);
+            for (int i=0; i<npts; ++i) fvals[i]*=-atom.q*rcut;
+        }
         
         std::vector<coordT> special_points() const {
             return std::vector<coordT>(1,molecule.get_atom(iatom).get_coords());
@@ -372,6 +401,7 @@ namespace madness {
         int nv_factor;              ///< factor to multiply number of virtual orbitals with when automatically decreasing nvirt
         int vnucextra; // load balance parameter for nuclear pot.
         int loadbalparts = 2; // was 6
+        double exchange_memory;     ///< Memory budget (GB per process) for tiles of the exchange, 0 for no tiling
         
         
         // Next list for response code from a4v4
@@ -395,7 +425,7 @@ namespace madness {
             ar & xc_data & protocol_data;
             ar & gopt & gtol & gtest & gval & gprec & gmaxiter & ginitial_hessian & algopt & tdksprop
                 & nuclear_corrfac & psp_calc & print_dipole_matels & pure_ae & hessian & read_cphf
-                & purify_hessian & vnucextra & loadbalparts;
+                & purify_hessian & vnucextra & loadbalparts & exchange_memory;
         }
         
         CalculationParameters()
@@ -457,6 +487,7 @@ namespace madness {
             , nv_factor(1)
             , vnucextra(12)
             , loadbalparts(2)
+            , exchange_memory(0.0)
             , response(false)
             , response_freq(0.0)
             , response_axis(madness::vector_factory(true, true, true))
@@ -523,6 +554,9 @@ namespace madness {
                 else if (s == "nio") {
                     f >> nio;
                 }
+                else if (s == "exchange_memory") {
+                    f >> exchange_memory;
+                }
                 else if (s == "xc") {
                     char buf[1024];
                     f.getline(buf,sizeof(buf));
@@ -766,6 +800,8 @@ namespace madness {
             madness::print("   no. of io servers ", nio);
             madness::print("   vnuc load bal fac ", vnucextra);
             madness::print("      load bal parts ", loadbalparts);
+            if (exchange_memory > 0.0)
+                madness::print("  exchange tile (GB) ", exchange_memory);
             madness::print("     simulation cube ", -L, L);
             madness::print("        total charge ", charge);
             madness::print("            smearing ", smear);
@@ -865,7 +901,19 @@ namespace madness {
         double current_energy;
         //double esol;//etot;
         //double vacuo_energy;
+
+        /// BSH operators of make_bsh_operators(), sharing their Gaussian terms across orbitals and iterations
+        mutable std::shared_ptr< BSHOperatorFamily<3> > bsh_family;
+
+        /// completion of the last checkpoint written by save_mos()
+        std::shared_ptr< Future<bool> > mos_saved;
+
         SCF(World & world, const char *filename);
+
+        /// waits for the last checkpoint to reach the disk
+        ~SCF() {
+            if (mos_saved) mos_saved->get();
+        }
         
         template<std::size_t NDIM>
         void set_protocol(World & world, double thresh)
@@ -901,6 +949,8 @@ namespace madness {
             FunctionDefaults<NDIM>::set_project_randomize(false);
             FunctionDefaults<NDIM>::set_cubic_cell(-param.L, param.L);
             GaussianConvolution1DCache<double>::map.clear();
+            GaussianConvolution1DCache<double>::load(world, FunctionDefaults<NDIM>::get_k());
+            bsh_family.reset();
             double safety = 0.1;
             vtol = FunctionDefaults<NDIM>::get_thresh() * safety;
             coulop = poperatorT(CoulombOperatorPtr(world, param.lo, thresh));
@@ -926,6 +976,7 @@ namespace madness {
         
         bool is_spin_restricted() const {return param.spin_restricted;}
         
+        /// checkpoint the orbitals; the files are written in the background
         void save_mos(World& world);
         
         void load_mos(World& world);
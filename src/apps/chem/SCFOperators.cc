@@ -313,7 +313,8 @@ vecfuncT DNuclear::operator()(const vecfuncT& vket) const {
 
 
 Exchange::Exchange(World& world, const SCF* calc, const int ispin)
-        : world(world), small_memory_(true), same_(false) {
+        : world(world), small_memory_(true), same_(false),
+          tile_memory_(calc->param.exchange_memory) {
     if (ispin==0) { // alpha spin
         mo_ket=calc->amo;
         occ=calc->aocc;
@@ -327,7 +328,8 @@ Exchange::Exchange(World& world, const SCF* calc, const int ispin)
 }
 
 Exchange::Exchange(World& world, const Nemo* nemo, const int ispin)
-    : world(world), small_memory_(true), same_(false) {
+    : world(world), small_memory_(true), same_(false),
+      tile_memory_(nemo->get_calc()->param.exchange_memory) {
 
     if (ispin==0) { // alpha spin
         mo_ket=nemo->get_calc()->amo;
@@ -369,7 +371,9 @@ vecfuncT Exchange::operator()(const vecfuncT& vket) const {
         norm_tree(world, vket);
     }
 
-    if (small_memory_) {     // Smaller memory algorithm ... possible 2x saving using i-j sym
+    if (tile_memory_ > 0.0) {
+        apply_tiled(vket, tol, Kf);
+    } else if (small_memory_) {     // Smaller memory algorithm ... possible 2x saving using i-j sym
         for(int i=0; i<nocc; ++i){
             if(occ[i] > 0.0){
                 vecfuncT psif = mul_sparse(world, mo_bra[i], vket, tol); /// was vtol
@@ -428,6 +432,84 @@ vecfuncT Exchange::operator()(const vecfuncT& vket) const {
 
 }
 
+void Exchange::apply_tiled(const vecfuncT& vket, const double tol, vecfuncT& Kf) const {
+    const bool same = this->same();
+    const int nocc = mo_bra.size();
+    const int nf = vket.size();
+
+    // Screen the pairs by their differential overlap int |bra_i| |ket_j|,
+    // which bounds the charge of the pair density bra_i ket_j
+    vecfuncT absbra=copy(world,mo_bra);
+    vecfuncT absket=copy(world,vket);
+    for (int i=0; i<nocc; ++i) absbra[i].abs(false);
+    for (int j=0; j<nf; ++j) absket[j].abs(false);
+    world.gop.fence();
+    const Tensor<double> overlap=matrix_inner(world,absbra,absket);
+    absbra.clear();
+    absket.clear();
+
+    std::vector< std::pair<int,int> > pairs;
+    for (int i=0; i<nocc; ++i) {
+        const int jtop = same ? i+1 : nf;
+        for (int j=0; j<jtop; ++j) {
+            const bool used = (occ[i] > 0.0) or (same and occ[j] > 0.0);
+            if (used and overlap(i,j) > 0.1*tol) pairs.push_back(std::make_pair(i,j));
+        }
+    }
+
+    // Each pair holds its density, its potential and the products with the
+    // ket orbitals, which are estimated from the size of the orbitals
+    double fsize=0.0;
+    for (int i=0; i<nocc; ++i) fsize+=mo_bra[i].size();
+    for (int j=0; j<nf; ++j) fsize+=vket[j].size();
+    fsize/=(nocc+nf);
+    const double pairbytes=3.0*2.0*fsize*sizeof(double)/world.size();
+    const std::size_t ntile=std::max(std::size_t(1),std::size_t(tile_memory_*1.e9/pairbytes));
+
+    if (world.rank()==0) print("exchange: pairs",pairs.size(),"of",
+            same ? nocc*(nocc+1)/2 : nocc*nf, "in tiles of",ntile);
+
+    for (std::size_t ilo=0; ilo<pairs.size(); ilo+=ntile) {
+        const std::size_t ihi=std::min(pairs.size(),ilo+ntile);
+
+        vecfuncT psif;
+        for (std::size_t p=ilo; p<ihi; ++p) {
+            psif.push_back(mul_sparse(mo_bra[pairs[p].first], vket[pairs[p].second], tol, false));
+        }
+        world.gop.fence();
+        truncate(world, psif);
+        psif = apply(world, *poisson.get(), psif);
+        truncate(world, psif, tol);
+        reconstruct(world, psif);
+        norm_tree(world, psif);
+
+        // K|j> += occ_i |i> (ij|, and K|i> += occ_j |j> (ji| by symmetry
+        vecfuncT psipsif;
+        std::vector<int> dest;
+        std::vector<double> fac;
+        for (std::size_t p=ilo; p<ihi; ++p) {
+            const int i=pairs[p].first, j=pairs[p].second;
+            if (occ[i] > 0.0) {
+                psipsif.push_back(mul_sparse(psif[p-ilo], mo_ket[i], tol, false));
+                dest.push_back(j);
+                fac.push_back(occ[i]);
+            }
+            if (same && i != j && occ[j] > 0.0) {
+                psipsif.push_back(mul_sparse(psif[p-ilo], mo_ket[j], tol, false));
+                dest.push_back(i);
+                fac.push_back(occ[j]);
+            }
+        }
+        world.gop.fence();
+        psif.clear();
+        compress(world, psipsif);
+        for (std::size_t p=0; p<psipsif.size(); ++p) {
+            Kf[dest[p]].gaxpy(1.0, psipsif[p], fac[p], false);
+        }
+        world.gop.fence();
+    }
+}
+
 /// custom ctor with information about the XC functional
 XCOperator::XCOperator(World& world, std::string xc_data, const bool spin_polarized,
         const real_function_3d& arho, const real_function_3d& brho)
@@ -332,7 +332,8 @@ class Exchange {
 public:
 
     /// default ctor
-    Exchange(World& world) : world(world), small_memory_(true), same_(false) {};
+    Exchange(World& world) : world(world), small_memory_(true), same_(false),
+            tile_memory_(0.0) {};
 
     /// ctor with a conventional calculation
     Exchange(World& world, const SCF* calc, const int ispin);
@@ -389,11 +390,30 @@ public:
         return *this;
     }
 
+    /// memory budget in GB per process for the orbital pairs of one tile
+
+    /// if positive the exchange is computed in tiles of (i,j) pairs that
+    /// fit into this budget, skipping pairs with negligible differential
+    /// overlap; this overrides small_memory. Zero disables the tiling.
+    double tile_memory() const {return tile_memory_;}
+    Exchange& tile_memory(const double gb) {
+        tile_memory_=gb;
+        return *this;
+    }
+
 private:
 
+    /// compute the exchange in screened tiles of orbital pairs
+
+    /// @param[in]  vket    the orbitals |i> that the operator is applied on
+    /// @param[in]  tol     threshold for the sparse multiplications and the screening
+    /// @param[in,out]  Kf  the result in compressed form, K|i> is accumulated into it
+    void apply_tiled(const vecfuncT& vket, const double tol, vecfuncT& Kf) const;
+
     World& world;
     bool small_memory_;
     bool same_;
+    double tile_memory_;        ///< memory budget per tile in GB per process, 0 for no tiling
     vecfuncT mo_bra, mo_ket;    ///< MOs for bra and ket
     Tensor<double> occ;
     std::shared_ptr<real_convolution_3d> poisson;
@@ -327,6 +327,19 @@ double smoothed_potential(double r) {
 }
 
 
+/// Smoothed 1/r potential at \c n points
+
+/// Same as the scalar version.  The far field 1/r, which is the most
+/// common case, is computed for all points in a loop that vectorizes;
+/// the few points within the smoothing radius are then corrected.
+void smoothed_potential(int n, const double* restrict r, double* restrict u) {
+    for (int i=0; i<n; ++i) u[i] = 1.0/r[i];
+    for (int i=0; i<n; ++i) {
+        if (r[i] <= 7.0) u[i] = smoothed_potential(r[i]);
+    }
+}
+
+
 /// Derivative of the regularized 1/r potential
 
 /// dV/dx = (x/r) * du(r/c)/(c*c)
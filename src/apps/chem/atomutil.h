@@ -36,6 +36,7 @@
 #ifndef MADNESS_CHEM_ATOMUTIL_H__INCLUDED
 #define MADNESS_CHEM_ATOMUTIL_H__INCLUDED
 
+#include <madness/madness_config.h>
 #include <string>
 
 /// \file atomutil.h
@@ -75,6 +76,7 @@ bool check_if_pseudo_atom(const std::string& symbol);
 
 double smoothing_parameter(double Z, double eprec);
 double smoothed_potential(double r);
+void smoothed_potential(int n, const double* restrict r, double* restrict u);
 double dsmoothed_potential(double r);
 double d2smoothed_potential(double r);
 double smoothed_density(double r);
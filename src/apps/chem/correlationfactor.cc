@@ -36,6 +36,7 @@
 
 #include <chem/correlationfactor.h>
 #include <chem/SCF.h>
+#include <madness/tensor/vmath.h>
 
 namespace madness{
 
@@ -100,4 +101,70 @@ namespace madness{
 			return ncf_ptr();
 		}
 	}
+
+	void GaussSlater::Sr_div_S(int npt, const double* restrict r, const double& Z,
+			double* restrict result) const {
+		std::vector<double> e(npt), g(npt);
+		for (int i=0; i<npt; ++i) {
+			const double Zr=r[i]*Z;
+			e[i]=-Zr;
+			g[i]=-Zr*Zr;
+		}
+		vdExp(npt,e.data(),e.data());
+		vdExp(npt,g.data(),g.data());
+		for (int i=0; i<npt; ++i) {
+			const double Zr=r[i]*Z;
+			const double num=Z*(2.0*Zr*g[i]-e[i]);
+			const double denom=1.0+e[i]-g[i];
+			result[i]=num/denom;
+		}
+	}
+
+	void GaussSlater::Spp_div_S(int npt, const double* restrict r, const double& Z,
+			double* restrict result) const {
+		std::vector<double> e(npt), g(npt);
+		for (int i=0; i<npt; ++i) {
+			const double rho=Z*r[i];
+			e[i]=-rho;
+			g[i]=-rho*rho;
+		}
+		vdExp(npt,e.data(),e.data());
+		vdExp(npt,g.data(),g.data());
+		for (int i=0; i<npt; ++i) {
+			const double rho=Z*r[i];
+			const double term1=-Z/r[i]*(1.0-g[i]);
+			const double term2=-g[i]*Z*Z*(3.0-2.0*rho*rho) - Z*Z/2.0*e[i];
+			const double S_inv=e[i]+(1.0-g[i]);
+			const double series=Z*Z*(-3.5 - 4.0*rho + 6.0*rho*rho + 12.0*rho*rho*rho);
+			result[i]=(rho<1.e-4) ? series : (term1+term2)/S_inv;
+		}
+	}
+
+	void Slater::Sr_div_S(int npt, const double* restrict r, const double& Z,
+			double* restrict result) const {
+		const double a=a_param();
+		std::vector<double> e(npt);
+		for (int i=0; i<npt; ++i) e[i]=a*r[i]*Z;
+		vdExp(npt,e.data(),e.data());
+		for (int i=0; i<npt; ++i) result[i]=-a*Z/(1.0+(a-1.0)*e[i]);
+	}
+
+	void Slater::Spp_div_S(int npt, const double* restrict r, const double& Z,
+			double* restrict result) const {
+		const double a=a_param();
+		const double O0=1.0-(1.5*a);
+		const double O1=(a-1.0)*(a-1.0)*Z;
+		const double O2=(1.0/12.0 * (a-1.0)*(12.0+a*(5*a-18.0)))*Z*Z;
+		std::vector<double> e(npt);
+		for (int i=0; i<npt; ++i) e[i]=-a*r[i]*Z;
+		vdExp(npt,e.data(),e.data());
+		for (int i=0; i<npt; ++i) {
+			const double earz=e[i];
+			const double num=Z*(-earz + a*earz - (a-1.0) - 0.5*a*a*r[i]*Z*earz);
+			const double denom=(r[i]*earz + (a-1.0) * r[i]);
+			const double series=Z*Z*(O0 + O1*r[i] + O2*r[i]*r[i]);
+			result[i]=(r[i]*Z<1.e-4) ? series : num/denom;
+		}
+	}
+
 }
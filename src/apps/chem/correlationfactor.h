@@ -243,6 +243,15 @@ private:
 	///				by the correlation factor minus the nuclear potential
 	virtual double Spp_div_S(const double& r, const double& Z) const = 0;
 
+	/// the regularized potential -S"/S - Z/r at \c npt distances \c r
+
+	/// derived classes may override this with a version that uses the
+	/// vector exponential
+	virtual void Spp_div_S(int npt, const double* restrict r, const double& Z,
+			double* restrict result) const {
+		for (int i=0; i<npt; ++i) result[i]=Spp_div_S(r[i],Z);
+	}
+
 public:
 
 	/// first derivative of the NCF with respect to the relative distance rho
@@ -255,6 +264,15 @@ public:
 	/// \f]
 	virtual double Sr_div_S(const double& r, const double& Z) const = 0;
 
+	/// first derivative of the NCF divided by the NCF at \c npt distances \c r
+
+	/// derived classes may override this with a version that uses the
+	/// vector exponential
+	virtual void Sr_div_S(int npt, const double* restrict r, const double& Z,
+			double* restrict result) const {
+		for (int i=0; i<npt; ++i) result[i]=Sr_div_S(r[i],Z);
+	}
+
 	/// second derivative of the NCF with respect to the relative distance rho
     /// \f[
     ///     \frac{\partial^2 S(\rho)}{\partial \rho^2} \frac{1}{S(\rho)}
@@ -355,6 +373,22 @@ public:
 #endif
 	}
 
+	/// the factor f of the smoothed unit vector f*xyz at \c npt distances \c r
+
+	/// same as smoothed_unitvec with the default smoothing
+	void smoothed_unitvec_factor(int npt, const double* restrict r,
+			double* restrict f) const {
+		const double cutoff=molecule.get_eprec();
+		for (int i=0; i<npt; ++i) {
+			const double xi=r[i]/cutoff;
+			const double xi2=xi*xi;
+			const double xi3=xi*xi*xi;
+			const double nu22=0.5 + 1./64.*(105* xi - 175 *xi3 + 147* xi2*xi3 - 45* xi3*xi3*xi);
+			const double kk=(r[i]>cutoff) ? 1.0 : 2.*nu22-1.0;
+			f[i]=kk/r[i];
+		}
+	}
+
 	/// derivative of smoothed unit vector wrt the *electronic* coordinate
 
 	/// note the sign change for exchanging nuclear and electronic coordinates
@@ -479,6 +513,29 @@ public:
 			}
 			return result;
 		}
+
+		bool supports_vectorized() const {return true;}
+
+		void operator()(const Vector<double*,3>& xvals, double* restrict fvals,
+				int npts) const {
+			std::vector<double> d(npts), r(npts), s(npts), f(npts);
+			for (int j=0; j<npts; ++j) fvals[j]=0.0;
+			for (int i=0; i<ncf->molecule.natom(); ++i) {
+				const Atom& atom=ncf->molecule.get_atom(i);
+				const coord_3d A=atom.get_coords();
+				for (int j=0; j<npts; ++j) {
+					const double dx=xvals[0][j]-A[0];
+					const double dy=xvals[1][j]-A[1];
+					const double dz=xvals[2][j]-A[2];
+					r[j]=sqrt(dx*dx + dy*dy + dz*dz);
+					d[j]=xvals[axis][j]-A[axis];
+				}
+				ncf->Sr_div_S(npts,r.data(),atom.q,s.data());
+				ncf->smoothed_unitvec_factor(npts,r.data(),f.data());
+				for (int j=0; j<npts; ++j) fvals[j]-=s[j]*f[j]*d[j];
+			}
+		}
+
 		std::vector<coord_3d> special_points() const {
 			return ncf->molecule.get_all_coords_vec();
 		}
@@ -566,6 +623,25 @@ public:
 			}
 			return result;
 		}
+
+		bool supports_vectorized() const {return true;}
+
+		void operator()(const Vector<double*,3>& xvals, double* restrict fvals,
+				int npts) const {
+			std::vector<double> r(npts), s(npts);
+			for (int j=0; j<npts; ++j) fvals[j]=0.0;
+			for (int i=0; i<ncf->molecule.natom(); ++i) {
+				const Atom& atom=ncf->molecule.get_atom(i);
+				for (int j=0; j<npts; ++j) {
+					const double dx=xvals[0][j]-atom.x;
+					const double dy=xvals[1][j]-atom.y;
+					const double dz=xvals[2][j]-atom.z;
+					r[j]=sqrt(dx*dx + dy*dy + dz*dz);
+				}
+				ncf->Spp_div_S(npts,r.data(),atom.q,s.data());
+				for (int j=0; j<npts; ++j) fvals[j]+=s[j];
+			}
+		}
 		std::vector<coord_3d> special_points() const {
 			return ncf->molecule.get_all_coords_vec();
 		}
@@ -1008,6 +1084,12 @@ private:
         return num/denom;
     }
 
+    void Sr_div_S(int npt, const double* restrict r, const double& Z,
+            double* restrict result) const;
+
+    void Spp_div_S(int npt, const double* restrict r, const double& Z,
+            double* restrict result) const;
+
     double Srr_div_S(const double& r, const double& Z) const {
         const double Zr=r*Z;
         const double eA=exp(-Zr);
@@ -1350,6 +1432,12 @@ private:
 	    return -a*Z/(1.0+(a-1.0)*exp(a*r*Z));
 	}
 
+	void Sr_div_S(int npt, const double* restrict r, const double& Z,
+			double* restrict result) const;
+
+	void Spp_div_S(int npt, const double* restrict r, const double& Z,
+			double* restrict result) const;
+
     /// second derivative of the correlation factor wrt (r-R_A)
 
     /// \f[
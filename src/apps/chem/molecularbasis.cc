@@ -32,9 +32,208 @@
 */
 
 #include <chem/molecularbasis.h>
+#include <madness/tensor/vmath.h>
 
 namespace madness {
 
+void ContractedGaussianShell::eval_radial(int npt, const double* restrict rsq, double* restrict R) const {
+    std::vector<double> e(npt);
+    std::vector<int> index;
+    for (int j=0; j<npt; ++j) R[j] = 0.0;
+    for (unsigned int i=0; i<coeff.size(); ++i) {
+        // Only exponentiate the points where this primitive is significant,
+        // 27.6 = log(1e12)
+        const double a = expnt[i], c = coeff[i];
+        const double rsqcut = std::min(27.6/a, rsqmax);
+        int m = 0;
+        for (int j=0; j<npt; ++j) m += (rsq[j] < rsqcut);
+        if (m == 0) continue;
+
+        if (m == npt) {
+            for (int j=0; j<npt; ++j) e[j] = -a*rsq[j];
+            vdExp(npt, e.data(), e.data());
+            for (int j=0; j<npt; ++j) R[j] += c*e[j];
+        }
+        else {
+            index.resize(m);
+            m = 0;
+            for (int j=0; j<npt; ++j) {
+                if (rsq[j] < rsqcut) {
+                    index[m] = j;
+                    e[m++] = -a*rsq[j];
+                }
+            }
+            vdExp(m, e.data(), e.data());
+            for (int j=0; j<m; ++j) R[index[j]] += c*e[j];
+        }
+    }
+}
+
+void ContractedGaussianShell::eval(int npt, const double* rsq, const double* x, const double* y,
+                                   const double* z, double* restrict bf) const {
+    std::vector<double> Rv(npt);
+    double* restrict R = Rv.data();
+    eval_radial(npt, rsq, R);
+    for (int j=0; j<npt; ++j) {
+        if (fabs(R[j]) < 1e-12) R[j] = 0.0;
+    }
+
+    double* restrict b0 = bf;
+    double* restrict b1 = bf + npt;
+    double* restrict b2 = bf + 2*npt;
+    switch (type) {
+    case 0:
+        for (int j=0; j<npt; ++j) b0[j] = R[j];
+        break;
+    case 1:
+        for (int j=0; j<npt; ++j) {
+            b0[j] = R[j]*x[j];
+            b1[j] = R[j]*y[j];
+            b2[j] = R[j]*z[j];
+        }
+        break;
+    case 2:
+      {
+        double* restrict b3 = bf + 3*npt;
+        double* restrict b4 = bf + 4*npt;
+        double* restrict b5 = bf + 5*npt;
+        for (int j=0; j<npt; ++j) {
+            const double Rx = R[j]*x[j], Ry = R[j]*y[j];
+            b0[j] = Rx*x[j];
+            b1[j] = Rx*y[j];
+            b2[j] = Rx*z[j];
+            b3[j] = Ry*y[j];
+            b4[j] = Ry*z[j];
+            b5[j] = R[j]*z[j]*z[j];
+        }
+      }
+        break;
+    case 3:
+      {
+        double* restrict b3 = bf + 3*npt;
+        double* restrict b4 = bf + 4*npt;
+        double* restrict b5 = bf + 5*npt;
+        double* restrict b6 = bf + 6*npt;
+        double* restrict b7 = bf + 7*npt;
+        double* restrict b8 = bf + 8*npt;
+        double* restrict b9 = bf + 9*npt;
+        for (int j=0; j<npt; ++j) {
+            const double Rx = R[j]*x[j], Ry = R[j]*y[j];
+            const double Rxx = Rx*x[j], Ryy = Ry*y[j];
+            b0[j] = Rxx*x[j];
+            b1[j] = Rxx*y[j];
+            b2[j] = Rxx*z[j];
+            b3[j] = Rx*y[j]*y[j];
+            b4[j] = Rx*y[j]*z[j];
+            b5[j] = Rx*z[j]*z[j];
+            b6[j] = Ryy*y[j];
+            b7[j] = Ryy*z[j];
+            b8[j] = Ry*z[j]*z[j];
+            b9[j] = R[j]*z[j]*z[j]*z[j];
+        }
+      }
+        break;
+    default:
+        throw "UNKNOWN ANGULAR MOMENTUM";
+    }
+}
+
+void AtomicBasis::eval_guess_density(int npt, const double* x, const double* y, const double* z,
+                                     bool pspat, double* restrict rho) const {
+    MADNESS_ASSERT(has_guess_info());
+
+    std::vector<double> rsqv(npt);
+    for (int j=0; j<npt; ++j) rsqv[j] = x[j]*x[j] + y[j]*y[j] + z[j]*z[j];
+    int m = 0;
+    for (int j=0; j<npt; ++j) m += (rsqv[j] <= rmaxsq);
+    if (m == 0) return;
+
+    // Gather the points within range of the most diffuse shell unless
+    // that is all of them
+    std::vector<int> index;
+    std::vector<double> xs, ys, zs, rsqs;
+    const double *xp = x, *yp = y, *zp = z, *rsq = rsqv.data();
+    if (m < npt) {
+        index.resize(m);
+        xs.resize(m);
+        ys.resize(m);
+        zs.resize(m);
+        rsqs.resize(m);
+        m = 0;
+        for (int j=0; j<npt; ++j) {
+            if (rsqv[j] <= rmaxsq) {
+                index[m] = j;
+                xs[m] = x[j];
+                ys[m] = y[j];
+                zs[m] = z[j];
+                rsqs[m++] = rsqv[j];
+            }
+        }
+        xp = xs.data();
+        yp = ys.data();
+        zp = zs.data();
+        rsq = rsqs.data();
+    }
+
+    std::vector<double> bf(numbf*m);
+    double* p = bf.data();
+    for (unsigned int i=0; i<g.size(); ++i) {
+        g[i].eval(m, rsq, xp, yp, zp, p);
+        p += g[i].nbf()*m;
+    }
+
+    // rho(j) = sum(i,k) bf(i,j) d(i,k) bf(k,j) with the points innermost
+    const double* d = pspat ? dmatpsp.ptr() : dmat.ptr();
+    std::vector<double> sumv(m, 0.0), sumjv(m);
+    double* restrict sum = sumv.data();
+    double* restrict sumj = sumjv.data();
+    for (int i=0; i<numbf; ++i, d+=numbf) {
+        for (int j=0; j<m; ++j) sumj[j] = 0.0;
+        for (int k=0; k<numbf; ++k) {
+            const double dik = d[k];
+            const double* restrict bk = &bf[k*m];
+            for (int j=0; j<m; ++j) sumj[j] += dik*bk[j];
+        }
+        const double* restrict bi = &bf[i*m];
+        for (int j=0; j<m; ++j) sum[j] += bi[j]*sumj[j];
+    }
+    if (m == npt) {
+        for (int j=0; j<m; ++j) rho[j] += sum[j];
+    }
+    else {
+        for (int j=0; j<m; ++j) rho[index[j]] += sum[j];
+    }
+}
+
+void AtomicBasisFunction::operator()(int npt, const double* x, const double* y, const double* z,
+                                     double* restrict f) const {
+    std::vector<double> xs(npt), ys(npt), zs(npt), rsq(npt), bf(nbf*npt);
+    for (int j=0; j<npt; ++j) {
+        xs[j] = x[j] - xx;
+        ys[j] = y[j] - yy;
+        zs[j] = z[j] - zz;
+        rsq[j] = xs[j]*xs[j] + ys[j]*ys[j] + zs[j]*zs[j];
+    }
+    shell.eval(npt, rsq.data(), xs.data(), ys.data(), zs.data(), bf.data());
+    const double* b = &bf[ibf*npt];
+    for (int j=0; j<npt; ++j) f[j] = b[j];
+}
+
+void AtomicBasisSet::eval_guess_density(const Molecule& molecule, int npt, const double* x,
+                                        const double* y, const double* z, double* restrict rho) const {
+    std::vector<double> xs(npt), ys(npt), zs(npt);
+    for (int j=0; j<npt; ++j) rho[j] = 0.0;
+    for (int i=0; i<molecule.natom(); ++i) {
+        const Atom& atom = molecule.get_atom(i);
+        for (int j=0; j<npt; ++j) {
+            xs[j] = x[j] - atom.x;
+            ys[j] = y[j] - atom.y;
+            zs[j] = z[j] - atom.z;
+        }
+        ag[atom.atomic_number].eval_guess_density(npt, xs.data(), ys.data(), zs.data(), atom.pseudo_atom, rho);
+    }
+}
+
 std::ostream& operator<<(std::ostream& s, const ContractedGaussianShell& c) {
     static const char* tag[] = {"s","p","d","f","g"};
     char buf[32768];
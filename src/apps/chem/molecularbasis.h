@@ -117,6 +117,13 @@ public:
     }
 
 
+    /// Evaluates the radial part of the contracted function at \c npt points
+
+    /// Same as the scalar version, one primitive at a time over all points
+    /// using the vector exponential.
+    void eval_radial(int npt, const double* restrict rsq, double* restrict R) const;
+
+
     /// Evaluates the entire shell returning the incremented result pointer
     double* eval(double rsq, double x, double y, double z, double* bf) const {
         double R = eval_radial(rsq);
@@ -166,6 +173,14 @@ public:
     }
 
 
+    /// Evaluates the entire shell at \c npt points
+
+    /// \c x, \c y and \c z are relative to the center and \c rsq=x*x+y*y+z*z.
+    /// On return \c bf[i*npt+j] holds function \c i of the shell at point \c j.
+    void eval(int npt, const double* rsq, const double* x, const double* y,
+              const double* z, double* restrict bf) const;
+
+
     /// Returns the shell angular momentum
     int angular_momentum() const {
         return type;
@@ -303,6 +318,12 @@ public:
         return sum;
     }
 
+    /// Adds the guess atomic density at \c npt points to \c rho
+
+    /// \c x, \c y and \c z are relative to the atomic center.
+    void eval_guess_density(int npt, const double* x, const double* y, const double* z,
+                            bool pspat, double* restrict rho) const;
+
     /// Return shell that contains basis function ibf and also return index of function in the shell
     const ContractedGaussianShell& get_shell_from_basis_function(int ibf, int& ibf_in_shell) const {
         int n=0;
@@ -421,6 +442,10 @@ public:
         return bf[ibf];
     }
 
+    /// Evaluates the function at \c npt points
+    void operator()(int npt, const double* x, const double* y, const double* z,
+                    double* restrict f) const;
+
     void print_me(std::ostream& s) const;
 
     const ContractedGaussianShell& get_shell() const {
@@ -594,6 +619,10 @@ public:
         return sum;
     }
 
+    /// Evaluates the guess density at \c npt points
+    void eval_guess_density(const Molecule& molecule, int npt, const double* x,
+                            const double* y, const double* z, double* restrict rho) const;
+
     bool is_supported(int atomic_number) const {
         return ag[atomic_number].nbf() > 0;
     }
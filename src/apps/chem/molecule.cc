@@ -773,6 +773,26 @@ double Molecule::nuclear_attraction_potential(double x, double y, double z) cons
     return sum;
 }
 
+void Molecule::nuclear_attraction_potential(int npt, const double* x, const double* y,
+                                            const double* z, double* restrict v) const {
+    // Same as the pointwise version with the loops over atoms and points
+    // exchanged, so that the inner loops run over contiguous points
+    std::vector<double> r(npt), u(npt);
+    for (int j=0; j<npt; ++j) v[j] = field[0] * x[j] + field[1] * y[j] + field[2] * z[j];
+    for (unsigned int i=0; i<atoms.size(); ++i) {
+        if (atoms[i].pseudo_atom) continue;
+
+        const double xx = atoms[i].x, yy = atoms[i].y, zz = atoms[i].z;
+        const double rc = rcut[i], qrc = atoms[i].q*rcut[i];
+        for (int j=0; j<npt; ++j) {
+            const double dx = x[j]-xx, dy = y[j]-yy, dz = z[j]-zz;
+            r[j] = sqrt(dx*dx + dy*dy + dz*dz)*rc;
+        }
+        smoothed_potential(npt, r.data(), u.data());
+        for (int j=0; j<npt; ++j) v[j] -= qrc*u[j];
+    }
+}
+
 double Molecule::atomic_attraction_potential(int iatom, double x, double y,
         double z) const {
 
@@ -305,6 +305,10 @@ public:
     /// nuclear attraction potential for the whole molecule
     double nuclear_attraction_potential(double x, double y, double z) const;
 
+    /// nuclear attraction potential for the whole molecule at \c npt points
+    void nuclear_attraction_potential(int npt, const double* x, const double* y,
+                                      const double* z, double* restrict v) const;
+
     /// nuclear attraction potential for a specific atom in the molecule
     double atomic_attraction_potential(int iatom, double x, double y, double z) const;
 
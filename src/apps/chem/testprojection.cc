@@ -0,0 +1,156 @@
+/*
+  This file is part of MADNESS.
+  
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+  
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+  
+  For more information please contact:
+  
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+  
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+/// \file testprojection.cc
+/// \brief Checks and times the batched evaluation of the chemistry functors
+
+/// Each functor is projected twice, once through its batched interface and
+/// once point by point through a wrapper that hides it.  The two results
+/// must agree and the time per box of each projection is printed.
+
+#include <madness/mra/mra.h>
+#include <chem/molecule.h>
+#include <chem/molecularbasis.h>
+#include <chem/potentialmanager.h>
+#include <chem/correlationfactor.h>
+#include <chem/SCF.h>
+
+using namespace madness;
+
+typedef std::shared_ptr< FunctionFunctorInterface<double,3> > functorT;
+
+/// Hides the batched interface of a functor so that it is evaluated point by point
+class Pointwise : public FunctionFunctorInterface<double,3> {
+    functorT f;
+public:
+    Pointwise(const functorT& f) : f(f) {}
+
+    double operator()(const coord_3d& x) const {
+        return (*f)(x);
+    }
+
+    std::vector<coord_3d> special_points() const {
+        return f->special_points();
+    }
+
+    Level special_level() {
+        return f->special_level();
+    }
+};
+
+/// Projects \c f both ways, returns 0 if the results agree
+int compare(World& world, const char* name, const functorT& f) {
+    functorT pf(new Pointwise(f));
+
+    world.gop.fence();
+    double start = wall_time();
+    real_function_3d a = real_factory_3d(world).functor(pf);
+    const double tpoint = wall_time() - start;
+
+    start = wall_time();
+    real_function_3d b = real_factory_3d(world).functor(f);
+    const double tbatch = wall_time() - start;
+
+    const double norm = a.norm2();
+    const double err = (a - b).norm2()/(norm > 0.0 ? norm : 1.0);
+    const std::size_t nbox = a.tree_size();
+    const bool ok = err < 1e-12;
+    if (world.rank() == 0) {
+        printf("%-28s boxes %7lu   pointwise %8.2f us/box   batched %8.2f us/box   speedup %5.2f   err %.1e %s\n",
+               name, (unsigned long) nbox, tpoint/nbox*1e6, tbatch/nbox*1e6, tpoint/tbatch, err,
+               ok ? "OK" : "FAILED");
+    }
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    initialize(argc, argv);
+    World world(SafeMPI::COMM_WORLD);
+    startup(world, argc, argv);
+
+    FunctionDefaults<3>::set_k(8);
+    FunctionDefaults<3>::set_thresh(1e-6);
+    FunctionDefaults<3>::set_cubic_cell(-20.0, 20.0);
+
+    // Water
+    Molecule molecule;
+    molecule.add_atom( 0.0,  0.0, -0.1294,   8.0, 8);
+    molecule.add_atom( 0.0,  1.4941,  1.0274, 1.0, 1);
+    molecule.add_atom( 0.0, -1.4941,  1.0274, 1.0, 1);
+    molecule.set_eprec(1e-4);
+
+    AtomicBasisSet aobasis;
+    aobasis.read_file("sto-3g");
+
+    int nfail = 0;
+    try {
+        nfail += compare(world, "MolecularGuessDensity",
+                         functorT(new MolecularGuessDensityFunctor(molecule, aobasis)));
+        for (int i=0; i<aobasis.nbf(molecule); ++i) {
+            if (i != 1 && i != 3) continue; // an s and a p function on oxygen
+            nfail += compare(world, i == 1 ? "AtomicBasis (s)" : "AtomicBasis (p)",
+                             functorT(new AtomicBasisFunctor(aobasis.get_atomic_basis_function(molecule, i))));
+        }
+        nfail += compare(world, "AtomicAttraction",
+                         functorT(new AtomicAttractionFunctor(molecule, 0)));
+        nfail += compare(world, "MolecularPotential",
+                         functorT(new MolecularPotentialFunctor(molecule)));
+
+        Slater slater(world, molecule, 1.5);
+        nfail += compare(world, "Slater U1",
+                         functorT(new NuclearCorrelationFactor::U1_functor(&slater, 2)));
+        nfail += compare(world, "Slater U2",
+                         functorT(new NuclearCorrelationFactor::U2_functor(&slater)));
+
+        GaussSlater gaussslater(world, molecule);
+        nfail += compare(world, "GaussSlater U1",
+                         functorT(new NuclearCorrelationFactor::U1_functor(&gaussslater, 2)));
+        nfail += compare(world, "GaussSlater U2",
+                         functorT(new NuclearCorrelationFactor::U2_functor(&gaussslater)));
+    }
+    catch (const SafeMPI::Exception& e) {
+        print(e);
+        error("caught an MPI exception");
+    }
+    catch (const madness::MadnessException& e) {
+        print(e);
+        error("caught a MADNESS exception");
+    }
+    catch (const char* s) {
+        print(s);
+        error("caught a string exception");
+    }
+
+    world.gop.fence();
+    finalize();
+    return nfail;
+}
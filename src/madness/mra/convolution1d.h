@@ -41,7 +41,14 @@
 #include <madness/mra/twoscale.h>
 #include <madness/tensor/aligned.h>
 #include <madness/tensor/tensor_lapack.h>
+#include <madness/world/MADworld.h>
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
 
 /// \file mra/convolution1d.h
 /// \brief Compuates most matrix elements over 1D operators (including Gaussians)
@@ -171,6 +178,10 @@ namespace madness {
         // norms for modified NS form
         double N_up, N_diff, N_F;               ///< the norms according to Beylkin 2008, Eq. (21) ff
 
+        /// default ctor, for deserialization only
+        ConvolutionData1D()
+            : Rnorm(0.0), Tnorm(0.0), Rnormf(0.0), Tnormf(0.0), NSnormf(0.0)
+            , N_up(0.0), N_diff(0.0), N_F(0.0) {}
 
         /// ctor for NS form
         /// make the operator matrices r^n and \uparrow r^(n-1)
@@ -246,6 +257,13 @@ namespace madness {
                 }
             }
         }
+
+        template <typename Archive>
+        void serialize(Archive& ar) {
+            ar & R & T & RU & RVT & TU & TVT & Rs & Ts
+               & Rnorm & Tnorm & Rnormf & Tnormf & NSnormf
+               & N_up & N_diff & N_F;
+        }
     };
 
     /// Provides the common functionality/interface of all 1D convolutions
@@ -870,6 +888,155 @@ namespace madness {
             }
             return it->second;
         }
+
+        /// Version of the on-disk format written by save()
+        static const int disk_version = 1;
+
+        /// Returns the name of the on-disk cache from \c MAD_CONVOLUTION_CACHE, or empty if unset
+        static std::string disk_filename() {
+            const char* name = getenv("MAD_CONVOLUTION_CACHE");
+            return name ? std::string(name) : std::string();
+        }
+
+        /// Collectively loads the operator blocks in the on-disk cache
+
+        /// Rank 0 reads the file and broadcasts it once; every process
+        /// then inserts the rnlp and nonstandard blocks into the
+        /// operators of this cache, creating the operators as needed.
+        /// Blocks already cached are left alone.  Entries are keyed by
+        /// (k, exponent, m, periodic, level, displacement), which fully
+        /// determine their values, so the file may be shared between
+        /// jobs.  A missing file, or one written with another format
+        /// version or scalar type, is ignored.
+        /// @param[in]  k   if non-negative only load operators of this wavelet order
+        /// @return the number of blocks read
+        static std::size_t load(World& world, int k=-1, const std::string& filename=disk_filename()) {
+            if (filename.empty()) return 0;
+            std::vector<unsigned char> buf;
+            std::size_t nbyte = 0;
+            if (world.rank() == 0) {
+                read_file(filename, buf);
+                nbyte = buf.size();
+            }
+            world.gop.broadcast(nbyte, 0);
+            if (nbyte == 0) return 0;
+            buf.resize(nbyte);
+            world.gop.broadcast(&buf[0], nbyte, 0);
+            return insert(buf, k);
+        }
+
+        /// Collectively saves the blocks cached by rank 0 to the on-disk cache
+
+        /// Rank 0 merges its blocks with those already in the file and
+        /// replaces the file atomically (write then rename), so that
+        /// concurrent jobs sharing the file see either version.  Blocks
+        /// computed only on other processes are not saved.
+        static void save(World& world, const std::string& filename=disk_filename()) {
+            if (filename.empty()) return;
+            world.gop.fence();
+            if (world.rank() == 0) {
+                std::vector<unsigned char> old;
+                read_file(filename, old);
+                if (!old.empty()) insert(old, -1);
+
+                archive::BufferOutputArchive count;
+                store(count);
+                std::vector<unsigned char> buf(count.size());
+                archive::BufferOutputArchive ar(&buf[0], buf.size());
+                store(ar);
+
+                const std::string tmpname = filename + ".tmp." + std::to_string(getpid());
+                {
+                    std::ofstream f(tmpname.c_str(), std::ios::binary);
+                    f.write(reinterpret_cast<const char*>(&buf[0]), buf.size());
+                    if (!f) MADNESS_EXCEPTION("GaussianConvolution1DCache: failed writing cache", 0);
+                }
+                if (std::rename(tmpname.c_str(), filename.c_str()))
+                    MADNESS_EXCEPTION("GaussianConvolution1DCache: failed renaming cache", 0);
+            }
+            world.gop.fence();
+        }
+
+    private:
+        static const char* disk_cookie() { return "madness-conv1d-cache"; }
+
+        /// Reads the whole file, leaving buf empty if it cannot be opened
+        static void read_file(const std::string& filename, std::vector<unsigned char>& buf) {
+            buf.clear();
+            std::ifstream f(filename.c_str(), std::ios::binary);
+            if (!f) return;
+            f.seekg(0, std::ios::end);
+            const std::streamoff n = f.tellg();
+            f.seekg(0, std::ios::beg);
+            if (n <= 0) return;
+            buf.resize(n);
+            f.read(reinterpret_cast<char*>(&buf[0]), n);
+            if (!f) buf.clear();
+        }
+
+        /// Writes the header and all operator blocks
+        template <typename Archive>
+        static void store(Archive& ar) {
+            ar & std::string(disk_cookie()) & int(disk_version) & int(TensorTypeData<Q>::id) & int(sizeof(Translation));
+            ar & long(map.size());
+            for (auto it=map.begin(); it!=map.end(); ++it) {
+                const GaussianConvolution1D<Q>& op = *(it->second);
+                const bool periodic = static_cast<const Convolution1D<Q>&>(op).maxR > 0;
+                ar & op.k & op.expnt & op.m & int(periodic);
+                ar & long(op.rnlp_cache.size());
+                for (auto p=op.rnlp_cache.begin(); p!=op.rnlp_cache.end(); ++p)
+                    ar & p->first.level() & p->first.translation()[0] & p->second;
+                ar & long(op.ns_cache.size());
+                for (auto p=op.ns_cache.begin(); p!=op.ns_cache.end(); ++p)
+                    ar & p->first.level() & p->first.translation()[0] & p->second;
+            }
+        }
+
+        /// Inserts the blocks of a buffer written by store(), returning the number of blocks
+        static std::size_t insert(const std::vector<unsigned char>& buf, int kwant) {
+            archive::BufferInputArchive ar(&buf[0], buf.size());
+            std::string cookie;
+            int version, type_id, translation_size;
+            ar & cookie;
+            if (cookie != disk_cookie()) return 0;
+            ar & version & type_id & translation_size;
+            if (version != disk_version || type_id != TensorTypeData<Q>::id ||
+                translation_size != int(sizeof(Translation))) return 0;
+
+            std::size_t nblock = 0;
+            long nop;
+            ar & nop;
+            for (long iop=0; iop<nop; ++iop) {
+                int k, m, periodic;
+                double expnt;
+                ar & k & expnt & m & periodic;
+                const bool wanted = (kwant < 0 || k == kwant);
+                std::shared_ptr< GaussianConvolution1D<Q> > op;
+                if (wanted) op = get(k, expnt, m, periodic);
+
+                long n;
+                ar & n;
+                for (long i=0; i<n; ++i) {
+                    Level level;
+                    Translation l;
+                    Tensor<Q> r;
+                    ar & level & l & r;
+                    if (wanted) op->rnlp_cache.set(level, l, r);
+                }
+                nblock += wanted ? n : 0;
+
+                ar & n;
+                for (long i=0; i<n; ++i) {
+                    Level level;
+                    Translation l;
+                    ConvolutionData1D<Q> d;
+                    ar & level & l & d;
+                    if (wanted) op->ns_cache.set(level, l, d);
+                }
+                nblock += wanted ? n : 0;
+            }
+            return nblock;
+        }
     };
 }
 
@@ -36,6 +36,7 @@
 /// \brief Provides FunctionCommonData, FunctionImpl and FunctionFactory
 
 #include <iostream>
+#include <map>
 #include <type_traits>
 #include <madness/world/MADworld.h>
 #include <madness/world/print.h>
@@ -969,6 +970,7 @@ namespace madness {
             // before invoking process_pending for the coeffs and
             // for this.  Otherwise, there is a race condition.
             MADNESS_ASSERT(k>0 && k<=MAXK);
+            if (factory._flat_storage) coeffs.set_flat_storage();
 
             bool empty = (factory._empty or is_on_demand());
             bool do_refine = factory._refine;
@@ -1023,9 +1025,10 @@ namespace madness {
                          , on_demand(false)	// since functor() is an default ctor
                          , compressed(other.compressed)
                          , redundant(other.redundant)
-                         , coeffs(world, pmap ? pmap : other.coeffs.get_pmap())
+                         , coeffs(world, pmap ? pmap : other.coeffs.get_pmap(), false)
                          //, bc(other.bc)
         {
+            if (other.coeffs.get_flat_storage()) coeffs.set_flat_storage();
             if (dozero) {
                 initial_level = 1;
                 insert_zero_down_to_initial_level(cdata.key0);
@@ -2990,6 +2993,28 @@ namespace madness {
                   const keyT& keyin,
                   const typename Future<T>::remote_refT& ref);
 
+        /// Evaluate the function at many points in \em simulation coordinates
+
+        /// All points must lie inside the box of \c key.  The points are
+        /// sorted into the children of each interior node and travel down
+        /// the tree in batches, one active message per remote subtree,
+        /// and each leaf evaluates all of its points at once.  Only the
+        /// invoking process gets the values, in the order of \c xsim.
+        Future< Tensor<T> > eval_points(const keyT& key, const std::vector<coordT>& xsim) const;
+
+        /// Scatter the values returned by eval_points for subsets of the points into one tensor
+
+        /// \c index[i] holds the positions of the points of \c v[i] in the result
+        Tensor<T> eval_points_gather(long npt, const std::vector< std::vector<long> >& index,
+                                     const std::vector< Future< Tensor<T> > >& v) const;
+
+        /// Evaluate the leaf box \c key with coefficients \c c at points in \em simulation coordinates
+
+        /// The first dimension is contracted for all points with a single
+        /// matrix product, the remaining ones point by point.
+        Tensor<T> eval_points_leaf(const keyT& key, const std::vector<coordT>& xsim,
+                                   const tensorT& c) const;
+
         /// Get the depth of the tree at a point in \em simulation coordinates
 
         /// Only the invoking process will get the result via the
@@ -4368,6 +4393,134 @@ namespace madness {
         }
 
 
+        /// apply an operator on the coeffs of several functions at the same node key
+
+        /// Same as do_apply, but the displacements are walked once for all
+        /// sources: the operator norm is computed once per displacement and
+        /// the sources that pass the screening are transformed together.
+        /// @param[in] op       the operator to act on the source functions
+        /// @param[in] key      key of the source FunctionNodes being processed
+        /// @param[in] vc       coeffs of the source FunctionNodes
+        /// @param[in] vresult  the result functions, one for each source
+        template <typename opT, typename R>
+        void do_apply_vec(const opT* op, const keyT& key, const std::vector< Tensor<R> >& vc,
+                          const std::vector<implT*>& vresult) {
+            PROFILE_MEMBER_FUNC(FunctionImpl);
+
+            typedef typename opT::keyT opkeyT;
+            static const size_t opdim=opT::opdim;
+            const opkeyT source=op->get_source_key(key);
+
+            // see do_apply for the choice of radius and fac
+            double radius = 1.5 + 0.33*std::max(0.0,2-std::log10(thresh)-k);
+            double fac = vol_nsphere(NDIM, radius);
+            double tol = truncate_tol(thresh, key);
+
+            const std::size_t nsrc = vc.size();
+            std::vector<double> cnorm(nsrc);
+            for (std::size_t i=0; i<nsrc; ++i) cnorm[i] = vc[i].normf();
+
+            const std::vector<opkeyT>& disp = op->get_disp(key.level());
+            const std::vector<bool> is_periodic(NDIM,false);
+            int ndone=1;
+            uint64_t distsq = 99999999999999;
+            std::vector< Tensor<R> > c;
+            std::vector<std::size_t> index;
+            c.reserve(nsrc);
+            index.reserve(nsrc);
+            for (typename std::vector<opkeyT>::const_iterator it=disp.begin(); it != disp.end(); ++it) {
+                keyT d;
+                Key<NDIM-opdim> nullkey(key.level());
+                if (op->particle()==1) d=it->merge_with(nullkey);
+                if (op->particle()==2) d=nullkey.merge_with(*it);
+
+                uint64_t dsq = d.distsq();
+                if (dsq != distsq) {
+                    if (ndone == 0 && dsq > 1) break;
+                    ndone = 0;
+                    distsq = dsq;
+                }
+
+                keyT dest = neighbor(key, d, is_periodic);
+                if (dest.is_valid()) {
+                    double opnorm = op->norm(key.level(), *it, source);
+
+                    c.clear();
+                    index.clear();
+                    double cmax = 0.0;
+                    for (std::size_t i=0; i<nsrc; ++i) {
+                        if (cnorm[i]*opnorm > tol/fac) {
+                            c.push_back(vc[i]);
+                            index.push_back(i);
+                            cmax = std::max(cmax, cnorm[i]);
+                        }
+                    }
+
+                    if (!c.empty()) {
+                        ndone++;
+                        std::vector< Tensor<T> > result = op->apply(source, *it, c, tol/fac/cmax);
+                        for (std::size_t j=0; j<index.size(); ++j) {
+                            if (result[j].normf() > 0.3*tol/fac) {
+                                implT* impl = vresult[index[j]];
+                                impl->coeffs.send(dest, &nodeT::accumulate2, result[j], impl->coeffs, dest);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+
+        /// apply an operator on several functions, walking their trees together
+
+        /// All functions must have the same process map. The source nodes
+        /// that share a key are processed by one task (see do_apply_vec).
+        /// This is invoked on any of the results, which are all set up to
+        /// receive the results as in apply.
+        /// @param[in] op       the operator to act on the source functions
+        /// @param[in] vf       the source functions in non-standard form
+        /// @param[in] vresult  the result functions, one for each source
+        /// @param[in] fence    do a fence after all tasks are submitted
+        template <typename opT, typename R>
+        void apply_vec(opT& op, const std::vector<const FunctionImpl<R,NDIM>*>& vf,
+                       const std::vector<implT*>& vresult, bool fence) {
+            PROFILE_MEMBER_FUNC(FunctionImpl);
+            MADNESS_ASSERT(!op.modified());
+            MADNESS_ASSERT(vf.size()==vresult.size());
+
+            // Gather the coefficients of the local source nodes by key
+            typedef std::pair< std::vector< Tensor<R> >, std::vector<implT*> > sourceT;
+            std::map<keyT,sourceT> sources;
+            for (std::size_t i=0; i<vf.size(); ++i) {
+                MADNESS_ASSERT(vf[i]->get_pmap() == vf[0]->get_pmap());
+                typename FunctionImpl<R,NDIM>::dcT::const_iterator end = vf[i]->coeffs.end();
+                for (typename FunctionImpl<R,NDIM>::dcT::const_iterator it=vf[i]->coeffs.begin(); it!=end; ++it) {
+                    const FunctionNode<R,NDIM>& node = it->second;
+                    if (node.has_coeff()) {
+                        if (node.coeff().dim(0) != k || op.doleaves) {
+                            sourceT& s = sources[it->first];
+                            s.first.push_back(node.coeff().reconstruct_tensor());
+                            s.second.push_back(vresult[i]);
+                        }
+                    }
+                }
+            }
+
+            for (typename std::map<keyT,sourceT>::const_iterator it=sources.begin(); it!=sources.end(); ++it) {
+                world.taskq.add(*this, &implT:: template do_apply_vec<opT,R>, &op, it->first,
+                                it->second.first, it->second.second);
+            }
+            if (fence)
+                world.gop.fence();
+
+            for (std::size_t i=0; i<vresult.size(); ++i) {
+                vresult[i]->compressed=true;
+                vresult[i]->nonstandard=true;
+                vresult[i]->redundant=false;
+            }
+        }
+
+
 
         /// apply an operator on the coeffs c (at node key)
 
@@ -44,11 +44,72 @@
  */
 
 namespace madness {
+    namespace detail {
+        /// Number of grid points evaluated at once by the streaming plot writers
+
+        /// Bounds the memory used on each process while writing a volume
+        /// plot to that of the coordinates and values of one chunk.
+        static const long plot_chunk_size = 1L<<18;
+
+        /// Evaluates the points [begin,end) of a uniform grid spanning \c cell
+
+        /// Points are numbered in row-major order (last dimension fastest,
+        /// the OpenDX convention) or, if \c first_fastest is set, with the
+        /// first dimension fastest (the VTK convention).  The points are
+        /// routed to the processes owning the leaves that contain them, so
+        /// any process may call this independently of the others.  The
+        /// function must be reconstructed.  Returns a 1D tensor of values.
+        template <typename T, std::size_t NDIM>
+        Tensor<T> plot_grid_values(const Function<T,NDIM>& f,
+                                   const Tensor<double>& cell,
+                                   const std::vector<long>& npt,
+                                   long begin, long end,
+                                   bool first_fastest) {
+            Vector<double,NDIM> h;
+            for (std::size_t d=0; d<NDIM; ++d) {
+                h[d] = (npt[d] > 1) ? (cell(d,1)-cell(d,0))/(npt[d]-1) : 0.0;
+            }
+
+            std::vector< Vector<double,NDIM> > x(end-begin);
+            for (long i=begin; i<end; ++i) {
+                long rem = i;
+                for (std::size_t dd=0; dd<NDIM; ++dd) {
+                    const std::size_t d = first_fastest ? dd : NDIM-1-dd;
+                    const long id = rem % npt[d];
+                    rem /= npt[d];
+                    // land exactly on the upper bound rather than rounding past it
+                    if (id > 0 && id == npt[d]-1) x[i-begin][d] = cell(d,1);
+                    else x[i-begin][d] = cell(d,0) + id*h[d];
+                }
+            }
+            return f.eval(x).get();
+        }
+
+        /// Returns true if this process stores multi-byte values little-endian
+        inline bool plot_little_endian() {
+            const int one = 1;
+            return *reinterpret_cast<const char*>(&one) == 1;
+        }
+
+        static inline void plot_ascii_value(FILE* f, double v) {
+            fprintf(f, "%.6e\n", v);
+        }
+
+        static inline void plot_ascii_value(FILE* f, const double_complex& v) {
+            fprintf(f, "%.6e %.6e\n", v.real(), v.imag());
+        }
+    }
+
     /// Writes an OpenDX format file with a cube/slice of points on a uniform grid
 
-    /// Collective operation but only process 0 writes the file.  By convention OpenDX
-    /// files end in ".dx" but this choice is up to the user.  The binary format is
-    /// more compact and vastly faster to both write and load but is not as portable.
+    /// Collective operation.  Process 0 writes the header and footer.  In the
+    /// binary format every process evaluates a contiguous range of the points
+    /// and writes it in place, so the file must be visible to all processes;
+    /// in the text format process 0 writes the values as they are computed.
+    /// No process ever holds more than a bounded chunk of the cube.  By
+    /// convention OpenDX files end in ".dx" but this choice is up to the user.
+    /// The binary format is more compact and vastly faster to both write and
+    /// load but is not as portable.
     ///
     /// Now follow some brief tips about how to look at files inside OpenDX.
     ///
@@ -80,7 +141,8 @@ namespace madness {
     /// @param npt Vector of long integers indicating the number of points to plot in each dimension
     /// @param binary (optional) Boolean indicating whether to print in binary
 
-    /// The VTK routines are also designed for SERIAL data, parallel coming...
+    /// The VTK routines are also designed for SERIAL data: process 0 writes
+    /// the whole file.  See plotvti() for a parallel writer.
     ///
     /// This header is templated by the dimension of the data.
     ///
@@ -217,13 +279,34 @@ namespace madness {
         }
 
         world.gop.fence();
-        Tensor<T> tmpr = function.eval_cube(cell, numpt, plot_refine);
-        world.gop.fence();
+        if(plot_refine) {
+            Tensor<T> tmpr = function.eval_cube(cell, numpt, plot_refine);
+            world.gop.fence();
 
-        if(world.rank() == 0) {
-            for(LowDimIndexIterator it(numpt); it; ++it) {
-                fprintf(f, "%.6e\n", tmpr(*it));
+            if(world.rank() == 0) {
+                for(LowDimIndexIterator it(numpt); it; ++it) {
+                    fprintf(f, "%.6e\n", tmpr(*it));
+                }
             }
+        }
+        else {
+            // stream the values in the order of the points in the header
+            function.reconstruct();
+            if(world.rank() == 0) {
+                long npoint = 1;
+                for(i = 0; i < NDIM; ++i)
+                    npoint *= numpt[i];
+                for(long lo = 0; lo < npoint; lo += detail::plot_chunk_size) {
+                    const long hi = std::min(npoint, lo + detail::plot_chunk_size);
+                    Tensor<T> tmpr = detail::plot_grid_values(function, cell,
+                                                              numpt, lo, hi, true);
+                    for(long j = 0; j < tmpr.size(); ++j)
+                        fprintf(f, "%.6e\n", tmpr(j));
+                }
+            }
+        }
+
+        if(world.rank() == 0) {
             fprintf(f, "        </DataArray>\n");
             fclose(f);
         }
@@ -275,14 +358,35 @@ namespace madness {
         }
 
         world.gop.fence();
-        Tensor<std::complex<T> > tmpr = function.eval_cube(cell, numpt,
-                                                           plot_refine);
-        world.gop.fence();
+        if(plot_refine) {
+            Tensor<std::complex<T> > tmpr = function.eval_cube(cell, numpt,
+                                                               plot_refine);
+            world.gop.fence();
+
+            if(world.rank() == 0) {
+                for(LowDimIndexIterator it(numpt); it; ++it) {
+                    fprintf(f, "%.6e %.6e\n", real(tmpr(*it)), imag(tmpr(*it)));
+                }
+            }
+        }
+        else {
+            // stream the values in the order of the points in the header
+            function.reconstruct();
+            if(world.rank() == 0) {
+                long npoint = 1;
+                for(i = 0; i < NDIM; ++i)
+                    npoint *= numpt[i];
+                for(long lo = 0; lo < npoint; lo += detail::plot_chunk_size) {
+                    const long hi = std::min(npoint, lo + detail::plot_chunk_size);
+                    Tensor<std::complex<T> > tmpr = detail::plot_grid_values(
+                        function, cell, numpt, lo, hi, true);
+                    for(long j = 0; j < tmpr.size(); ++j)
+                        fprintf(f, "%.6e %.6e\n", real(tmpr(j)), imag(tmpr(j)));
+                }
+            }
+        }
 
         if(world.rank() == 0) {
-            for(LowDimIndexIterator it(numpt); it; ++it) {
-                fprintf(f, "%.6e %.6e\n", real(tmpr(*it)), imag(tmpr(*it)));
-            }
             fprintf(f, "        </DataArray>\n");
             fclose(f);
         }
@@ -317,6 +421,214 @@ namespace madness {
         world.gop.fence();
     }
 
+    namespace detail {
+        /// Writes a VTK extent covering all of \c npt except planes [p0,p1] of the last dimension
+        template<std::size_t NDIM>
+        void plotvti_extent(FILE *f, const Vector<long, NDIM> &npt, long p0, long p1) {
+            for(std::size_t d = 0; d < 3; ++d) {
+                if(d + 1 == NDIM)
+                    fprintf(f, "%ld %ld", p0, p1);
+                else if(d < NDIM)
+                    fprintf(f, "0 %ld", npt[d]-1);
+                else
+                    fprintf(f, "0 0");
+                fputs((d < 2) ? " " : "\"", f);
+            }
+        }
+
+        /// Writes the VTK origin and spacing of a uniform grid
+        template<std::size_t NDIM>
+        void plotvti_geometry(FILE *f, const Vector<double, NDIM> &plotlo,
+            const Vector<double, NDIM> &plothi, const Vector<long, NDIM> &npt) {
+            fprintf(f, " Origin=\"");
+            for(std::size_t d = 0; d < 3; ++d)
+                fprintf(f, "%.14e%s", (d < NDIM) ? plotlo[d] : 0.0, (d < 2) ? " " : "\"");
+            fprintf(f, " Spacing=\"");
+            for(std::size_t d = 0; d < 3; ++d) {
+                double h = 1.0;
+                if(d < NDIM && npt[d] > 1)
+                    h = (plothi[d] - plotlo[d]) / (npt[d] - 1);
+                fprintf(f, "%.14e%s", h, (d < 2) ? " " : "\"");
+            }
+        }
+
+        /// First plane of the last dimension written by process \c rank in plotvti
+        inline long plotvti_plane(long nplane, long rank, long nproc) {
+            return (rank * (nplane - 1)) / nproc;
+        }
+    }
+
+    /// Writes functions on a uniform grid as a parallel VTK image (.pvti + .vti pieces)
+
+    /// Collective operation.  The grid is split into slabs along the last
+    /// dimension and every process evaluates its own slab, one bounded chunk
+    /// at a time, and writes it to the piece \c basename_<rank>.vti.
+    /// Process 0 writes the index \c basename.pvti that Paraview and VisIt
+    /// open to assemble the pieces, so the files must be visible to all
+    /// processes.  Neighbouring slabs share their boundary plane, as VTK
+    /// requires, and processes left without a plane write no piece.
+    ///
+    /// Complex values are written as two components (real, imaginary).  The
+    /// binary format appends the raw values in native byte order; the text
+    /// format is more portable but much larger.
+    /// @param vf Functions to plot, all sharing the same World
+    /// @param fieldnames Name of the point data array of each function
+    /// @param basename Path of the output files without extension
+    /// @param plotlo Vector of double values indicating the minimum coordinate to plot to in each dimension
+    /// @param plothi Vector of double values indicating the maximum coordinate to plot to in each dimension
+    /// @param npt Vector of long integers indicating the number of points to plot in each dimension
+    /// @param binary (optional) Boolean indicating whether to write raw binary data
+    template<typename T, std::size_t NDIM>
+    void plotvti(const std::vector< Function<T, NDIM> > &vf,
+        const std::vector<std::string> &fieldnames, const std::string &basename,
+        const Vector<double, NDIM> &plotlo, const Vector<double, NDIM> &plothi,
+        const Vector<long, NDIM> &npt, bool binary = true) {
+
+        PROFILE_FUNC;
+        MADNESS_ASSERT(NDIM>=1 && NDIM<=3);
+        MADNESS_ASSERT(vf.size() > 0 && vf.size() == fieldnames.size());
+
+        World &world = vf[0].world();
+        for(std::size_t j = 0; j < vf.size(); ++j) {
+            vf[j].verify();
+            vf[j].reconstruct(false);
+        }
+        world.gop.fence();
+
+        Tensor<double> cell(NDIM, 2);
+        std::vector<long> numpt(NDIM);
+        long planesize = 1;
+        for(std::size_t d = 0; d < NDIM; ++d) {
+            cell(d, 0) = plotlo[d];
+            cell(d, 1) = plothi[d];
+            numpt[d] = npt[d];
+            if(d + 1 < NDIM)
+                planesize *= npt[d];
+        }
+
+        const char *byte_order = detail::plot_little_endian() ? "LittleEndian" : "BigEndian";
+        const char *type = (sizeof(typename TensorTypeData<T>::scalar_type) == 4) ? "Float32" : "Float64";
+        const int ncomp = TensorTypeData<T>::iscomplex ? 2 : 1;
+        const long nplane = npt[NDIM-1];
+        const long nproc = world.size();
+        const long me = world.rank();
+
+        const long p0 = detail::plotvti_plane(nplane, me, nproc);
+        const long p1 = detail::plotvti_plane(nplane, me + 1, nproc);
+        if(p1 > p0 || (nplane == 1 && me == 0)) {
+            const long begin = p0 * planesize;
+            const long end = (p1 + 1) * planesize;
+            const uint64_t nbyte = (end - begin) * sizeof(T);
+
+            char filename[1024];
+            snprintf(filename, sizeof(filename), "%s_%ld.vti", basename.c_str(), me);
+            FILE *f = fopen(filename, binary ? "wb" : "w");
+            if(!f)
+                MADNESS_EXCEPTION("plotvti: failed to open the plot file", me);
+
+            fprintf(f, "<?xml version=\"1.0\"?>\n");
+            fprintf(f, "<VTKFile type=\"ImageData\" version=\"1.0\" " \
+                "byte_order=\"%s\" header_type=\"UInt64\">\n", byte_order);
+            fprintf(f, "  <ImageData WholeExtent=\"");
+            detail::plotvti_extent(f, npt, p0, p1);
+            detail::plotvti_geometry(f, plotlo, plothi, npt);
+            fprintf(f, ">\n");
+            fprintf(f, "    <Piece Extent=\"");
+            detail::plotvti_extent(f, npt, p0, p1);
+            fprintf(f, ">\n");
+            fprintf(f, "      <PointData>\n");
+            for(std::size_t j = 0; j < vf.size(); ++j) {
+                fprintf(f, "        <DataArray type=\"%s\" Name=\"%s\" " \
+                    "NumberOfComponents=\"%d\" ", type, fieldnames[j].c_str(), ncomp);
+                if(binary) {
+                    fprintf(f, "format=\"appended\" offset=\"%lu\"/>\n",
+                        (unsigned long)(j * (sizeof(uint64_t) + nbyte)));
+                }
+                else {
+                    fprintf(f, "format=\"ascii\">\n");
+                    for(long lo = begin; lo < end; lo += detail::plot_chunk_size) {
+                        const long hi = std::min(end, lo + detail::plot_chunk_size);
+                        Tensor<T> r = detail::plot_grid_values(vf[j], cell, numpt, lo, hi, true);
+                        for(long i = 0; i < r.size(); ++i)
+                            detail::plot_ascii_value(f, r(i));
+                    }
+                    fprintf(f, "        </DataArray>\n");
+                }
+            }
+            fprintf(f, "      </PointData>\n");
+            fprintf(f, "      <CellData>\n");
+            fprintf(f, "      </CellData>\n");
+            fprintf(f, "    </Piece>\n");
+            fprintf(f, "  </ImageData>\n");
+            if(binary) {
+                fprintf(f, "  <AppendedData encoding=\"raw\">\n   _");
+                for(std::size_t j = 0; j < vf.size(); ++j) {
+                    fwrite((void *) &nbyte, sizeof(nbyte), 1, f);
+                    for(long lo = begin; lo < end; lo += detail::plot_chunk_size) {
+                        const long hi = std::min(end, lo + detail::plot_chunk_size);
+                        Tensor<T> r = detail::plot_grid_values(vf[j], cell, numpt, lo, hi, true);
+                        fwrite((void *) r.ptr(), sizeof(T), r.size(), f);
+                    }
+                }
+                fprintf(f, "\n  </AppendedData>\n");
+            }
+            fprintf(f, "</VTKFile>\n");
+            fclose(f);
+        }
+
+        if(world.rank() == 0) {
+            const std::string pvti = basename + ".pvti";
+            FILE *f = fopen(pvti.c_str(), "w");
+            if(!f)
+                MADNESS_EXCEPTION("plotvti: failed to open the plot file", 0);
+
+            // pieces are referenced relative to the directory of the index
+            const std::string::size_type slash = basename.find_last_of('/');
+            const std::string stem = (slash == std::string::npos) ? basename : basename.substr(slash + 1);
+
+            fprintf(f, "<?xml version=\"1.0\"?>\n");
+            fprintf(f, "<VTKFile type=\"PImageData\" version=\"1.0\" " \
+                "byte_order=\"%s\" header_type=\"UInt64\">\n", byte_order);
+            fprintf(f, "  <PImageData WholeExtent=\"");
+            detail::plotvti_extent(f, npt, 0, nplane - 1);
+            fprintf(f, " GhostLevel=\"0\"");
+            detail::plotvti_geometry(f, plotlo, plothi, npt);
+            fprintf(f, ">\n");
+            fprintf(f, "    <PPointData>\n");
+            for(std::size_t j = 0; j < vf.size(); ++j) {
+                fprintf(f, "      <PDataArray type=\"%s\" Name=\"%s\" " \
+                    "NumberOfComponents=\"%d\"/>\n", type, fieldnames[j].c_str(), ncomp);
+            }
+            fprintf(f, "    </PPointData>\n");
+            for(long rank = 0; rank < nproc; ++rank) {
+                const long q0 = detail::plotvti_plane(nplane, rank, nproc);
+                const long q1 = detail::plotvti_plane(nplane, rank + 1, nproc);
+                if(q1 > q0 || (nplane == 1 && rank == 0)) {
+                    fprintf(f, "    <Piece Extent=\"");
+                    detail::plotvti_extent(f, npt, q0, q1);
+                    fprintf(f, " Source=\"%s_%ld.vti\"/>\n", stem.c_str(), rank);
+                }
+            }
+            fprintf(f, "  </PImageData>\n");
+            fprintf(f, "</VTKFile>\n");
+            fclose(f);
+        }
+        world.gop.fence();
+    }
+
+    /// Writes a single function on a uniform grid as a parallel VTK image
+
+    /// See plotvti() for the vector of functions.
+    template<typename T, std::size_t NDIM>
+    void plotvti(const Function<T, NDIM> &f, const std::string &fieldname,
+        const std::string &basename, const Vector<double, NDIM> &plotlo,
+        const Vector<double, NDIM> &plothi, const Vector<long, NDIM> &npt,
+        bool binary = true) {
+        plotvti(std::vector< Function<T, NDIM> >(1, f),
+                std::vector<std::string>(1, fieldname), basename, plotlo,
+                plothi, npt, binary);
+    }
+
     namespace detail {
         inline unsigned short htons_x(unsigned short a) {
             return (a>>8) | (a<<8);
@@ -396,13 +708,15 @@ namespace madness {
         World& world = f.world();
         f.reconstruct();
         if (world.rank() == 0) {
+            std::vector<coordT> r(npt);
+            for (int i=0; i<npt; ++i) r[i] = lo + h*double(i);
             FILE* file = fopen(filename,"w");
 	    if(!file)
 	      MADNESS_EXCEPTION("plot_line: failed to open the plot file", 0);
+            Tensor<T> fr = f.eval(r).get();
             for (int i=0; i<npt; ++i) {
-                coordT r = lo + h*double(i);
                 fprintf(file, "%.14e ", i*sum);
-                plot_line_print_value(file, f.eval(r));
+                plot_line_print_value(file, fr(i));
                 fprintf(file,"\n");
             }
             fclose(file);
@@ -427,14 +741,19 @@ namespace madness {
         f.reconstruct();
         g.reconstruct();
         if (world.rank() == 0) {
+            std::vector<coordT> r(npt);
+            for (int i=0; i<npt; ++i) r[i] = lo + h*double(i);
             FILE* file = fopen(filename,"w");
 	    if(!file)
 	      MADNESS_EXCEPTION("plot_line: failed to open the plot file", 0);
+            Future< Tensor<T> > ffr = f.eval(r);
+            Future< Tensor<U> > fgr = g.eval(r);
+            const Tensor<T>& fr = ffr.get();
+            const Tensor<U>& gr = fgr.get();
             for (int i=0; i<npt; ++i) {
-                coordT r = lo + h*double(i);
                 fprintf(file, "%.14e ", i*sum);
-                plot_line_print_value(file, f.eval(r));
-                plot_line_print_value(file, g.eval(r));
+                plot_line_print_value(file, fr(i));
+                plot_line_print_value(file, gr(i));
                 fprintf(file,"\n");
             }
             fclose(file);
@@ -461,15 +780,22 @@ namespace madness {
         g.reconstruct();
         a.reconstruct();
         if (world.rank() == 0) {
+            std::vector<coordT> r(npt);
+            for (int i=0; i<npt; ++i) r[i] = lo + h*double(i);
             FILE* file = fopen(filename,"w");
 	    if(!file)
 	      MADNESS_EXCEPTION("plot_line: failed to open the plot file", 0);
+            Future< Tensor<T> > ffr = f.eval(r);
+            Future< Tensor<U> > fgr = g.eval(r);
+            Future< Tensor<V> > far = a.eval(r);
+            const Tensor<T>& fr = ffr.get();
+            const Tensor<U>& gr = fgr.get();
+            const Tensor<V>& ar = far.get();
             for (int i=0; i<npt; ++i) {
-                coordT r = lo + h*double(i);
                 fprintf(file, "%.14e ", i*sum);
-                plot_line_print_value(file, f.eval(r));
-                plot_line_print_value(file, g.eval(r));
-                plot_line_print_value(file, a.eval(r));
+                plot_line_print_value(file, fr(i));
+                plot_line_print_value(file, gr(i));
+                plot_line_print_value(file, ar(i));
                 fprintf(file,"\n");
             }
             fclose(file);
@@ -496,14 +822,23 @@ namespace madness {
         a.reconstruct();
         b.reconstruct();
         if (world.rank() == 0) {
+            std::vector<coordT> r(npt);
+            for (int i=0; i<npt; ++i) r[i] = lo + h*double(i);
             FILE* file = fopen(filename,"w");
+            Future< Tensor<T> > ffr = f.eval(r);
+            Future< Tensor<U> > fgr = g.eval(r);
+            Future< Tensor<V> > far = a.eval(r);
+            Future< Tensor<W> > fbr = b.eval(r);
+            const Tensor<T>& fr = ffr.get();
+            const Tensor<U>& gr = fgr.get();
+            const Tensor<V>& ar = far.get();
+            const Tensor<W>& br = fbr.get();
             for (int i=0; i<npt; ++i) {
-                coordT r = lo + h*double(i);
                 fprintf(file, "%.14e ", i*sum);
-                plot_line_print_value(file, f.eval(r));
-                plot_line_print_value(file, g.eval(r));
-                plot_line_print_value(file, a.eval(r));
-                plot_line_print_value(file, b.eval(r));
+                plot_line_print_value(file, fr(i));
+                plot_line_print_value(file, gr(i));
+                plot_line_print_value(file, ar(i));
+                plot_line_print_value(file, br(i));
                 fprintf(file,"\n");
             }
             fclose(file);
@@ -543,7 +878,6 @@ namespace madness {
 
 
     /// plot a 2-d slice of a given function and the according MRA structure
-    /// FIXME: doesn't work for more than 1 rank
 
     /// the plotting parameters are taken from the input file "input" and its
     /// data group "plot", e.g. plotting the xy plane around (0,0,0.7):
@@ -560,7 +894,6 @@ namespace madness {
     void plot_plane(World& world, const std::vector<Function<double,NDIM> >& vfunction,
     		const std::string name) {
 
-		if (world.size()>1) return;
         // determine the ploting plane
     	std::string c1="x1", c2="x2";
 
@@ -625,8 +958,21 @@ namespace madness {
 
         const double stepsize=FunctionDefaults<NDIM>::get_cell_width()[0]*scale/npoints;
 
+        for (std::size_t ivec=0; ivec<vfunction.size(); ++ivec) vfunction[ivec].reconstruct();
         if(world.rank() == 0) {
 
+        	// evaluate all functions on the whole plane at once
+        	std::vector<Vector<double,NDIM> > coords(npoints*npoints,coord);
+        	for (int i0=0; i0<npoints; i0++) {
+        		for (int i1=0; i1<npoints; i1++) {
+        			coords[i0*npoints+i1][cc1]=lo+origin[cc1]+i0*stepsize;
+        			coords[i0*npoints+i1][cc2]=lo+origin[cc2]+i1*stepsize;
+        		}
+        	}
+        	std::vector<Future<Tensor<double> > > values(vfunction.size());
+        	for (std::size_t ivec=0; ivec<vfunction.size(); ++ivec)
+        		values[ivec]=vfunction[ivec].eval(coords);
+
         	// plot 3d plot
         	FILE *f =  0;
         	f=fopen(filename.c_str(), "w");
@@ -635,15 +981,14 @@ namespace madness {
         	for (int i0=0; i0<npoints; i0++) {
         		for (int i1=0; i1<npoints; i1++) {
         			// plot plane
-        			coord[cc1]=lo+origin[cc1]+i0*stepsize;
-        			coord[cc2]=lo+origin[cc2]+i1*stepsize;
+        			coord=coords[i0*npoints+i1];
 
         			// other electron
 //        			fprintf(f,"%12.6f %12.6f %12.20f\n",coord[cc1],coord[cc2],
 //        					function(coord));
                     fprintf(f,"%12.6f %12.6f",coord[cc1],coord[cc2]);
                     for (std::size_t ivec=0; ivec<vfunction.size(); ++ivec)
-                        fprintf(f,"  %12.20f",vfunction[ivec](coord));
+                        fprintf(f,"  %12.20f",values[ivec].get()(i0*npoints+i1));
                     fprintf(f,"\n");
 
         		}
@@ -653,6 +998,7 @@ namespace madness {
         	fclose(f);
 
         }
+        world.gop.fence();
 
 //        // plot mra structure
 //    	filename="mra_structure_"+c1+c2+"_"+name;
@@ -828,16 +1174,20 @@ namespace madness {
         for (const std::string& s : molecular_info) fprintf(file,"%s",s.c_str());
 
 
-        Tensor<double>grid(npt[0],npt[1],npt[2]);
+        // evaluate one x-slab of the grid at a time
+        f.reconstruct();
+        std::vector<Vector<double,NDIM> > coords(npt[1]*npt[2]);
         for (int i=0;i<npt[0];++i) {
             for (int j=0;j<npt[1];++j) {
                 for (int k=0;k<npt[2];++k) {
-                    double x=cell(0,0)+origin[0]+xlen/npt[0]*i;
-                    double y=cell(1,0)+origin[1]+ylen/npt[1]*j;
-                    double z=cell(2,0)+origin[2]+zlen/npt[2]*k;
-                    fprintf(file,"%12.8f",f(x,y,z));
+                    Vector<double,NDIM>& r=coords[j*npt[2]+k];
+                    r[0]=cell(0,0)+origin[0]+xlen/npt[0]*i;
+                    r[1]=cell(1,0)+origin[1]+ylen/npt[1]*j;
+                    r[2]=cell(2,0)+origin[2]+zlen/npt[2]*k;
                 }
             }
+            const Tensor<double> values=f.eval(coords).get();
+            for (long ijk=0; ijk<values.size(); ++ijk) fprintf(file,"%12.8f",values(ijk));
             fprintf(file,"\n");
         }
         fclose(file);
@@ -978,6 +1328,7 @@ namespace madness {
 
     	 const bool psdot=false;
 
+    	 function.reconstruct();
     	 if(world.rank() == 0) {
     		 f = fopen(filename.c_str(), "w");
     		 if(!f) MADNESS_EXCEPTION("plot_along: failed to open the plot file", 0);
@@ -990,14 +1341,18 @@ namespace madness {
                  fprintf(f,"\\pslinewidth=0.05pt\n");
     		 }
 
+    		 // evaluate all points along the line at once
+    		 std::vector<Vector<double,NDIM> > coords(npt);
+    		 for (int ipt=0; ipt<npt; ipt++) coords[ipt]=traj(ipt);
+    		 const Tensor<double> values=function.eval(coords).get();
+
     		 // walk along the line
     		 for (int ipt=0; ipt<npt; ipt++) {
-    			 Vector<double,NDIM> coord=traj(ipt);
     			 if (psdot) {
-    			     long rank=function.evalR(coord);
-    			     trajectory<NDIM>::print_psdot(f,ipt,function(coord),trajectory<NDIM>::hueCode(rank));
+    			     long rank=function.evalR(coords[ipt]);
+    			     trajectory<NDIM>::print_psdot(f,ipt,values(ipt),trajectory<NDIM>::hueCode(rank));
     			 } else {
-    			     fprintf(f,"%4i %12.6f\n",ipt, function(coord));
+    			     fprintf(f,"%4i %12.6f\n",ipt, values(ipt));
     			 }
     		 }
 
@@ -0,0 +1,440 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_MRA_FUNCTION_EXPRESSION_H__INCLUDED
+#define MADNESS_MRA_FUNCTION_EXPRESSION_H__INCLUDED
+
+/*!
+	\file function_expression.h
+	\brief Lazy pointwise expressions of Functions evaluated in one tree walk
+	\ingroup mra
+
+	Each arithmetic operator on \c Function builds a complete result tree:
+	\c a*b+c*d-e makes four temporaries, each with its own traversal and
+	fence.  Wrapping an operand with \c lazy() instead records the
+	operations in a \c FunctionExpr, and \c materialize() evaluates the
+	whole expression in a single recursive descent over the union of the
+	trees of the operands, in the manner of \c mulXXa and \c binaryXXa:
+	\code
+	real_function_3d r = (lazy(V)*psi + 0.5*lazy(rho)*psi - phi).materialize();
+	\endcode
+	At each leaf box the coefficients of every distinct operand are
+	converted to values once, the expression is evaluated pointwise and
+	the result converted back to coefficients.  Products, sums, scaling
+	and unary operations (functors like those of \c unary_op) may be
+	combined freely, and a subexpression or operand used several times is
+	evaluated once per box.
+
+	The result is the same as that of the eager operators: sums are exact
+	and products are formed on the finest common level, as \c mul does.
+	The result is reconstructed and not truncated.
+*/
+
+#include <madness/mra/mra.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace madness {
+
+    template <typename T, std::size_t NDIM> class FunctionExprImpl;
+
+    /// A lazy pointwise expression of Functions, see \ref function_expression.h
+
+    /// Copies are shallow; the nodes of an expression are immutable.
+    /// \tparam T The type of the functions and of the result.
+    /// \tparam NDIM The dimension of the functions.
+    template <typename T, std::size_t NDIM>
+    class FunctionExpr {
+    public:
+        typedef T scalarT;
+        typedef Function<T,NDIM> functionT;
+
+        /// Interface of the unary operations of an expression
+        struct UnaryInterface {
+            virtual ~UnaryInterface() { }
+            virtual Tensor<T> operator()(const Key<NDIM>& key, const Tensor<T>& values) const = 0;
+        };
+
+        /// Wraps a functor on the values of a box, as used by \c unary_op
+        template <typename opT>
+        struct Unary : public UnaryInterface {
+            opT op;
+            Unary(const opT& op) : op(op) { }
+            Tensor<T> operator()(const Key<NDIM>& key, const Tensor<T>& values) const {
+                return op(key, values);
+            }
+        };
+
+        /// A node of the expression
+        struct Node {
+            enum Kind {LEAF, MUL, GAXPY, SCALE, UNARY};
+
+            Kind kind;
+            functionT f;                            ///< The function of a LEAF
+            std::shared_ptr<const Node> a, b;       ///< Operands
+            T alpha, beta;                          ///< GAXPY is alpha*a + beta*b, SCALE is alpha*a
+            std::shared_ptr<const UnaryInterface> op; ///< Operation of a UNARY
+
+            Node(Kind kind) : kind(kind), alpha(1.0), beta(1.0) { }
+        };
+
+    private:
+        std::shared_ptr<const Node> node;
+
+        explicit FunctionExpr(const std::shared_ptr<const Node>& node) : node(node) { }
+
+        static FunctionExpr make(typename Node::Kind kind, const FunctionExpr& a, const FunctionExpr* b,
+                                 T alpha=T(1.0), T beta=T(1.0)) {
+            std::shared_ptr<Node> n(new Node(kind));
+            n->a = a.node;
+            if (b) n->b = b->node;
+            n->alpha = alpha;
+            n->beta = beta;
+            return FunctionExpr(n);
+        }
+
+    public:
+        /// An expression that is just the function \c f
+        FunctionExpr(const functionT& f) {
+            MADNESS_ASSERT(f.is_initialized());
+            MADNESS_ASSERT(!f.is_on_demand());
+            std::shared_ptr<Node> n(new Node(Node::LEAF));
+            n->f = f;
+            node = n;
+        }
+
+        /// The root node of the expression
+        const std::shared_ptr<const Node>& get_node() const {
+            return node;
+        }
+
+        /// The pointwise product \c a*b
+        static FunctionExpr mul(const FunctionExpr& a, const FunctionExpr& b) {
+            return make(Node::MUL, a, &b);
+        }
+
+        /// The sum \c alpha*a + \c beta*b
+        static FunctionExpr gaxpy(T alpha, const FunctionExpr& a, T beta, const FunctionExpr& b) {
+            return make(Node::GAXPY, a, &b, alpha, beta);
+        }
+
+        /// The product \c alpha*a
+        static FunctionExpr scale(T alpha, const FunctionExpr& a) {
+            return make(Node::SCALE, a, nullptr, alpha);
+        }
+
+        /// The pointwise operation \c op(a)
+
+        /// \param[in] op Functor with <tt>Tensor<T> operator()(const Key<NDIM>&, const Tensor<T>& values) const</tt>.
+        /// \param[in] a The operand.
+        template <typename opT>
+        static FunctionExpr unary(const opT& op, const FunctionExpr& a) {
+            std::shared_ptr<Node> n(new Node(Node::UNARY));
+            n->a = a.node;
+            n->op.reset(new Unary<opT>(op));
+            return FunctionExpr(n);
+        }
+
+        /// Evaluates the expression in one tree walk (collective, fences)
+
+        /// Compressed operands are reconstructed first; all operands
+        /// must have the same process map and polynomial order.
+        /// \return The new, reconstructed function.
+        functionT materialize() const;
+    };
+
+
+    /// Evaluates a \c FunctionExpr by recursive descent over the union of the trees of its operands
+
+    /// The expression is flattened into a program over the distinct
+    /// operands.  A world object (made collectively by \c materialize)
+    /// holds the program on every process, so the tasks of the descent
+    /// only carry the coefficients inherited from the parent box.
+    template <typename T, std::size_t NDIM>
+    class FunctionExprImpl : public WorldObject< FunctionExprImpl<T,NDIM> > {
+        typedef FunctionExprImpl<T,NDIM> exprimplT;
+        typedef FunctionExpr<T,NDIM> exprT;
+        typedef typename exprT::Node exprnodeT;
+        typedef FunctionImpl<T,NDIM> implT;
+        typedef typename implT::dcT dcT;
+        typedef typename implT::nodeT nodeT;
+        typedef typename implT::coeffT coeffT;
+        typedef Key<NDIM> keyT;
+        typedef Tensor<T> tensorT;
+
+        /// One step of the program; its operands are earlier steps
+        struct Step {
+            typename exprnodeT::Kind kind;
+            int a, b;       ///< Indices of the operand steps, or of the function for a LEAF
+            T alpha, beta;
+            const typename exprT::UnaryInterface* op;
+        };
+
+        std::vector< Function<T,NDIM> > leaves; ///< The distinct functions of the expression
+        std::vector<Step> program;              ///< The nodes in evaluation order, the last is the result
+        std::shared_ptr<implT> result;
+        exprT expr;                             ///< Keeps the unary operations alive
+
+        /// Appends the steps of node \c n (and its operands) to the program
+        int flatten(const exprnodeT* n, std::map<const exprnodeT*,int>& done,
+                    std::map<const implT*,int>& leafmap) {
+            typename std::map<const exprnodeT*,int>::const_iterator it = done.find(n);
+            if (it != done.end()) return it->second;
+
+            Step s;
+            s.kind = n->kind;
+            s.a = s.b = -1;
+            s.alpha = n->alpha;
+            s.beta = n->beta;
+            s.op = n->op.get();
+            if (n->kind == exprnodeT::LEAF) {
+                const implT* impl = n->f.get_impl().get();
+                typename std::map<const implT*,int>::const_iterator lit = leafmap.find(impl);
+                if (lit == leafmap.end()) {
+                    lit = leafmap.insert(std::make_pair(impl, int(leaves.size()))).first;
+                    leaves.push_back(n->f);
+                }
+                s.a = lit->second;
+            }
+            else {
+                s.a = flatten(n->a.get(), done, leafmap);
+                if (n->b) s.b = flatten(n->b.get(), done, leafmap);
+            }
+            program.push_back(s);
+            return done[n] = int(program.size()) - 1;
+        }
+
+        /// Evaluates the program on the values of the functions in box \c key
+        tensorT evaluate(const keyT& key, const std::vector<tensorT>& values) const {
+            std::vector<tensorT> v(program.size());
+            for (std::size_t i=0; i<program.size(); ++i) {
+                const Step& s = program[i];
+                switch (s.kind) {
+                case exprnodeT::LEAF:
+                    v[i] = values[s.a];
+                    break;
+                case exprnodeT::MUL:
+                    v[i] = copy(v[s.a]).emul(v[s.b]);
+                    break;
+                case exprnodeT::GAXPY:
+                    v[i] = copy(v[s.a]).gaxpy(s.alpha, v[s.b], s.beta);
+                    break;
+                case exprnodeT::SCALE:
+                    v[i] = v[s.a]*s.alpha;
+                    break;
+                case exprnodeT::UNARY:
+                    v[i] = (*s.op)(key, v[s.a]);
+                    break;
+                }
+            }
+            return v.back();
+        }
+
+    public:
+        /// Makes the program of \c expr, whose result goes to \c result (collective)
+        FunctionExprImpl(const exprT& expr, const std::shared_ptr<implT>& result)
+            : WorldObject<exprimplT>(result->world), result(result), expr(expr)
+        {
+            std::map<const exprnodeT*,int> done;
+            std::map<const implT*,int> leafmap;
+            flatten(expr.get_node().get(), done, leafmap);
+            for (std::size_t i=0; i<leaves.size(); ++i) {
+                MADNESS_ASSERT(leaves[i].k() == result->get_k());
+                MADNESS_ASSERT(!leaves[i].is_compressed());
+            }
+            this->process_pending();
+        }
+
+        /// Evaluates the expression in box \c key and below
+
+        /// \param[in] key The box.
+        /// \param[in] cin For each function the coefficients in this box
+        ///     refined from a leaf above, or empty if the box is in its tree.
+        void descend(const keyT& key, const std::vector<tensorT>& cin) const {
+            const FunctionCommonData<T,NDIM>& cdata = result->get_cdata();
+            std::vector<tensorT> c = cin;
+            if (c.empty()) c.resize(leaves.size());
+
+            bool isleaf = true;
+            for (std::size_t i=0; i<leaves.size(); ++i) {
+                if (c[i].size() == 0) {
+                    typename dcT::const_iterator it = leaves[i].get_impl()->get_coeffs().find(key).get();
+                    MADNESS_ASSERT(it != leaves[i].get_impl()->get_coeffs().end());
+                    if (it->second.has_coeff())
+                        c[i] = it->second.coeff().full_tensor_copy();
+                    else if (!it->second.has_children())
+                        c[i] = tensorT(cdata.vk); // Zero leaf
+                }
+                if (c[i].size() == 0) isleaf = false;
+            }
+
+            if (isleaf) {
+                std::vector<tensorT> values(leaves.size());
+                for (std::size_t i=0; i<leaves.size(); ++i)
+                    values[i] = result->coeffs2values(key, c[i]);
+                const tensorT r = result->values2coeffs(key, evaluate(key, values));
+                result->get_coeffs().replace(key, nodeT(coeffT(r, result->get_tensor_args()), false));
+                return;
+            }
+
+            // Recur down, refining the functions that are already at a leaf
+            result->get_coeffs().replace(key, nodeT(coeffT(), true)); // Interior node
+            std::vector<tensorT> ss(leaves.size());
+            for (std::size_t i=0; i<leaves.size(); ++i) {
+                if (c[i].size()) {
+                    tensorT d(cdata.v2k);
+                    d(cdata.s0) = c[i](___);
+                    ss[i] = result->unfilter(d);
+                }
+            }
+            for (KeyChildIterator<NDIM> kit(key); kit; ++kit) {
+                const keyT& child = kit.key();
+                std::vector<tensorT> cc(leaves.size());
+                for (std::size_t i=0; i<leaves.size(); ++i)
+                    if (ss[i].size()) cc[i] = copy(ss[i](result->child_patch(child)));
+                this->task(result->get_coeffs().owner(child), &exprimplT::descend, child, cc);
+            }
+        }
+    };
+
+
+    namespace detail {
+        /// Reconstructs the functions of an expression without fencing
+
+        /// \return A function of the expression.
+        template <typename T, std::size_t NDIM>
+        const Function<T,NDIM>& reconstruct_expr(const typename FunctionExpr<T,NDIM>::Node* n) {
+            typedef typename FunctionExpr<T,NDIM>::Node nodeT;
+            if (n->kind == nodeT::LEAF) {
+                if (n->f.is_compressed()) n->f.reconstruct(false);
+                return n->f;
+            }
+            if (n->b) reconstruct_expr<T,NDIM>(n->b.get());
+            return reconstruct_expr<T,NDIM>(n->a.get());
+        }
+    }
+
+    template <typename T, std::size_t NDIM>
+    Function<T,NDIM> FunctionExpr<T,NDIM>::materialize() const {
+        PROFILE_MEMBER_FUNC(FunctionExpr);
+        const functionT& f = detail::reconstruct_expr<T,NDIM>(node.get());
+        World& world = f.world();
+        world.gop.fence();
+
+        functionT result;
+        result.set_impl(f, false);
+        {
+            FunctionExprImpl<T,NDIM> impl(*this, result.get_impl());
+            const Key<NDIM>& key0 = result.get_impl()->get_cdata().key0;
+            if (world.rank() == result.get_impl()->get_coeffs().owner(key0))
+                impl.descend(key0, std::vector< Tensor<T> >());
+            world.gop.fence();
+        }
+        return result;
+    }
+
+
+    /// Starts a lazy expression with function \c f
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> lazy(const Function<T,NDIM>& f) {
+        return FunctionExpr<T,NDIM>(f);
+    }
+
+    /// Lazy pointwise operation \c op on the values of an expression
+    template <typename T, std::size_t NDIM, typename opT>
+    FunctionExpr<T,NDIM> lazy_unary_op(const FunctionExpr<T,NDIM>& e, const opT& op) {
+        return FunctionExpr<T,NDIM>::unary(op, e);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator*(const FunctionExpr<T,NDIM>& a, const FunctionExpr<T,NDIM>& b) {
+        return FunctionExpr<T,NDIM>::mul(a, b);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator*(const FunctionExpr<T,NDIM>& a, const Function<T,NDIM>& b) {
+        return FunctionExpr<T,NDIM>::mul(a, b);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator*(const Function<T,NDIM>& a, const FunctionExpr<T,NDIM>& b) {
+        return FunctionExpr<T,NDIM>::mul(a, b);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator*(const typename FunctionExpr<T,NDIM>::scalarT alpha, const FunctionExpr<T,NDIM>& a) {
+        return FunctionExpr<T,NDIM>::scale(alpha, a);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator*(const FunctionExpr<T,NDIM>& a, const typename FunctionExpr<T,NDIM>::scalarT alpha) {
+        return FunctionExpr<T,NDIM>::scale(alpha, a);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator+(const FunctionExpr<T,NDIM>& a, const FunctionExpr<T,NDIM>& b) {
+        return FunctionExpr<T,NDIM>::gaxpy(T(1.0), a, T(1.0), b);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator+(const FunctionExpr<T,NDIM>& a, const Function<T,NDIM>& b) {
+        return FunctionExpr<T,NDIM>::gaxpy(T(1.0), a, T(1.0), b);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator+(const Function<T,NDIM>& a, const FunctionExpr<T,NDIM>& b) {
+        return FunctionExpr<T,NDIM>::gaxpy(T(1.0), a, T(1.0), b);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator-(const FunctionExpr<T,NDIM>& a, const FunctionExpr<T,NDIM>& b) {
+        return FunctionExpr<T,NDIM>::gaxpy(T(1.0), a, T(-1.0), b);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator-(const FunctionExpr<T,NDIM>& a, const Function<T,NDIM>& b) {
+        return FunctionExpr<T,NDIM>::gaxpy(T(1.0), a, T(-1.0), b);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator-(const Function<T,NDIM>& a, const FunctionExpr<T,NDIM>& b) {
+        return FunctionExpr<T,NDIM>::gaxpy(T(1.0), a, T(-1.0), b);
+    }
+
+    template <typename T, std::size_t NDIM>
+    FunctionExpr<T,NDIM> operator-(const FunctionExpr<T,NDIM>& a) {
+        return FunctionExpr<T,NDIM>::scale(T(-1.0), a);
+    }
+
+}
+
+#endif // MADNESS_MRA_FUNCTION_EXPRESSION_H__INCLUDED
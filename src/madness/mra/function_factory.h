@@ -98,6 +98,7 @@ namespace madness {
         bool _fence;
         bool _is_on_demand;
         bool _compressed;
+        bool _flat_storage;
         //Tensor<int> _bc;
         std::shared_ptr<WorldDCPmapInterface<Key<NDIM> > > _pmap;
         
@@ -129,6 +130,7 @@ namespace madness {
             _fence(true), // _bc(FunctionDefaults<NDIM>::get_bc()),
             _is_on_demand(false),
             _compressed(false),
+            _flat_storage(false),
             _pmap(FunctionDefaults<NDIM>::get_pmap()), _functor() {
         }
 
@@ -260,6 +262,12 @@ namespace madness {
             _pmap = pmap;
             return self();
         }
+        /// Store the tree in open-addressing shards, keeping siblings together
+        FunctionFactory&
+        flat_storage(bool flat = true) {
+            _flat_storage = flat;
+            return self();
+        }
         
         int get_k() const {return _k;};
         double get_thresh() const {return _thresh;};
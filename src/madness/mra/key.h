@@ -396,6 +396,14 @@ namespace madness {
         }
     };
 
+    /// The 2^NDIM children of a node form a family
+    template<std::size_t NDIM>
+    struct HashFamily< Key<NDIM> > {
+        static Key<NDIM> family(const Key<NDIM>& key) {
+            return key.level() ? key.parent() : key;
+        }
+    };
+
     /// Applies op(key) to each child key of parent
     template<std::size_t NDIM, typename opT>
     inline void
@@ -211,6 +211,45 @@ namespace madness {
             return result;
         }
 
+        /// Evaluates the function at many points in user coordinates.  Possible non-blocking comm.
+
+        /// Only the invoking process will receive the values via the
+        /// future, in the order of \c xuser, though other processes
+        /// may be involved in the evaluation.  The points are routed
+        /// down the tree together and each leaf box evaluates all of
+        /// its points at once, so this is much faster than calling
+        /// eval() point by point.
+        ///
+        /// Throws if function is not initialized.
+        Future< Tensor<T> > eval(const std::vector<coordT>& xuser) const {
+            PROFILE_MEMBER_FUNC(Function);
+            const double eps=1e-15;
+            verify();
+            MADNESS_ASSERT(!is_compressed());
+            std::vector<coordT> xsim(xuser.size());
+            for (std::size_t i=0; i<xuser.size(); ++i) {
+                user_to_sim(xuser[i],xsim[i]);
+                // If on the boundary, move the point just inside the
+                // volume so that the evaluation logic does not fail
+                for (std::size_t d=0; d<NDIM; ++d) {
+                    if (xsim[i][d] < -eps) {
+                        MADNESS_EXCEPTION("eval: coordinate lower-bound error in dimension", d);
+                    }
+                    else if (xsim[i][d] < eps) {
+                        xsim[i][d] = eps;
+                    }
+
+                    if (xsim[i][d] > 1.0+eps) {
+                        MADNESS_EXCEPTION("eval: coordinate upper-bound error in dimension", d);
+                    }
+                    else if (xsim[i][d] > 1.0-eps) {
+                        xsim[i][d] = 1.0-eps;
+                    }
+                }
+            }
+            return impl->eval_points(impl->key0(), xsim);
+        }
+
         /// Evaluate function only if point is local returning (true,value); otherwise return (false,0.0)
 
         /// maxlevel is the maximum depth to search down to --- the max local depth can be
@@ -377,6 +416,22 @@ namespace madness {
             return result;
         }
 
+        /// Evaluates the function at many points in user coordinates.  Collective operation.
+
+        /// Throws if function is not initialized.
+        ///
+        /// Process 0 evaluates all points with the batched eval() and
+        /// broadcasts the values to everyone.
+        Tensor<T> operator()(const std::vector<coordT>& xuser) const {
+            PROFILE_MEMBER_FUNC(Function);
+            verify();
+            if (is_compressed()) reconstruct();
+            Tensor<T> result;
+            if (impl->world.rank() == 0) result = eval(xuser).get();
+            impl->world.gop.broadcast_serializable(result, 0);
+            return result;
+        }
+
         /// Evaluates the function at a point in user coordinates.  Collective operation.
 
         /// See "operator()(const coordT& xuser)" for more info
@@ -2295,6 +2350,13 @@ namespace madness {
                 f.store(ar);
             }
         };
+
+        template <class T, std::size_t NDIM>
+        struct ArchiveStoreImpl< AsyncParallelOutputArchive, Function<T,NDIM> > {
+            static inline void store(const AsyncParallelOutputArchive& ar, const Function<T,NDIM>& f) {
+                f.store(ar);
+            }
+        };
     }
 
     template <class T, std::size_t NDIM>
@@ -2309,6 +2371,22 @@ namespace madness {
         ar2 & f;
     }
 
+    /// Saves a function without waiting for the disk; read it back with \c load()
+
+    /// The local coefficients are copied into memory and written by a
+    /// background thread (see \c archive::AsyncParallelOutputArchive).
+    /// The function must have no pending operations, but may be modified
+    /// as soon as this returns.
+    /// @param[in]  f       the function to save
+    /// @param[in]  name    base name of the files
+    /// @return     a future assigned once this process's file is written
+    template <class T, std::size_t NDIM>
+    Future<bool> save_async(const Function<T,NDIM>& f, const std::string name) {
+        archive::AsyncParallelOutputArchive ar2(f.world(), name.c_str());
+        ar2 & f;
+        return ar2.close();
+    }
+
 }
 /* @} */
 
@@ -2316,6 +2394,7 @@ namespace madness {
 #include <madness/mra/operator.h>
 #include <madness/mra/functypedefs.h>
 #include <madness/mra/vmra.h>
+#include <madness/mra/function_expression.h>
 // #include <madness/mra/mraimpl.h> !!!!!!!!!!!!! NOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOO  !!!!!!!!!!!!!!!!!!
 
 #endif // MADNESS_MRA_MRA_H__INCLUDED
@@ -72,6 +72,11 @@ namespace madness {
     template <> volatile std::list<detail::PendingMsg> WorldObject<WorldContainerImpl<Key<2>, LBNodeDeux<2>, Hash<Key<2> > > >::pending = std::list<detail::PendingMsg>();
     template <>  Spinlock WorldObject<WorldContainerImpl<Key<2>, LBNodeDeux<2>, Hash<Key<2> > > >::pending_mutex(0);
 
+    template <> volatile std::list<detail::PendingMsg> WorldObject<FunctionExprImpl<double,2> >::pending = std::list<detail::PendingMsg>();
+    template <> Spinlock WorldObject<FunctionExprImpl<double,2> >::pending_mutex(0);
+    template <> volatile std::list<detail::PendingMsg> WorldObject<FunctionExprImpl<std::complex<double>,2> >::pending = std::list<detail::PendingMsg>();
+    template <> Spinlock WorldObject<FunctionExprImpl<std::complex<double>,2> >::pending_mutex(0);
+
     // These implicit instantiations must be below the explicit ones above in order not to offend LLVM
     template class FunctionDefaults<2>;
     template class Function<double, 2>;
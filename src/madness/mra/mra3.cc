@@ -74,6 +74,11 @@ namespace madness {
     template <> volatile std::list<detail::PendingMsg> WorldObject<WorldContainerImpl<Key<3>, LBNodeDeux<3>, Hash<Key<3> > > >::pending = std::list<detail::PendingMsg>();
     template <>  Spinlock WorldObject<WorldContainerImpl<Key<3>, LBNodeDeux<3>, Hash<Key<3> > > >::pending_mutex(0);
 
+    template <> volatile std::list<detail::PendingMsg> WorldObject<FunctionExprImpl<double,3> >::pending = std::list<detail::PendingMsg>();
+    template <> Spinlock WorldObject<FunctionExprImpl<double,3> >::pending_mutex(0);
+    template <> volatile std::list<detail::PendingMsg> WorldObject<FunctionExprImpl<std::complex<double>,3> >::pending = std::list<detail::PendingMsg>();
+    template <> Spinlock WorldObject<FunctionExprImpl<std::complex<double>,3> >::pending_mutex(0);
+
     // These implicit instantiations must be below the explicit ones above in order not to offend LLVM
     template class FunctionDefaults<3>;
     template class Function<double, 3>;
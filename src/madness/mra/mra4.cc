@@ -74,6 +74,11 @@ namespace madness {
     template <> volatile std::list<detail::PendingMsg> WorldObject<WorldContainerImpl<Key<4>, LBNodeDeux<4>, Hash<Key<4> > > >::pending = std::list<detail::PendingMsg>();
     template <>  Spinlock WorldObject<WorldContainerImpl<Key<4>, LBNodeDeux<4>, Hash<Key<4> > > >::pending_mutex(0);
 
+    template <> volatile std::list<detail::PendingMsg> WorldObject<FunctionExprImpl<double,4> >::pending = std::list<detail::PendingMsg>();
+    template <> Spinlock WorldObject<FunctionExprImpl<double,4> >::pending_mutex(0);
+    template <> volatile std::list<detail::PendingMsg> WorldObject<FunctionExprImpl<std::complex<double>,4> >::pending = std::list<detail::PendingMsg>();
+    template <> Spinlock WorldObject<FunctionExprImpl<std::complex<double>,4> >::pending_mutex(0);
+
     // These implicit instantiations must be below the explicit ones above in order not to offend LLVM
     template class FunctionDefaults<4>;
     template class Function<double, 4>;
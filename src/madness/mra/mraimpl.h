@@ -2758,6 +2758,135 @@ namespace madness {
     }
 
 
+    template <typename T, std::size_t NDIM>
+    Future< Tensor<T> > FunctionImpl<T,NDIM>::eval_points(const keyT& keyin,
+                                                          const std::vector<coordT>& xsim) const {
+        PROFILE_MEMBER_FUNC(FunctionImpl);
+        if (xsim.empty()) return Future< Tensor<T> >(Tensor<T>());
+        const ProcessID me = world.rank();
+        keyT key = keyin;
+        while (1) {
+            ProcessID owner = coeffs.owner(key);
+            if (owner != me) {
+                return woT::task(owner, &implT::eval_points, key, xsim, TaskAttributes::hipri());
+            }
+
+            typename dcT::const_iterator it = coeffs.find(key).get();
+            MADNESS_ASSERT(it != coeffs.end());
+            const nodeT& node = it->second;
+            if (node.has_coeff()) {
+                return Future< Tensor<T> >(eval_points_leaf(key, xsim, node.coeff().full_tensor_copy()));
+            }
+
+            // Sort the points into the children of this box
+            const Level n = key.level() + 1;
+            const double twon = std::pow(2.0, double(n));
+            const Vector<Translation,NDIM>& l = key.translation();
+            const std::size_t nchild = std::size_t(1) << NDIM;
+            std::vector< std::vector<long> > index(nchild);
+            for (std::size_t i=0; i<xsim.size(); ++i) {
+                std::size_t ichild = 0;
+                for (std::size_t d=0; d<NDIM; ++d) {
+                    Translation li = Translation(xsim[i][d]*twon);
+                    if (li > 2*l[d]) ichild |= (std::size_t(1) << d);
+                }
+                index[ichild].push_back(i);
+            }
+
+            std::vector< Future< Tensor<T> > > v;
+            std::vector< std::vector<long> > vindex;
+            for (std::size_t ichild=0; ichild<nchild; ++ichild) {
+                if (index[ichild].empty()) continue;
+                Vector<Translation,NDIM> lchild;
+                for (std::size_t d=0; d<NDIM; ++d) lchild[d] = 2*l[d] + ((ichild >> d) & 1);
+                keyT child(n, lchild);
+
+                // All points in one child keep their order, so just descend
+                if (index[ichild].size() == xsim.size()) {
+                    key = child;
+                    break;
+                }
+
+                std::vector<coordT> xchild(index[ichild].size());
+                for (std::size_t i=0; i<xchild.size(); ++i) xchild[i] = xsim[index[ichild][i]];
+                v.push_back(eval_points(child, xchild));
+                vindex.push_back(index[ichild]);
+            }
+            if (v.empty()) continue;
+
+            bool ready = true;
+            for (std::size_t i=0; i<v.size(); ++i) ready = ready && v[i].probe();
+            if (ready) return Future< Tensor<T> >(eval_points_gather(xsim.size(), vindex, v));
+            return woT::task(me, &implT::eval_points_gather, long(xsim.size()), vindex, v);
+        }
+    }
+
+
+    template <typename T, std::size_t NDIM>
+    Tensor<T> FunctionImpl<T,NDIM>::eval_points_gather(long npt,
+                                                       const std::vector< std::vector<long> >& index,
+                                                       const std::vector< Future< Tensor<T> > >& v) const {
+        Tensor<T> r(npt);
+        for (std::size_t i=0; i<v.size(); ++i) {
+            const Tensor<T>& vi = v[i].get();
+            const std::vector<long>& ind = index[i];
+            for (std::size_t j=0; j<ind.size(); ++j) r(ind[j]) = vi(j);
+        }
+        return r;
+    }
+
+
+    template <typename T, std::size_t NDIM>
+    Tensor<T> FunctionImpl<T,NDIM>::eval_points_leaf(const keyT& key,
+                                                     const std::vector<coordT>& xsim,
+                                                     const tensorT& c) const {
+        PROFILE_MEMBER_FUNC(FunctionImpl);
+        const int k = cdata.k;
+        const long npt = xsim.size();
+        const Level n = key.level();
+        const double twon = std::pow(2.0, double(n));
+        const Vector<Translation,NDIM>& l = key.translation();
+
+        // Scaling functions of every point in every dimension, phi[d](i,p)
+        std::vector< Tensor<double> > phi(NDIM);
+        for (std::size_t d=0; d<NDIM; ++d) {
+            phi[d] = Tensor<double>(npt,long(k));
+            for (long i=0; i<npt; ++i) {
+                double x = xsim[i][d]*twon - l[d];
+                if (x < 0.0) x = 0.0;
+                else if (x > 1.0) x = 1.0;
+                legendre_scaling_functions(x, k, &phi[d](i,0L));
+            }
+        }
+
+        // Contract the first dimension for all points at once with one
+        // matrix product, r(i,q,...) = sum_p phi[0](i,p) c(p,q,...) ...
+        Tensor<T> r = inner(phi[0], c);
+
+        // ... then the remaining dimensions point by point
+        long rest = c.size()/k;
+        for (std::size_t d=1; d<NDIM; ++d) {
+            rest /= k;
+            Tensor<T> s(npt, rest);
+            const T* restrict rp = r.ptr();
+            T* restrict sp = s.ptr();
+            for (long i=0; i<npt; ++i) {
+                const double* restrict p = phi[d].ptr() + i*k;
+                const T* restrict ri = rp + i*k*rest;
+                T* restrict si = sp + i*rest;
+                for (int q=0; q<k; ++q) {
+                    for (long j=0; j<rest; ++j) si[j] += p[q]*ri[q*rest+j];
+                }
+            }
+            r = s;
+        }
+
+        r = r.reshape(npt);
+        r.scale(pow(2.0,0.5*NDIM*n)/sqrt(FunctionDefaults<NDIM>::get_cell_volume()));
+        return r;
+    }
+
+
     template <typename T, std::size_t NDIM>
     std::pair<bool,T>
     FunctionImpl<T,NDIM>::eval_local_only(const Vector<double,NDIM>& xin, Level maxlevel) {
@@ -3226,6 +3355,8 @@ namespace madness {
 
         function.verify();
         World& world = const_cast< Function<T,NDIM>& >(function).world();
+        long npoint = 1;
+        for (std::size_t d=0; d<NDIM; ++d) npoint *= npt[d];
         FILE *f=0;
         if (world.rank() == 0) {
             f = fopen(filename, "w");
@@ -3257,32 +3388,60 @@ namespace madness {
             fprintf(f, "attribute \"ref\" string \"positions\"\n");
             fprintf(f,"\n");
 
-            int npoint = 1;
-            for (std::size_t d=0; d<NDIM; ++d) npoint *= npt[d];
             const char* iscomplex = "";
             if (TensorTypeData<T>::iscomplex) iscomplex = "category complex";
             const char* isbinary = "";
             if (binary) isbinary = "binary";
-            fprintf(f,"object 3 class array type double %s rank 0 items %d %s data follows\n",
+            fprintf(f,"object 3 class array type double %s rank 0 items %ld %s data follows\n",
                     iscomplex, npoint, isbinary);
         }
 
-        world.gop.fence();
-        Tensor<T> r = function.eval_cube(cell, npt);
-
-        if (world.rank() == 0) {
-            if (binary) {
-                // This assumes that the values are double precision
+        function.reconstruct();
+        if (binary) {
+            // Each process evaluates a contiguous range of the values and
+            // writes it in place after the header written by process 0
+            long offset = 0;
+            if (world.rank() == 0) {
                 fflush(f);
-                fwrite((void *) r.ptr(), sizeof(T), r.size(), f);
-                fflush(f);
-            }
-            else {
-                for (IndexIterator it(npt); it; ++it) {
-                    //fprintf(f,"%.6e\n",r(*it));
-                    dxprintvalue(f,r(*it));
+                offset = ftell(f);
+                fclose(f);
+            }
+            world.gop.broadcast(offset, 0);
+
+            const long nproc = world.size();
+            const long begin = (npoint*world.rank())/nproc;
+            const long end = (npoint*(world.rank()+1))/nproc;
+            if (end > begin) {
+                FILE* fp = fopen(filename, "r+b");
+                if (!fp) MADNESS_EXCEPTION("plotdx: failed to open the plot file", 0);
+                fseek(fp, offset + begin*long(sizeof(T)), SEEK_SET);
+                for (long lo=begin; lo<end; lo+=detail::plot_chunk_size) {
+                    const long hi = std::min(end, lo+detail::plot_chunk_size);
+                    Tensor<T> r = detail::plot_grid_values(function, cell, npt, lo, hi, false);
+                    // This assumes that the values are double precision
+                    fwrite((void *) r.ptr(), sizeof(T), r.size(), fp);
                 }
+                fclose(fp);
             }
+            world.gop.fence();
+
+            if (world.rank() == 0) {
+                f = fopen(filename, "r+b");
+                if (!f) MADNESS_EXCEPTION("plotdx: failed to open the plot file", 0);
+                fseek(f, offset + npoint*long(sizeof(T)), SEEK_SET);
+            }
+        }
+        else if (world.rank() == 0) {
+            // The points are still evaluated by the owners of the leaves,
+            // one chunk at a time so that the whole cube is never stored
+            for (long lo=0; lo<npoint; lo+=detail::plot_chunk_size) {
+                const long hi = std::min(npoint, lo+detail::plot_chunk_size);
+                Tensor<T> r = detail::plot_grid_values(function, cell, npt, lo, hi, false);
+                for (long i=0; i<r.size(); ++i) dxprintvalue(f,r(i));
+            }
+        }
+
+        if (world.rank() == 0) {
             fprintf(f,"\n");
 
             fprintf(f,"object \"%s\" class field\n",filename);
@@ -72,6 +72,8 @@ std::string help = "\n\
       .   text              // Text output for volume data [default is binary] \n\
       .   dx                // Specifies DX format for volume data [default is dx] \n\
       .   vtk <str function_name> // Specifies VTK format for volume data [default is dx], giving the function name function_name \n\
+      .   vti <str function_name> // Specifies parallel VTK image format for volume data [default is dx]; \n\
+      .                     // writes output.pvti and one output_<rank>.vti piece per process \n\
       .   real              // Sets data type to real, default is real \n\
       .   complex           // Sets data type to complex, default is real \n\
       .   line              // Sets plot type to line, default is volume \n\
@@ -220,6 +222,13 @@ public:
                 if(!(input >> function_name))
                     MADNESS_EXCEPTION("VTK format requires a function name", 0);
             }
+            else if (token == "vti") {
+                output_format = "vti";
+
+                // get the name of the function
+                if(!(input >> function_name))
+                    MADNESS_EXCEPTION("VTI format requires a function name", 0);
+            }
             else if (token == "input") {
                 input >> input_filename;
             }
@@ -326,6 +335,18 @@ public:
                 output_filename.c_str(), plotlo, plothi, numpt, binary);
             plotvtk_end<NDIM>(world, output_filename.c_str(), binary);
         }
+        else if(output_format == "vti") {
+            Vector<double, NDIM> plotlo, plothi;
+            Vector<long, NDIM> numpt;
+            for(std::size_t i = 0; i < NDIM; ++i) {
+                plotlo[i] = plot_cell(i, 0);
+                plothi[i] = plot_cell(i, 1);
+                numpt[i] = npt[i];
+            }
+
+            plotvti(f, function_name, output_filename, plotlo, plothi, numpt,
+                binary);
+        }
     }
 
 
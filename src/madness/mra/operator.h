@@ -39,6 +39,7 @@
 
 #include <type_traits>
 #include <limits.h>
+#include <map>
 #include <madness/mra/adquad.h>
 #include <madness/tensor/aligned.h>
 #include <madness/tensor/tensor_lapack.h>
@@ -148,6 +149,10 @@ namespace madness {
         mutable SimpleCache< SeparatedConvolutionData<Q,NDIM>, NDIM > data; ///< cache for all terms, dims and displacements
         mutable SimpleCache< SeparatedConvolutionData<Q,NDIM>, 2*NDIM > mod_data; ///< cache for all terms, dims and displacements
 
+        /// Operator holding all terms of this one whose displacement data is shared (see share_terms)
+        std::shared_ptr< const SeparatedConvolution<Q,NDIM> > shared_terms;
+        std::vector<int> shared_index;  ///< Term of shared_terms for each term of this operator
+
     public:
 
         bool& modified() {return modified_;}
@@ -179,6 +184,75 @@ namespace madness {
             const Q* VT;
         };
 
+        /// Separated terms whose last transformation is deferred and summed
+
+        /// The partial results of the terms (all transformations but the
+        /// last) are stacked in \c w and the matrices of their last
+        /// transformation, scaled by the factor of the term, in \c m.
+        /// \c flush() then sums all terms with a single \c mTxmq whose inner
+        /// dimension runs over the stacked terms, so that the sum over terms
+        /// is accumulated in registers and \c result is updated once per
+        /// batch instead of once per term.
+        template <typename R>
+        struct TransformationBatch {
+            long dimk;          ///< Extent of each dimension of the result
+            long dimi;          ///< dimk^(NDIM-1)
+            long nrow;          ///< Rows of w and m in use
+            Tensor<R> w;        ///< Stacked partial results, (nrow,dimi) in use
+            Tensor<Q> m;        ///< Stacked scaled last matrices, (nrow,dimk) in use
+            Tensor<R> work;     ///< Sum of the batch before it is added to result
+            Tensor<R>& result;  ///< Accumulates the sum of all terms
+
+            TransformationBatch(long dimk, Tensor<R>& result)
+                : dimk(dimk), dimi(1), nrow(0), result(result) {
+                for (std::size_t d=1; d<NDIM; ++d) dimi *= dimk;
+            }
+
+            ~TransformationBatch() {
+                flush();
+            }
+
+            /// Maximum number of stacked rows (zero until first used)
+            long capacity() const {
+                return m.size() ? m.dim(0) : 0;
+            }
+
+            /// Allocate the buffers on first use
+
+            /// The stacked partial results are kept within about 256 kB so
+            /// that they stay in cache, but at least one term always fits.
+            void reserve() {
+                if (capacity()) return;
+                const long maxrow = std::max(dimk, ((32768/long(sizeof(R)/sizeof(double)))/dimi/dimk)*dimk);
+                const long dw[2] = {maxrow, dimi}, dm[2] = {maxrow, dimk}, dr[2] = {dimi, dimk};
+                w = Tensor<R>(2, dw, false);
+                m = Tensor<Q>(2, dm, false);
+                work = Tensor<R>(2, dr, false);
+            }
+
+            /// Add the terms in the batch to result and empty the batch
+            void flush() {
+                if (nrow == 0) return;
+                mTxmq(dimi, dimk, nrow, work.ptr(), w.ptr(), m.ptr());
+                aligned_axpy(dimi*dimk, result.ptr(), work.ptr(), 1.0);
+                nrow = 0;
+            }
+        };
+
+        /// Results of several sources that are transformed together
+
+        /// The input coefficients of all sources are stacked with the source
+        /// as the last (fastest) index, i.e. as (dimk,...,dimk,nsrc), so that
+        /// each transformation is a single matrix multiplication over all
+        /// sources.  \c result holds the results as (nsrc,dimk,...,dimk).
+        template <typename R>
+        struct StackedResult {
+            long nsrc;          ///< Number of stacked sources
+            Tensor<R>& result;  ///< Accumulates the results of all sources
+
+            StackedResult(long nsrc, Tensor<R>& result) : nsrc(nsrc), result(result) {}
+        };
+
 //        /// return the right block of the upsampled operator (modified NS only)
 //
 //        /// unlike the operator matrices on the natural level the upsampled operator
@@ -275,6 +349,136 @@ namespace madness {
         }
 
 
+        /// accumulate into a batch, deferring the last transformation
+
+        /// Falls back to accumulating directly into the result of the batch
+        /// if the last step is not a matrix multiplication (i.e., a transpose
+        /// because only other dimensions are low rank), if NDIM==1, or if
+        /// the batch was set up for a different block size.
+        template <typename T, typename R>
+        void apply_transformation(long dimk,
+                                  const Transformation trans[NDIM],
+                                  const Tensor<T>& f,
+                                  Tensor<R>& work1,
+                                  Tensor<R>& work2,
+                                  const Q mufac,
+                                  TransformationBatch<R>& batch) const {
+
+            bool doit = false;
+            for (std::size_t d=0; d<NDIM; ++d) doit = doit || trans[d].VT;
+
+#ifndef HAVE_IBMBGQ
+            if (NDIM > 1 && batch.dimk == dimk && (trans[NDIM-1].VT || !doit)) {
+
+                // Contracted dimension and matrix of the deferred last step
+                const long nrow = doit ? trans[NDIM-1].r : dimk;
+                const Q* restrict mlast = doit ? trans[NDIM-1].VT : trans[NDIM-1].U;
+
+                batch.reserve();
+                if (batch.nrow + nrow > batch.capacity()) batch.flush();
+                R* restrict slot = batch.w.ptr() + batch.nrow*batch.dimi;
+
+                long size = 1;
+                for (std::size_t i=0; i<NDIM; ++i) size *= dimk;
+                long dimi = size/dimk;
+
+                R* restrict w1=work1.ptr();
+                R* restrict w2=work2.ptr();
+
+                // Same steps as above; the one before the last writes into the batch
+                const std::size_t nstep = doit ? 2*NDIM : NDIM;
+                std::size_t step = 1;
+
+                mTxmq(dimi, trans[0].r, dimk, (step==nstep-1) ? slot : w1, f.ptr(), trans[0].U, dimk);
+                size = trans[0].r * size / dimk;
+                dimi = size/dimk;
+                for (std::size_t d=1; d<NDIM && step<nstep-1; ++d) {
+                    ++step;
+                    mTxmq(dimi, trans[d].r, dimk, (step==nstep-1) ? slot : w2, w1, trans[d].U, dimk);
+                    size = trans[d].r * size / dimk;
+                    dimi = size/dimk;
+                    std::swap(w1,w2);
+                }
+
+                for (std::size_t d=0; step<nstep-1; ++d) {
+                    ++step;
+                    R* out = (step==nstep-1) ? slot : w2;
+                    if (trans[d].VT) {
+                        dimi = size/trans[d].r;
+                        mTxmq(dimi, dimk, trans[d].r, out, w1, trans[d].VT);
+                        size = dimk*size/trans[d].r;
+                    }
+                    else {
+                        fast_transpose(dimk, dimi, w1, out);
+                    }
+                    std::swap(w1,w2);
+                }
+
+                Q* restrict mrow = batch.m.ptr() + batch.nrow*dimk;
+                for (long i=0; i<nrow*dimk; ++i) mrow[i] = mufac*mlast[i];
+                batch.nrow += nrow;
+                return;
+            }
+#endif
+            apply_transformation(dimk, trans, f, work1, work2, mufac, batch.result);
+        }
+
+
+        /// accumulate into the results of stacked sources
+
+        /// Same steps as above with the source index carried along in the
+        /// rows of every matrix multiplication.  After the first sweep over
+        /// the dimensions the source index is the first one, so a transpose
+        /// moves it back to the end before the sweep with the low rank
+        /// factors.
+        template <typename T, typename R>
+        void apply_transformation(long dimk,
+                                  const Transformation trans[NDIM],
+                                  const Tensor<T>& f,
+                                  Tensor<R>& work1,
+                                  Tensor<R>& work2,
+                                  const Q mufac,
+                                  StackedResult<R>& stack) const {
+
+            long size = stack.nsrc;
+            for (std::size_t i=0; i<NDIM; ++i) size *= dimk;
+            long dimi = size/dimk;
+
+            R* restrict w1=work1.ptr();
+            R* restrict w2=work2.ptr();
+
+            mTxmq(dimi, trans[0].r, dimk, w1, f.ptr(), trans[0].U, dimk);
+            size = trans[0].r * size / dimk;
+            dimi = size/dimk;
+            for (std::size_t d=1; d<NDIM; ++d) {
+                mTxmq(dimi, trans[d].r, dimk, w2, w1, trans[d].U, dimk);
+                size = trans[d].r * size / dimk;
+                dimi = size/dimk;
+                std::swap(w1,w2);
+            }
+
+            bool doit = false;
+            for (std::size_t d=0; d<NDIM; ++d) doit = doit || trans[d].VT;
+
+            if (doit) {
+                fast_transpose(stack.nsrc, size/stack.nsrc, w1, w2);
+                std::swap(w1,w2);
+                for (std::size_t d=0; d<NDIM; ++d) {
+                    if (trans[d].VT) {
+                        dimi = size/trans[d].r;
+                        mTxmq(dimi, dimk, trans[d].r, w2, w1, trans[d].VT);
+                        size = dimk*size/trans[d].r;
+                    }
+                    else {
+                        fast_transpose(dimk, dimi, w1, w2);
+                    }
+                    std::swap(w1,w2);
+                }
+            }
+            aligned_axpy(size, stack.result.ptr(), w1, mufac);
+        }
+
+
         /// accumulate into result
         template <typename T, typename R>
         void apply_transformation3(const Tensor<T> trans2[NDIM],
@@ -353,12 +557,14 @@ namespace madness {
 
 
         /// Apply one of the separated terms, accumulating into the result
-        template <typename T>
+
+        /// \tparam accT Either \c Tensor<resultT> or \c TransformationBatch<resultT>
+        template <typename T, typename accT>
         void muopxv_fast(ApplyTerms at,
                          const ConvolutionData1D<Q>* const ops_1d[NDIM],
                          const Tensor<T>& f, const Tensor<T>& f0,
-                         Tensor<TENSOR_RESULT_TYPE(T,Q)>& result,
-                         Tensor<TENSOR_RESULT_TYPE(T,Q)>& result0,
+                         accT& result,
+                         accT& result0,
                          double tol,
                          const Q mufac,
                          Tensor<TENSOR_RESULT_TYPE(T,Q)>& work1,
@@ -727,10 +933,21 @@ namespace madness {
 
             // get the data for each term
             SeparatedConvolutionData<Q,NDIM> op(rank);
-            for (int mu=0; mu<rank; ++mu) {
-                // op.muops is of type SeparatedConvolutionInternal (1 term, all dim, 1 disp)
-                // getmuop uses ConvolutionND
-                op.muops[mu] = getmuop(mu, n, d);
+            if (shared_terms) {
+                // Same 1D blocks as the shared terms, only the factors differ
+                const SeparatedConvolutionData<Q,NDIM>* all = shared_terms->getop_ns(n,d);
+                for (int mu=0; mu<rank; ++mu) {
+                    const int i = shared_index[mu];
+                    op.muops[mu] = all->muops[i];
+                    op.muops[mu].norm *= std::abs(ops[mu].getfac()/shared_terms->ops[i].getfac());
+                }
+            }
+            else {
+                for (int mu=0; mu<rank; ++mu) {
+                    // op.muops is of type SeparatedConvolutionInternal (1 term, all dim, 1 disp)
+                    // getmuop uses ConvolutionND
+                    op.muops[mu] = getmuop(mu, n, d);
+                }
             }
 
             double norm = 0.0;
@@ -1036,6 +1253,26 @@ namespace madness {
 
         const BoundaryConditions<NDIM>& get_bc() const {return bc;}
 
+        /// Takes the NS-form displacement data of the terms from another operator
+
+        /// \c terms must contain every term of this operator with the same
+        /// 1D convolutions (term \c mu here is term \c index[mu] there), so
+        /// that only the factors differ and the cached transition matrices
+        /// and term norms of \c terms can be reused after rescaling.  Used by
+        /// BSHOperatorFamily; must be called before the operator is applied.
+        void share_terms(const std::shared_ptr< const SeparatedConvolution<Q,NDIM> >& terms,
+                         const std::vector<int>& index) {
+            MADNESS_ASSERT(terms && index.size() == std::size_t(rank));
+            MADNESS_ASSERT(terms->k == k && terms->isperiodicsum == isperiodicsum);
+            for (int mu=0; mu<rank; ++mu) {
+                MADNESS_ASSERT(index[mu] >= 0 && index[mu] < terms->rank);
+                for (std::size_t d=0; d<NDIM; ++d)
+                    MADNESS_ASSERT(ops[mu].getop(d) == terms->ops[index[mu]].getop(d));
+            }
+            shared_terms = terms;
+            shared_index = index;
+        }
+
         const std::vector< Key<NDIM> >& get_disp(Level n) const {
             return Displacements<NDIM>().get_disp(n, isperiodicsum);
         }
@@ -1160,14 +1397,18 @@ namespace madness {
             }
 
             const Tensor<T> f0 = copy(coeff(s0));
-            for (int mu=0; mu<rank; ++mu) {
-                // SeparatedConvolutionInternal keeps data for 1 term and all dimensions and 1 displacement
-                const SeparatedConvolutionInternal<Q,NDIM>& muop =  op->muops[mu];
-                if (muop.norm > tol) {
-                    // ops is of ConvolutionND, returns data for 1 term and all dimensions
-                    Q fac = ops[mu].getfac();
-                    muopxv_fast(at, muop.ops, *input, f0, r, r0, tol/std::abs(fac), fac,
-                                work1, work2);
+            {
+                // The terms that pass the screening are summed in batches
+                TransformationBatch<resultT> batch(r.dim(0), r), batch0(k, r0);
+                for (int mu=0; mu<rank; ++mu) {
+                    // SeparatedConvolutionInternal keeps data for 1 term and all dimensions and 1 displacement
+                    const SeparatedConvolutionInternal<Q,NDIM>& muop =  op->muops[mu];
+                    if (muop.norm > tol) {
+                        // ops is of ConvolutionND, returns data for 1 term and all dimensions
+                        Q fac = ops[mu].getfac();
+                        muopxv_fast(at, muop.ops, *input, f0, batch, batch0, tol/std::abs(fac), fac,
+                                    work1, work2);
+                    }
                 }
             }
 
@@ -1179,6 +1420,97 @@ namespace madness {
         }
 
 
+        /// apply this operator on the full rank coefficients of several sources in the same box
+
+        /// The operator data for the displacement is looked up and screened
+        /// once, and each separated term transforms the coefficients of all
+        /// sources with one (larger) matrix multiplication per dimension.
+        /// @param[in]  source  the source key
+        /// @param[in]  shift   the displacement, where the source coeffs come from
+        /// @param[in]  coeff   source coeffs in full rank, one tensor per source
+        /// @param[in]  tol     thresh/#neigh/cnorm, using the largest cnorm of the sources
+        /// @return     a tensor of full rank with the result op(coeff[i]) for each source
+        template <typename T>
+        std::vector< Tensor<TENSOR_RESULT_TYPE(T,Q)> > apply(const Key<NDIM>& source,
+                                                             const Key<NDIM>& shift,
+                                                             const std::vector< Tensor<T> >& coeff,
+                                                             double tol) const {
+            typedef TENSOR_RESULT_TYPE(T,Q) resultT;
+
+            const long nsrc = coeff.size();
+            std::vector< Tensor<resultT> > result(nsrc);
+            if (nsrc == 1) result[0] = apply(source, shift, coeff[0], tol);
+            if (nsrc <= 1) return result;
+
+            double cpu0=cpu_time();
+
+            const std::vector<long>& vdimk = modified() ? vk : v2k;
+            const long dimk = vdimk[0];
+            long size = 1, size0 = 1;
+            for (std::size_t d=0; d<NDIM; ++d) {
+                size *= dimk;
+                size0 *= k;
+            }
+
+            // Stack the sources as the last index
+            Tensor<T> f(std::vector<long>(1,size*nsrc),false), f0(std::vector<long>(1,size0*nsrc),false);
+            for (long s=0; s<nsrc; ++s) {
+                MADNESS_ASSERT(coeff[s].ndim()==NDIM);
+                Tensor<T> input;
+                if (not modified() and coeff[s].dim(0) == k) {
+                    input = Tensor<T>(v2k);
+                    input(s0) = coeff[s];
+                }
+                else {
+                    MADNESS_ASSERT(coeff[s].dim(0)==dimk);
+                    input = copy(coeff[s]);
+                }
+                const Tensor<T> input0 = copy(coeff[s](s0));
+
+                const T* restrict p = input.ptr();
+                T* restrict q = f.ptr() + s;
+                for (long i=0; i<size; ++i) q[i*nsrc] = p[i];
+                p = input0.ptr();
+                q = f0.ptr() + s;
+                for (long i=0; i<size0; ++i) q[i*nsrc] = p[i];
+            }
+
+            tol = 0.01*tol/rank; // Error is per separated term
+            ApplyTerms at;
+            at.r_term=true;
+            at.t_term=(source.level()>0);
+
+            const SeparatedConvolutionData<Q,NDIM>* op = getop(source.level(), shift, source);
+
+            Tensor<resultT> r(std::vector<long>(1,size*nsrc)), r0(std::vector<long>(1,size0*nsrc));
+            Tensor<resultT> work1(std::vector<long>(1,size*nsrc),false), work2(std::vector<long>(1,size*nsrc),false);
+            {
+                StackedResult<resultT> stack(nsrc, r), stack0(nsrc, r0);
+                for (int mu=0; mu<rank; ++mu) {
+                    const SeparatedConvolutionInternal<Q,NDIM>& muop =  op->muops[mu];
+                    if (muop.norm > tol) {
+                        Q fac = ops[mu].getfac();
+                        muopxv_fast(at, muop.ops, f, f0, stack, stack0, tol/std::abs(fac), fac,
+                                    work1, work2);
+                    }
+                }
+            }
+
+            // Unstack the results of the sources
+            for (long s=0; s<nsrc; ++s) {
+                result[s] = Tensor<resultT>(vdimk,false);
+                Tensor<resultT> result0(vk,false);
+                std::copy(r.ptr()+s*size, r.ptr()+(s+1)*size, result[s].ptr());
+                std::copy(r0.ptr()+s*size0, r0.ptr()+(s+1)*size0, result0.ptr());
+                result[s](s0).gaxpy(1.0,result0,1.0);
+            }
+            double cpu1=cpu_time();
+            timer_full.accumulate(cpu1-cpu0);
+
+            return result;
+        }
+
+
         /// apply this operator on only 1 particle of the coefficients in low rank form
 
         /// note the unfortunate mess with NDIM: here NDIM is the operator dimension, and FDIM is the
@@ -1246,11 +1578,14 @@ namespace madness {
 
                 // this loop will return on result and result0 the terms [(P+Q) G (P+Q)]_1,
                 // and [P G P]_1, respectively
-                for (int mu=0; mu<rank; ++mu) {
-                    const SeparatedConvolutionInternal<Q,NDIM>& muop =  op->muops[mu];
-                    Q fac = ops[mu].getfac();
-                    muopxv_fast(at, muop.ops, chunk, chunk0, result, result0,
-                            tol/std::abs(fac), fac, work1, work2);
+                {
+                    TransformationBatch<resultT> batch(result.dim(0), result), batch0(k, result0);
+                    for (int mu=0; mu<rank; ++mu) {
+                        const SeparatedConvolutionInternal<Q,NDIM>& muop =  op->muops[mu];
+                        Q fac = ops[mu].getfac();
+                        muopxv_fast(at, muop.ops, chunk, chunk0, batch, batch0,
+                                tol/std::abs(fac), fac, work1, work2);
+                    }
                 }
 
                 // reinsert the transformed terms into result, leaving the other particle unchanged
@@ -1806,6 +2141,123 @@ namespace madness {
     }
 
 
+    /// Makes BSH operators exp(-mu*r)/(4*pi*r) for many mu that share one set of Gaussian terms
+
+    /// The Gaussian expansions made by GFit::BSHFit for different mu lie on
+    /// one quadrature grid whose lower end moves down as mu decreases, so the
+    /// expansion for \c mu_lo contains the exponents of the expansion for any
+    /// mu >= mu_lo.  The family keeps one operator with all those terms (with
+    /// unit factors) and every operator it makes takes its NS-form
+    /// displacement data from it, rescaling the norms by its own
+    /// coefficients (see SeparatedConvolution::share_terms).  The 1D blocks,
+    /// transition matrices and term norms are thus computed once for all
+    /// orbitals and all iterations and stay hot in cache while a vector of
+    /// operators is applied.  Operators still alive are reused for equal mu
+    /// (degenerate orbitals).
+    ///
+    /// Periodic boundary conditions truncate each expansion differently, so
+    /// they and any mu < mu_lo get standalone operators.  Making an operator
+    /// is collective.
+    template <std::size_t NDIM>
+    class BSHOperatorFamily {
+    public:
+        typedef SeparatedConvolution<double,NDIM> operatorT;
+
+    private:
+        World& world;
+        const double mu_lo;
+        const double lo;
+        const double eps;
+        const BoundaryConditions<NDIM> bc;
+        const int k;
+        const bool periodic;
+        std::shared_ptr<operatorT> terms;                        ///< All terms, unit factors
+        std::map<double,int> index;                              ///< Exponent -> term of terms
+        std::map<double, std::weak_ptr<operatorT> > members;     ///< Operators made so far, by mu
+
+        /// Gaussian expansion for mu, as made by the BSH factory functions
+        GFit<double,NDIM> fit(double mu) const {
+            const Tensor<double>& cell_width = FunctionDefaults<NDIM>::get_cell_width();
+            double hi = cell_width.normf(); // Diagonal width of cell
+            if (periodic) hi *= 100; // Extend range for periodic summation
+            return GFit<double,NDIM>::BSHFit(mu, lo, hi, eps, false);
+        }
+
+    public:
+        /// Prepares the terms for all mu >= mu_lo ... collective
+
+        /// @param[in]  mu_lo   smallest mu that will share the terms (must be positive)
+        /// @param[in]  lo      smallest length scale resolved, as for BSHOperatorPtr3D
+        /// @param[in]  eps     precision of the expansions
+        BSHOperatorFamily(World& world, double mu_lo, double lo, double eps,
+                          const BoundaryConditions<NDIM>& bc=FunctionDefaults<NDIM>::get_bc(),
+                          int k=FunctionDefaults<NDIM>::get_k())
+            : world(world), mu_lo(mu_lo), lo(lo), eps(eps), bc(bc), k(k)
+            , periodic(bc(0,0) == BC_PERIODIC)
+        {
+            MADNESS_ASSERT(mu_lo > 0.0);
+            if (periodic) return;
+
+            const Tensor<double> expnt = fit(mu_lo).exponents();
+            const long nterm = expnt.dim(0);
+            Tensor<double> coeff(nterm);
+            for (long i=0; i<nterm; ++i) {
+                coeff(i) = std::pow(sqrt(expnt(i)/constants::pi),static_cast<int>(NDIM));
+                index[expnt(i)] = i;
+            }
+            terms.reset(new operatorT(world, coeff, expnt, bc, k));
+        }
+
+        /// Smallest mu whose operator shares the terms
+        double get_mu_lo() const { return mu_lo; }
+
+        /// Precision of the expansions
+        double get_eps() const { return eps; }
+
+        /// Wavelet order of the operators
+        int get_k() const { return k; }
+
+        /// Returns true if the operator for mu shares the terms of the family
+        bool covers(double mu) const { return terms && mu >= mu_lo; }
+
+        /// Returns the operator for mu ... collective
+        std::shared_ptr<operatorT> get(double mu) {
+            typename std::map<double, std::weak_ptr<operatorT> >::iterator it = members.find(mu);
+            if (it != members.end()) {
+                std::shared_ptr<operatorT> op = it->second.lock();
+                if (op) return op;
+            }
+
+            GFit<double,NDIM> f = fit(mu);
+            Tensor<double> coeff = f.coeffs();
+            Tensor<double> expnt = f.exponents();
+            if (periodic) {
+                f.truncate_periodic_expansion(coeff, expnt, FunctionDefaults<NDIM>::get_cell_width().max(), false);
+            }
+            std::shared_ptr<operatorT> op(new operatorT(world, coeff, expnt, bc, k));
+
+            if (covers(mu)) {
+                std::vector<int> term(expnt.dim(0));
+                bool found = true;
+                for (long i=0; i<expnt.dim(0) && found; ++i) {
+                    std::map<double,int>::const_iterator p = index.find(expnt(i));
+                    found = (p != index.end());
+                    if (found) term[i] = p->second;
+                }
+                if (found) op->share_terms(terms, term);
+            }
+
+            // Forget operators that are gone
+            for (it=members.begin(); it!=members.end(); ) {
+                if (it->second.expired()) members.erase(it++);
+                else ++it;
+            }
+            members[mu] = op;
+            return op;
+        }
+    };
+
+
     /// Factory function generating operator for convolution with grad(1/r) in 3D
 
     /// Returns a 3-vector containing the convolution operator for the
@@ -49,6 +49,8 @@ namespace madness {
         mapT cache;
 
     public:
+        typedef typename mapT::const_iterator const_iterator;
+
         SimpleCache() : cache() {};
 
         SimpleCache(const SimpleCache& c) : cache(c.cache) {};
@@ -101,6 +103,13 @@ namespace madness {
             Key<NDIM> key(n,disp.translation());
             set(key, val);
         }
+
+        /// Iterator over the cached (key,value) pairs ... not safe against concurrent insertion
+        const_iterator begin() const { return cache.begin(); }
+
+        const_iterator end() const { return cache.end(); }
+
+        std::size_t size() const { return cache.size(); }
     };
 }
 #endif // MADNESS_MRA_SIMPLECACHE_H__INCLUDED
@@ -139,6 +139,9 @@ namespace madness {
 	int mflopslo, mflopshi;
 	time_transform(world, mflopslo, mflopshi);
 
+        // Operator blocks computed by earlier jobs
+        const std::size_t nconv = GaussianConvolution1DCache<double>::load(world);
+
         // print the configuration options
         if (doprint && world.rank() == 0) {
             print("");
@@ -184,9 +187,11 @@ namespace madness {
 #if HAVE_INTEL_MKL
             print("                   BLAS ...", "Intel MKL",  mflopslo, mflopshi, "MFLOP/s");
 #else
-            print("                   BLAS ...", "Slow reference",  mflopslo, mflopshi, "MFLOP/s");
+            print("                   BLAS ...", "MADNESS mTxmq", mtxmq_kernel_name(mtxmq_kernel()), mflopslo, mflopshi, "MFLOP/s");
 #endif
            	print("               compiled ...",__TIME__," on ",__DATE__);
+            if (!GaussianConvolution1DCache<double>::disk_filename().empty())
+                print("      convolution cache ...", GaussianConvolution1DCache<double>::disk_filename(), nconv, "blocks");
 
             //         print(" ");
             //         IndexIterator::test();
@@ -170,6 +170,48 @@ int test_bsh(World& world) {
 }
 
 
+/// operators of a BSHOperatorFamily must act as the standalone ones
+int test_bsh_family(World& world) {
+    typedef Vector<double,3> coordT;
+    typedef std::shared_ptr< FunctionFunctorInterface<double,3> > functorT;
+    typedef BSHOperatorFamily<3>::operatorT operatorT;
+
+    int success=0;
+    if (world.rank() == 0) print("\nTest BSH operator family");
+
+    FunctionDefaults<3>::set_k(6);
+    FunctionDefaults<3>::set_initial_level(5);
+    const double thresh=FunctionDefaults<3>::get_thresh();
+
+    const coordT origin(0.0);
+    const double expnt = 100.0;
+    aa = expnt;
+    const double coeff = pow(expnt/constants::pi,1.5);
+    Function<double,3> f = FunctionFactory<double,3>(world).functor(functorT(new Gaussian<double,3>(origin, expnt, coeff)));
+    f.truncate();
+
+    BSHOperatorFamily<3> family(world, 0.5, 1e-4, thresh);
+    std::shared_ptr<operatorT> op1 = family.get(1.0);
+    if (family.get(1.0) != op1) success++;
+    if (world.rank() == 0) print("success 1", success);
+
+    const double mus[2] = {1.0, 1.7};
+    for (int i=0; i<2; ++i) {
+        std::shared_ptr<operatorT> op = family.get(mus[i]);
+        std::shared_ptr<operatorT> ref(BSHOperatorPtr3D(world, mus[i], 1e-4, thresh));
+        Function<double,3> g = (*op)(f);
+        Function<double,3> gref = (*ref)(f);
+        const double diff = (g - gref).norm2();
+        if (world.rank() == 0) print("mu", mus[i], "family vs standalone", diff);
+        if (diff > 1e-10) success++;
+        if (world.rank() == 0) print("success", i+2, success);
+    }
+
+    world.gop.fence();
+    return success;
+}
+
+
 int main(int argc, char**argv) {
     initialize(argc,argv);
     World world(SafeMPI::COMM_WORLD);
@@ -179,6 +221,7 @@ int main(int argc, char**argv) {
         startup(world,argc,argv);
 
         success=test_bsh<double>(world);
+        success+=test_bsh_family(world);
 
     }
     catch (const SafeMPI::Exception& e) {
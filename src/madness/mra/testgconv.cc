@@ -175,6 +175,50 @@ int test_gconv(World& world) {
 }
 
 
+/// save the cached operator blocks to disk, reload them and compare
+int test_conv_cache(World& world) {
+    if (world.rank() == 0) print("Test convolution disk cache");
+    int success=0;
+    const std::string filename="testgconv.cache";
+    const double expnt=1234.5;
+
+    typedef GaussianConvolution1DCache<double> cacheT;
+    std::shared_ptr< GaussianConvolution1D<double> > op=cacheT::get(k, expnt, 0, false);
+    std::vector< Tensor<double> > ref;
+    for (Level n=0; n<5; ++n) {
+        for (Translation l=-2; l<=2; ++l) {
+            ref.push_back(copy(op->nonstandard(n,l)->R));
+        }
+    }
+    cacheT::save(world, filename);
+
+    cacheT::map.clear();
+    const std::size_t nblock=cacheT::load(world, k, filename);
+    if (nblock == 0) success++;
+    print("success 7a ", success);
+
+    op=cacheT::get(k, expnt, 0, false);
+    const std::size_t nns=op->ns_cache.size();
+    long i=0;
+    for (Level n=0; n<5; ++n) {
+        for (Translation l=-2; l<=2; ++l, ++i) {
+            if ((op->nonstandard(n,l)->R - ref[i]).normf() != 0.0) success++;
+        }
+    }
+    // nothing was recomputed
+    if (op->ns_cache.size() != nns) success++;
+    print("success 7b ", success);
+
+    // a file with a foreign cookie is ignored
+    if (cacheT::load(world, k, "testgconv.cc") != 0) success++;
+    print("success 7c ", success);
+
+    world.gop.fence();
+    if (world.rank() == 0) std::remove(filename.c_str());
+    return success;
+}
+
+
 int main(int argc, char**argv) {
     initialize(argc,argv);
     World world(SafeMPI::COMM_WORLD);
@@ -193,6 +237,7 @@ int main(int argc, char**argv) {
         	print(" polynomial ", k,"\n");
         }
         success+=test_gconv(world);
+        success+=test_conv_cache(world);
 
     }
     catch (const SafeMPI::Exception& e) {
@@ -468,6 +468,30 @@ int test_math(World& world) {
     new_err = (f6 - f.scale(6.0)).norm2();
     CHECK(new_err,1e-13,"general op output");
 
+    // Test the same kind of expressions evaluated lazily in one tree walk
+    {
+        const coordT shift(0.5);
+        functorT gfunctor(new Gaussian<T,NDIM>(shift, 2.0*expnt, coeff));
+        Function<T,NDIM> a = FunctionFactory<T,NDIM>(world).functor(functor);
+        Function<T,NDIM> b = FunctionFactory<T,NDIM>(world).functor(gfunctor);
+        Function<T,NDIM> eager = a*b + (b*b)*T(2.0) - a;
+        Function<T,NDIM> lz = (lazy(a)*b + 2.0*lazy(b)*b - a).materialize();
+        // the lazy walk forms b*b on the union of both trees rather than on
+        // the tree of b, so the two only agree to the truncation threshold
+        CHECK((lz - eager).norm2(), thresh, "lazy expression");
+
+        eager = unary_op(a*b, myunaryop<T,NDIM>());
+        FunctionExpr<T,NDIM> ab = lazy(a)*b;
+        lz = lazy_unary_op(ab, myunaryop<T,NDIM>()).materialize();
+        CHECK((lz - eager).norm2(), 1e-12, "lazy unary op");
+
+        // A shared subexpression, and a compressed operand
+        eager = (a*b)*(a*b) - a*b;
+        a.compress();
+        lz = (ab*ab - ab).materialize();
+        CHECK((lz - eager).norm2(), 1e-12, "lazy shared subexpression");
+    }
+
     if (world.rank() == 0) print("\nTest multiplying random functions");
     default_random_generator.setstate(314159);  // Ensure all processes have the same sequence (for exponents)
 
@@ -741,7 +765,7 @@ int test_op(World& world) {
     coeffs(0L) = pow(exponents(0L)/PI, 0.5*NDIM);
     SeparatedConvolution<T,NDIM> op(world, coeffs, exponents);
     START_TIMER;
-    Function<T,NDIM> r = apply(op,f);
+    Function<T,NDIM> r = madness::apply(op,f); // Qualified so ADL on std::complex cannot pick std::apply
     END_TIMER("apply");
     r.verify_tree();
     f.verify_tree();
@@ -1111,6 +1135,18 @@ int test_qm(World& world) {
 }
 
 
+/// Returns the contents of a plot file
+static std::string read_plot_file(const char* filename) {
+    std::string s;
+    FILE* f = fopen(filename, "rb");
+    if (!f) return s;
+    char buf[65536];
+    std::size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) s.append(buf, n);
+    fclose(f);
+    return s;
+}
+
 /// this essentially tests the infinity norm
 template <typename T, std::size_t NDIM>
 int test_plot(World& world) {
@@ -1164,11 +1200,77 @@ int test_plot(World& world) {
                 print("bad", i, coordT(x), fplot, fnum, (*functor)(coordT(x)));
             }
         }
+
+        // the batched evaluation must agree with evaluation point by point
+        std::vector<coordT> x(npt[0]);
+        for (int i=0; i<npt[0]; ++i) {
+            for (std::size_t d=0; d<NDIM; ++d) x[i][d] = (2.0*RandomValue<double>()-1.0)*L;
+        }
+        x[0] = coordT(-L);
+        x[1] = coordT(L);
+        Tensor<T> fbatch = f.eval(x).get();
+        double maxerr = 0.0;
+        for (int i=0; i<npt[0]; ++i) maxerr = std::max(maxerr, std::abs(fbatch(i)-f.eval(x[i]).get()));
+        CHECK(maxerr,1e-12,"batched eval");
     }
     world.gop.fence();
 
-    r = Tensor<T>();
     plotdx(f, "testplot", FunctionDefaults<NDIM>::get_cell(), npt);
+    if (NDIM <= 3) {
+        plotvti(f, "f", "testplot", coordT(-L), coordT(L), Vector<long,NDIM>(npt[0]));
+    }
+    if (world.rank() == 0) {
+        // the values written in parallel must be as accurate as eval_cube
+        // (which nudges the points off the box boundaries) at the grid points
+        const double h = 2.0*L/(npt[0]-1);
+        std::vector<long> ind(NDIM);
+        coordT x;
+        double errcube = 0.0, errdx = 0.0, errvti = 0.0;
+
+        std::string dx = read_plot_file("testplot");
+        std::size_t pos = dx.find("data follows\n") + 13;
+        const T* v = reinterpret_cast<const T*>(dx.data() + pos);
+        for (long i=0; i<r.size(); ++i) {
+            long rem = i;
+            for (long d=NDIM-1; d>=0; --d) {
+                ind[d] = rem % npt[d];
+                rem /= npt[d];
+                x[d] = -L + ind[d]*h;
+            }
+            const T exact = (*functor)(x);
+            errcube = std::max(errcube, std::abs(r(ind)-exact));
+            errdx = std::max(errdx, std::abs(v[i]-exact));
+        }
+        // values exactly on a box boundary may come from either side
+        CHECK(errdx,5.0*errcube,"plotdx binary");
+
+        if (NDIM <= 3) {
+            // VTK pieces hold the first dimension fastest
+            std::string vti = read_plot_file("testplot_0.vti");
+            pos = vti.find("<AppendedData encoding=\"raw\">\n   _") + 34;
+            uint64_t nbyte;
+            memcpy(&nbyte, vti.data() + pos, sizeof(nbyte));
+            v = reinterpret_cast<const T*>(vti.data() + pos + sizeof(nbyte));
+            for (long i=0; i<long(nbyte/sizeof(T)); ++i) {
+                long rem = i;
+                for (std::size_t d=0; d<NDIM; ++d) {
+                    ind[d] = rem % npt[d];
+                    rem /= npt[d];
+                    x[d] = -L + ind[d]*h;
+                }
+                errvti = std::max(errvti, std::abs(v[i]-(*functor)(x)));
+            }
+            CHECK(errvti,5.0*errcube,"plotvti binary");
+            remove("testplot.pvti");
+        }
+    }
+    if (NDIM <= 3) {
+        char piece[64];
+        snprintf(piece, sizeof(piece), "testplot_%d.vti", world.rank());
+        remove(piece);
+    }
+    world.gop.fence();
+    r = Tensor<T>();
 
     plot_line("testline1", 101, coordT(-L), coordT(L), f);
     plot_line("testline2", 101, coordT(-L), coordT(L), f, f*f);
@@ -121,6 +121,51 @@ void test_inner(World& world) {
         print("error norm",(rold-rnew).normf(),"\n");
 }
 
+template <typename T, int NDIM>
+void test_apply(World& world) {
+    typedef std::shared_ptr< FunctionFunctorInterface<T,NDIM> > ffunctorT;
+
+    const double thresh=1.e-6;
+    Tensor<double> cell(NDIM,2);
+    for (std::size_t i=0; i<NDIM; ++i) {
+        cell(i,0) = -11.0-2*i;  // Deliberately asymmetric bounding box
+        cell(i,1) =  10.0+i;
+    }
+    FunctionDefaults<NDIM>::set_cell(cell);
+    FunctionDefaults<NDIM>::set_k(8);
+    FunctionDefaults<NDIM>::set_thresh(thresh);
+    FunctionDefaults<NDIM>::set_refine(true);
+    FunctionDefaults<NDIM>::set_initial_level(3);
+    FunctionDefaults<NDIM>::set_truncate_mode(1);
+
+    const int n=10;
+
+    if (world.rank() == 0)
+        print("testing apply<",archive::get_type_name<T>(),",",NDIM,">");
+
+    START_TIMER;
+    std::vector< Function<T,NDIM> > f(n);
+    for (int i=0; i<n; ++i) {
+        ffunctorT g(RandomGaussian<T,NDIM>(FunctionDefaults<NDIM>::get_cell(),100.0));
+        f[i] = FunctionFactory<T,NDIM>(world).functor(g);
+    }
+    END_TIMER("project");
+
+    SeparatedConvolution<double,NDIM> op = BSHOperator<NDIM>(world, 1.0, 1.e-4, thresh);
+
+    START_TIMER;
+    std::vector< Function<TENSOR_RESULT_TYPE(double,T),NDIM> > rold(n);
+    for (int i=0; i<n; ++i) rold[i] = apply(op, f[i]);
+    END_TIMER("old");
+    START_TIMER;
+    std::vector< Function<TENSOR_RESULT_TYPE(double,T),NDIM> > rnew = apply(world, op, f);
+    END_TIMER("new");
+
+    double err = norm2(world, sub(world, rold, rnew));
+    if (world.rank() == 0)
+        print("error norm",err,"\n");
+}
+
 int main(int argc, char**argv) {
     initialize(argc, argv);
 
@@ -136,6 +181,8 @@ int main(int argc, char**argv) {
         test_inner<std::complex<double>,std::complex<double>,1,false>(world);
         test_inner<std::complex<double>,std::complex<double>,1,true>(world);
 #endif
+        test_apply<double,1>(world);
+        test_apply<double,2>(world);
     }
     catch (const SafeMPI::Exception& e) {
         //        print(e);
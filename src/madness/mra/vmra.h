@@ -907,8 +907,31 @@ namespace madness {
         nonstandard(world, ncf);
 
         std::vector< Function<TENSOR_RESULT_TYPE(T,R), NDIM> > result(f.size());
-        for (unsigned int i=0; i<f.size(); ++i) {
-            result[i] = apply_only(op, f[i], false);
+
+        // Functions with the same distribution are applied with one walk over
+        // their trees, so that the sources at the same box share the screening
+        // and the transformations (see FunctionImpl::apply_vec)
+        bool batched = (NDIM <= 3) and (f.size() > 1) and (not op.modified())
+            and (not FunctionDefaults<NDIM>::get_apply_randomize());
+        for (unsigned int i=1; batched and i<f.size(); ++i) {
+            batched = (f[i].get_pmap() == f[0].get_pmap());
+        }
+
+        if (batched) {
+            typedef FunctionImpl<TENSOR_RESULT_TYPE(T,R),NDIM> resultimplT;
+            std::vector<const FunctionImpl<R,NDIM>*> vf(f.size());
+            std::vector<resultimplT*> vresult(f.size());
+            for (unsigned int i=0; i<f.size(); ++i) {
+                result[i].set_impl(f[i], false);
+                vf[i] = f[i].get_impl().get();
+                vresult[i] = result[i].get_impl().get();
+            }
+            vresult[0]->apply_vec(op, vf, vresult, false);
+        }
+        else {
+            for (unsigned int i=0; i<f.size(); ++i) {
+                result[i] = apply_only(op, f[i], false);
+            }
         }
 
         world.gop.fence();
@@ -1087,6 +1110,22 @@ namespace madness {
         return sum(world,result,fence);
     }
 
+    /// save a vector of functions without waiting for the disk
+
+    /// The file can be read back with load_function(); see save_async()
+    /// for a single function.
+    /// @return     a future assigned once this process's file is written
+    template<typename T, size_t NDIM>
+    Future<bool> save_function_async(World& world, const std::vector<Function<T,NDIM> >& f,
+            const std::string name) {
+        if (world.rank()==0) print("saving vector of functions",name);
+        archive::AsyncParallelOutputArchive ar(world, name.c_str());
+        std::size_t fsize=f.size();
+        ar & fsize;
+        for (std::size_t i=0; i<fsize; ++i) ar & f[i];
+        return ar.close();
+    }
+
     /// load a vector of functions
     template<typename T, size_t NDIM>
     void load_function(World& world, std::vector<Function<T,NDIM> >& f,
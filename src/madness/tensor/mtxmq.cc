@@ -0,0 +1,202 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+
+
+  $Id$
+*/
+
+/// \file tensor/mtxmq.cc
+/// \brief Runtime selection of the SIMD \c mTxmq kernels
+
+#include <madness/tensor/mtxmq.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace madness {
+    namespace detail {
+
+        // Defined in mtxmq_avx2.cc and mtxmq_avx512.cc. If the compiler could
+        // not target the instruction set they are empty and the *_compiled()
+        // functions return false.
+
+        bool mtxmq_avx2_compiled();
+        void mtxmq_avx2_ddd(long dimi, long dimj, long dimk, double* c, const double* a, const double* b, long ldb);
+        void mtxmq_avx2_zzz(long dimi, long dimj, long dimk, double* c, const double* a, const double* b, long ldb);
+        void mtxmq_avx2_zdz(long dimi, long dimj, long dimk, double* c, const double* a, const double* b, long ldb);
+        void mtxmq_avx2_zzd(long dimi, long dimj, long dimk, double* c, const double* a, const double* b, long ldb);
+
+        bool mtxmq_avx512_compiled();
+        void mtxmq_avx512_ddd(long dimi, long dimj, long dimk, double* c, const double* a, const double* b, long ldb);
+        void mtxmq_avx512_zzz(long dimi, long dimj, long dimk, double* c, const double* a, const double* b, long ldb);
+        void mtxmq_avx512_zdz(long dimi, long dimj, long dimk, double* c, const double* a, const double* b, long ldb);
+        void mtxmq_avx512_zzd(long dimi, long dimj, long dimk, double* c, const double* a, const double* b, long ldb);
+
+    } // namespace detail
+
+    namespace {
+
+        bool cpu_supports(MTxmqKernel kernel) {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            // __builtin_cpu_supports also checks that the OS saves the
+            // extended registers
+            __builtin_cpu_init();
+            switch (kernel) {
+            case MTXMQ_AVX2:
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            case MTXMQ_AVX512:
+                return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2")
+                    && __builtin_cpu_supports("fma");
+            default:
+                return true;
+            }
+#else
+            return kernel == MTXMQ_REFERENCE;
+#endif
+        }
+
+        MTxmqKernel default_kernel() {
+            MTxmqKernel kernel = MTXMQ_REFERENCE;
+            if (mtxmq_kernel_available(MTXMQ_AVX512)) kernel = MTXMQ_AVX512;
+            else if (mtxmq_kernel_available(MTXMQ_AVX2)) kernel = MTXMQ_AVX2;
+
+            const char* name = getenv("MAD_MTXMQ_KERNEL");
+            if (name) {
+                for (int k=MTXMQ_REFERENCE; k<=MTXMQ_AVX512; ++k) {
+                    if (strcmp(name, mtxmq_kernel_name(MTxmqKernel(k))) == 0 &&
+                        mtxmq_kernel_available(MTxmqKernel(k))) {
+                        kernel = MTxmqKernel(k);
+                    }
+                }
+            }
+            return kernel;
+        }
+
+        MTxmqKernel& current_kernel() {
+            static MTxmqKernel kernel = default_kernel();
+            return kernel;
+        }
+
+    } // namespace
+
+    MTxmqKernel mtxmq_kernel() {
+        return current_kernel();
+    }
+
+    bool set_mtxmq_kernel(MTxmqKernel kernel) {
+        if (! mtxmq_kernel_available(kernel)) return false;
+        current_kernel() = kernel;
+        return true;
+    }
+
+    bool mtxmq_kernel_available(MTxmqKernel kernel) {
+        switch (kernel) {
+        case MTXMQ_REFERENCE:
+            return true;
+        case MTXMQ_AVX2:
+            return detail::mtxmq_avx2_compiled() && cpu_supports(kernel);
+        case MTXMQ_AVX512:
+            return detail::mtxmq_avx512_compiled() && cpu_supports(kernel);
+        default:
+            return false;
+        }
+    }
+
+    const char* mtxmq_kernel_name(MTxmqKernel kernel) {
+        switch (kernel) {
+        case MTXMQ_AVX2:
+            return "avx2";
+        case MTXMQ_AVX512:
+            return "avx512";
+        default:
+            return "reference";
+        }
+    }
+
+    namespace detail {
+
+        bool mtxmq_ddd(long dimi, long dimj, long dimk, double* c,
+                       const double* a, const double* b, long ldb) {
+            switch (current_kernel()) {
+            case MTXMQ_AVX512:
+                mtxmq_avx512_ddd(dimi, dimj, dimk, c, a, b, ldb);
+                return true;
+            case MTXMQ_AVX2:
+                mtxmq_avx2_ddd(dimi, dimj, dimk, c, a, b, ldb);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool mtxmq_zzz(long dimi, long dimj, long dimk, double* c,
+                       const double* a, const double* b, long ldb) {
+            switch (current_kernel()) {
+            case MTXMQ_AVX512:
+                mtxmq_avx512_zzz(dimi, dimj, dimk, c, a, b, ldb);
+                return true;
+            case MTXMQ_AVX2:
+                mtxmq_avx2_zzz(dimi, dimj, dimk, c, a, b, ldb);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool mtxmq_zdz(long dimi, long dimj, long dimk, double* c,
+                       const double* a, const double* b, long ldb) {
+            switch (current_kernel()) {
+            case MTXMQ_AVX512:
+                mtxmq_avx512_zdz(dimi, dimj, dimk, c, a, b, ldb);
+                return true;
+            case MTXMQ_AVX2:
+                mtxmq_avx2_zdz(dimi, dimj, dimk, c, a, b, ldb);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool mtxmq_zzd(long dimi, long dimj, long dimk, double* c,
+                       const double* a, const double* b, long ldb) {
+            switch (current_kernel()) {
+            case MTXMQ_AVX512:
+                mtxmq_avx512_zzd(dimi, dimj, dimk, c, a, b, ldb);
+                return true;
+            case MTXMQ_AVX2:
+                mtxmq_avx2_zzd(dimi, dimj, dimk, c, a, b, ldb);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    } // namespace detail
+
+} // namespace madness
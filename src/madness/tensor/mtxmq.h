@@ -0,0 +1,106 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+
+
+  $Id$
+*/
+
+#ifndef MADNESS_TENSOR_MTXMQ_H__INCLUDED
+#define MADNESS_TENSOR_MTXMQ_H__INCLUDED
+
+/// \file tensor/mtxmq.h
+/// \brief Runtime selection of the SIMD \c mTxmq kernels
+
+#include <madness/madness_config.h>
+
+namespace madness {
+
+    /// Instruction sets for which \c mTxmq kernels are built.
+    enum MTxmqKernel {
+        MTXMQ_REFERENCE, ///< Portable C++ (\c mTxmq_reference)
+        MTXMQ_AVX2,      ///< AVX2 and FMA
+        MTXMQ_AVX512     ///< AVX-512F
+    };
+
+    /// The kernel currently used by \c mTxmq.
+
+    /// On first use this is the fastest kernel that was compiled in and is
+    /// supported by the CPU (detected with cpuid), unless the environment
+    /// variable `MAD_MTXMQ_KERNEL` names another one (\c reference, \c avx2
+    /// or \c avx512).
+    /// \return The kernel.
+    MTxmqKernel mtxmq_kernel();
+
+    /// Select the kernel used by \c mTxmq.
+
+    /// Intended for testing and benchmarking; not thread safe with respect
+    /// to concurrent calls of \c mTxmq.
+    /// \param[in] kernel The kernel.
+    /// \return False (and the selection is unchanged) if \c kernel was not
+    ///    compiled in or is not supported by the CPU.
+    bool set_mtxmq_kernel(MTxmqKernel kernel);
+
+    /// Test if a kernel is compiled in and supported by the CPU.
+
+    /// \param[in] kernel The kernel.
+    /// \return True if \c kernel can be selected.
+    bool mtxmq_kernel_available(MTxmqKernel kernel);
+
+    /// Printable name of a kernel.
+
+    /// \param[in] kernel The kernel.
+    /// \return The name.
+    const char* mtxmq_kernel_name(MTxmqKernel kernel);
+
+    namespace detail {
+
+        // Entry points used by the specializations of mTxmq in mxm.h.
+        // Complex arrays are passed as interleaved (real, imaginary) pairs;
+        // the letters give the types of c, a and b (d=double,
+        // z=double_complex). Each returns false if the reference kernel is
+        // selected, in which case nothing was computed.
+
+        bool mtxmq_ddd(long dimi, long dimj, long dimk, double* c,
+                       const double* a, const double* b, long ldb);
+
+        bool mtxmq_zzz(long dimi, long dimj, long dimk, double* c,
+                       const double* a, const double* b, long ldb);
+
+        bool mtxmq_zdz(long dimi, long dimj, long dimk, double* c,
+                       const double* a, const double* b, long ldb);
+
+        bool mtxmq_zzd(long dimi, long dimj, long dimk, double* c,
+                       const double* a, const double* b, long ldb);
+
+    } // namespace detail
+
+} // namespace madness
+
+#endif // MADNESS_TENSOR_MTXMQ_H__INCLUDED
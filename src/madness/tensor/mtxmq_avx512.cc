@@ -0,0 +1,152 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+
+
+  $Id$
+*/
+
+/// \file tensor/mtxmq_avx512.cc
+/// \brief AVX-512 \c mTxmq kernels
+
+// Compiled with AVX-512F enabled (see CMakeLists.txt) and called only
+// after a cpuid check. Nothing besides the intrinsics is included here.
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+#include <madness/tensor/mtxmq_kernel.h>
+
+namespace {
+
+    struct Avx512 {
+        typedef __m512d vec;
+        typedef __mmask8 mask;
+        static const long width = 8;
+
+        static mask make_mask(long n) {
+            return mask((1u << n) - 1);
+        }
+
+        static vec zero() {
+            return _mm512_setzero_pd();
+        }
+
+        static vec load(const double* p) {
+            return _mm512_loadu_pd(p);
+        }
+
+        static vec load(const double* p, mask m) {
+            return _mm512_maskz_loadu_pd(m, p);
+        }
+
+        static void store(double* p, vec v) {
+            _mm512_storeu_pd(p, v);
+        }
+
+        static void store(double* p, vec v, mask m) {
+            _mm512_mask_storeu_pd(p, m, v);
+        }
+
+        static vec broadcast(double x) {
+            return _mm512_set1_pd(x);
+        }
+
+        static vec broadcast_pair(const double* p) {
+            return _mm512_broadcast_f64x4(_mm256_broadcast_pd(reinterpret_cast<const __m128d*>(p)));
+        }
+
+        static vec load_dup(const double* p, long n) {
+            const __m512i idx = _mm512_setr_epi64(0, 0, 1, 1, 2, 2, 3, 3);
+            return _mm512_permutexvar_pd(idx, _mm512_maskz_loadu_pd(make_mask(n), p));
+        }
+
+        static vec fma(vec a, vec b, vec c) {
+            return _mm512_fmadd_pd(a, b, c);
+        }
+
+        static vec swap_pairs(vec v) {
+            return _mm512_permute_pd(v, 0x55);
+        }
+
+        static vec addsub(vec a, vec b) {
+            return _mm512_fmaddsub_pd(a, _mm512_set1_pd(1.0), b);
+        }
+    };
+
+} // namespace
+
+namespace madness {
+    namespace detail {
+
+        bool mtxmq_avx512_compiled() {
+            return true;
+        }
+
+        void mtxmq_avx512_ddd(long dimi, long dimj, long dimk, double* c,
+                            const double* a, const double* b, long ldb) {
+            mtxmq_blocked<Avx512, MTxmqBlockReal, 8, 3>(dimi, dimj, dimk, c, a, dimi, b, ldb);
+        }
+
+        void mtxmq_avx512_zzz(long dimi, long dimj, long dimk, double* c,
+                            const double* a, const double* b, long ldb) {
+            mtxmq_blocked<Avx512, MTxmqBlockComplex, 4, 3>(dimi, 2*dimj, dimk, c, a, 2*dimi, b, 2*ldb);
+        }
+
+        void mtxmq_avx512_zdz(long dimi, long dimj, long dimk, double* c,
+                            const double* a, const double* b, long ldb) {
+            mtxmq_blocked<Avx512, MTxmqBlockReal, 8, 3>(dimi, 2*dimj, dimk, c, a, dimi, b, 2*ldb);
+        }
+
+        void mtxmq_avx512_zzd(long dimi, long dimj, long dimk, double* c,
+                            const double* a, const double* b, long ldb) {
+            mtxmq_blocked<Avx512, MTxmqBlockComplexReal, 8, 3>(dimi, 2*dimj, dimk, c, a, 2*dimi, b, ldb);
+        }
+
+    } // namespace detail
+} // namespace madness
+
+#else
+
+namespace madness {
+    namespace detail {
+
+        bool mtxmq_avx512_compiled() {
+            return false;
+        }
+
+        void mtxmq_avx512_ddd(long, long, long, double*, const double*, const double*, long) { }
+        void mtxmq_avx512_zzz(long, long, long, double*, const double*, const double*, long) { }
+        void mtxmq_avx512_zdz(long, long, long, double*, const double*, const double*, long) { }
+        void mtxmq_avx512_zzd(long, long, long, double*, const double*, const double*, long) { }
+
+    } // namespace detail
+} // namespace madness
+
+#endif
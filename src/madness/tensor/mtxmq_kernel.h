@@ -0,0 +1,314 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+
+
+  $Id$
+*/
+
+#ifndef MADNESS_TENSOR_MTXMQ_KERNEL_H__INCLUDED
+#define MADNESS_TENSOR_MTXMQ_KERNEL_H__INCLUDED
+
+/// \file tensor/mtxmq_kernel.h
+/// \brief Internal use only: register-blocked \c mTxmq kernels
+
+// This file is ONLY included into mtxmq_avx2.cc and mtxmq_avx512.cc,
+// which are compiled with the matching instruction set enabled. It must
+// not include other headers: inline functions instantiated there would be
+// compiled for that instruction set and could be picked by the linker for
+// callers elsewhere.
+//
+// The kernels compute c(i,j) = sum(k) a(k,i)*b(k,j) for row-major c
+// (dimi*dimj), a (dimk*dimi) and b (dimk*ldb). Complex data are viewed as
+// interleaved doubles. The vector type is abstracted by a traits class V
+// that provides
+//
+//     typedef ... vec;     // SIMD register of V::width doubles
+//     typedef ... mask;    // Selects the leading lanes of a vec
+//     mask make_mask(long n);
+//     vec zero();
+//     vec load(const double* p);
+//     vec load(const double* p, mask m);
+//     void store(double* p, vec v);
+//     void store(double* p, vec v, mask m);
+//     vec broadcast(double x);                // (x, x, ...)
+//     vec broadcast_pair(const double* p);    // (p[0], p[1], p[0], p[1], ...)
+//     vec load_dup(const double* p, long n);  // (p[0], p[0], p[1], p[1], ...) n reals
+//     vec fma(vec a, vec b, vec c);           // a*b + c
+//     vec swap_pairs(vec v);                  // (v[1], v[0], v[3], v[2], ...)
+//     vec addsub(vec a, vec b);               // (a[0]-b[0], a[1]+b[1], ...)
+//
+// The i dimension is blocked by MR rows and the j dimension by NV
+// vectors so that the MR*NV accumulators stay in registers; the last
+// vector of each block is masked.
+
+// Loops over the MR*NV accumulators must be unrolled completely, otherwise
+// the accumulators are kept in memory
+#if defined(__clang__)
+#  define MADNESS_MTXMQ_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__) && (__GNUC__ >= 8)
+#  define MADNESS_MTXMQ_UNROLL _Pragma("GCC unroll 16")
+#else
+#  define MADNESS_MTXMQ_UNROLL
+#endif
+
+namespace madness {
+    namespace detail {
+
+        /// Arguments of a register block (strides and sizes in doubles)
+        template <typename V>
+        struct MTxmqBlockArgs {
+            long dimk;               ///< Length of the sum
+            long lda;                ///< Stride of a between values of k
+            long ldb;                ///< Stride of b between values of k
+            long ldc;                ///< Stride of c between rows
+            const double* a;         ///< First column of a in the block
+            const double* b;         ///< First column of b in the block
+            double* c;               ///< First element of c in the block
+            long ntail;              ///< Doubles of c in the last vector
+            typename V::mask mask;   ///< Mask of the last vector
+        };
+
+        /// Block of c (real or complex) from real a and b (of the same type as c)
+
+        /// With complex b and c the real kernel applies to the interleaved
+        /// data unchanged.
+        template <typename V, int MR, int NV>
+        struct MTxmqBlockReal {
+            static const long astep = 1; ///< Doubles of a per row of c
+
+            static long boffset(long j) {
+                return j;
+            }
+
+            static void run(const MTxmqBlockArgs<V>& p) {
+                typedef typename V::vec vec;
+                const long W = V::width;
+
+                vec acc[MR][NV];
+                MADNESS_MTXMQ_UNROLL
+                for (int r=0; r<MR; ++r)
+                    MADNESS_MTXMQ_UNROLL
+                    for (int v=0; v<NV; ++v) acc[r][v] = V::zero();
+
+                const double* a = p.a;
+                const double* b = p.b;
+                for (long k=0; k<p.dimk; ++k, a+=p.lda, b+=p.ldb) {
+                    vec bv[NV];
+                    MADNESS_MTXMQ_UNROLL
+                    for (int v=0; v<NV-1; ++v) bv[v] = V::load(b + v*W);
+                    bv[NV-1] = V::load(b + (NV-1)*W, p.mask);
+                    MADNESS_MTXMQ_UNROLL
+                    for (int r=0; r<MR; ++r) {
+                        const vec ar = V::broadcast(a[r]);
+                        MADNESS_MTXMQ_UNROLL
+                        for (int v=0; v<NV; ++v) acc[r][v] = V::fma(ar, bv[v], acc[r][v]);
+                    }
+                }
+
+                MADNESS_MTXMQ_UNROLL
+                for (int r=0; r<MR; ++r) {
+                    double* c = p.c + r*p.ldc;
+                    MADNESS_MTXMQ_UNROLL
+                    for (int v=0; v<NV-1; ++v) V::store(c + v*W, acc[r][v]);
+                    V::store(c + (NV-1)*W, acc[r][NV-1], p.mask);
+                }
+            }
+        };
+
+        /// Block of complex c from complex a and b
+
+        /// The products with the real and imaginary parts of a are
+        /// accumulated separately and combined when storing.
+        template <typename V, int MR, int NV>
+        struct MTxmqBlockComplex {
+            static const long astep = 2;
+
+            static long boffset(long j) {
+                return j;
+            }
+
+            static void run(const MTxmqBlockArgs<V>& p) {
+                typedef typename V::vec vec;
+                const long W = V::width;
+
+                vec accr[MR][NV], acci[MR][NV];
+                MADNESS_MTXMQ_UNROLL
+                for (int r=0; r<MR; ++r) {
+                    MADNESS_MTXMQ_UNROLL
+                    for (int v=0; v<NV; ++v) {
+                        accr[r][v] = V::zero();
+                        acci[r][v] = V::zero();
+                    }
+                }
+
+                const double* a = p.a;
+                const double* b = p.b;
+                for (long k=0; k<p.dimk; ++k, a+=p.lda, b+=p.ldb) {
+                    vec bv[NV];
+                    MADNESS_MTXMQ_UNROLL
+                    for (int v=0; v<NV-1; ++v) bv[v] = V::load(b + v*W);
+                    bv[NV-1] = V::load(b + (NV-1)*W, p.mask);
+                    MADNESS_MTXMQ_UNROLL
+                    for (int r=0; r<MR; ++r) {
+                        const vec ar = V::broadcast(a[2*r]);
+                        const vec ai = V::broadcast(a[2*r+1]);
+                        MADNESS_MTXMQ_UNROLL
+                        for (int v=0; v<NV; ++v) {
+                            accr[r][v] = V::fma(ar, bv[v], accr[r][v]);
+                            acci[r][v] = V::fma(ai, bv[v], acci[r][v]);
+                        }
+                    }
+                }
+
+                // (ar*br - ai*bi, ar*bi + ai*br)
+                MADNESS_MTXMQ_UNROLL
+                for (int r=0; r<MR; ++r) {
+                    double* c = p.c + r*p.ldc;
+                    MADNESS_MTXMQ_UNROLL
+                    for (int v=0; v<NV-1; ++v)
+                        V::store(c + v*W, V::addsub(accr[r][v], V::swap_pairs(acci[r][v])));
+                    V::store(c + (NV-1)*W, V::addsub(accr[r][NV-1], V::swap_pairs(acci[r][NV-1])), p.mask);
+                }
+            }
+        };
+
+        /// Block of complex c from complex a and real b
+
+        /// Each real of b is duplicated so that a vector of b multiplies
+        /// the interleaved pair of a directly.
+        template <typename V, int MR, int NV>
+        struct MTxmqBlockComplexReal {
+            static const long astep = 2;
+
+            static long boffset(long j) {
+                return j/2;
+            }
+
+            static void run(const MTxmqBlockArgs<V>& p) {
+                typedef typename V::vec vec;
+                const long W = V::width;
+
+                vec acc[MR][NV];
+                MADNESS_MTXMQ_UNROLL
+                for (int r=0; r<MR; ++r)
+                    MADNESS_MTXMQ_UNROLL
+                    for (int v=0; v<NV; ++v) acc[r][v] = V::zero();
+
+                const double* a = p.a;
+                const double* b = p.b;
+                for (long k=0; k<p.dimk; ++k, a+=p.lda, b+=p.ldb) {
+                    vec bv[NV];
+                    MADNESS_MTXMQ_UNROLL
+                    for (int v=0; v<NV-1; ++v) bv[v] = V::load_dup(b + v*(W/2), W/2);
+                    bv[NV-1] = V::load_dup(b + (NV-1)*(W/2), p.ntail/2);
+                    MADNESS_MTXMQ_UNROLL
+                    for (int r=0; r<MR; ++r) {
+                        const vec ar = V::broadcast_pair(a + 2*r);
+                        MADNESS_MTXMQ_UNROLL
+                        for (int v=0; v<NV; ++v) acc[r][v] = V::fma(ar, bv[v], acc[r][v]);
+                    }
+                }
+
+                MADNESS_MTXMQ_UNROLL
+                for (int r=0; r<MR; ++r) {
+                    double* c = p.c + r*p.ldc;
+                    MADNESS_MTXMQ_UNROLL
+                    for (int v=0; v<NV-1; ++v) V::store(c + v*W, acc[r][v]);
+                    V::store(c + (NV-1)*W, acc[r][NV-1], p.mask);
+                }
+            }
+        };
+
+        /// Calls Block<V,mr,nv>::run for 1<=mr<=MR and 1<=nv<=NV known at run time
+        template <typename V, template <typename, int, int> class Block, int MR, int NV>
+        struct MTxmqDispatch {
+            static void run(int mr, int nv, const MTxmqBlockArgs<V>& p) {
+                if (mr < MR) MTxmqDispatch<V, Block, MR-1, NV>::run(mr, nv, p);
+                else if (nv < NV) MTxmqDispatch<V, Block, MR, NV-1>::run(mr, nv, p);
+                else Block<V, MR, NV>::run(p);
+            }
+        };
+
+        template <typename V, template <typename, int, int> class Block, int NV>
+        struct MTxmqDispatch<V, Block, 0, NV> {
+            static void run(int, int, const MTxmqBlockArgs<V>&) { }
+        };
+
+        template <typename V, template <typename, int, int> class Block, int MR>
+        struct MTxmqDispatch<V, Block, MR, 0> {
+            static void run(int, int, const MTxmqBlockArgs<V>&) { }
+        };
+
+        template <typename V, template <typename, int, int> class Block>
+        struct MTxmqDispatch<V, Block, 0, 0> {
+            static void run(int, int, const MTxmqBlockArgs<V>&) { }
+        };
+
+        /// Multiply using register blocks of at most MR rows and NV vectors
+
+        /// \param[in] dimi Rows of c.
+        /// \param[in] ncol Doubles per row of c.
+        /// \param[in] dimk Length of the sum.
+        /// \param[out] c The result with rows of \c ncol doubles.
+        /// \param[in] a The left matrix with \c lda doubles per value of k.
+        /// \param[in] lda Stride of a.
+        /// \param[in] b The right matrix with \c ldb doubles per value of k.
+        /// \param[in] ldb Stride of b.
+        template <typename V, template <typename, int, int> class Block, int MR, int NV>
+        void mtxmq_blocked(long dimi, long ncol, long dimk, double* c,
+                           const double* a, long lda, const double* b, long ldb) {
+            const long W = V::width;
+            const long astep = Block<V, 1, 1>::astep;
+
+            MTxmqBlockArgs<V> p;
+            p.dimk = dimk;
+            p.lda = lda;
+            p.ldb = ldb;
+            p.ldc = ncol;
+
+            for (long j=0; j<ncol; j+=NV*W) {
+                const long nj = (ncol-j < NV*W) ? ncol-j : NV*W;
+                const int nv = (nj + W - 1)/W;
+                p.ntail = nj - (nv-1)*W;
+                p.mask = V::make_mask(p.ntail);
+                p.b = b + Block<V, 1, 1>::boffset(j);
+                for (long i=0; i<dimi; i+=MR) {
+                    const int mr = (dimi-i < MR) ? dimi-i : MR;
+                    p.a = a + i*astep;
+                    p.c = c + i*ncol + j;
+                    MTxmqDispatch<V, Block, MR, NV>::run(mr, nv, p);
+                }
+            }
+        }
+
+    } // namespace detail
+} // namespace madness
+
+#endif // MADNESS_TENSOR_MTXMQ_KERNEL_H__INCLUDED
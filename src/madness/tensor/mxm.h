@@ -39,6 +39,9 @@
 
 #ifdef HAVE_INTEL_MKL
 #include <madness/tensor/cblas.h>
+#else
+#include <madness/tensor/mtxmq.h>
+#include <complex>
 #endif
 
 /// \file tensor/mxm.h
@@ -300,6 +303,54 @@ namespace madness {
         mTxmq_reference(dimi, dimj, dimk, c, a, b, ldb);
     }
 
+#ifndef HAVE_IBMBGP
+    // SIMD kernels selected at run time (see mtxmq.h); they fall back to
+    // the reference implementation if the CPU lacks AVX2
+
+    template <>
+    inline void mTxmq(long dimi, long dimj, long dimk,
+                      double* restrict c, const double* a, const double* b, long ldb) {
+        if (ldb == -1) ldb=dimj;
+        MADNESS_ASSERT(ldb>=dimj);
+        if (! detail::mtxmq_ddd(dimi, dimj, dimk, c, a, b, ldb))
+            mTxmq_reference(dimi, dimj, dimk, c, a, b, ldb);
+    }
+
+    template <>
+    inline void mTxmq(long dimi, long dimj, long dimk,
+                      std::complex<double>* restrict c, const std::complex<double>* a,
+                      const std::complex<double>* b, long ldb) {
+        if (ldb == -1) ldb=dimj;
+        MADNESS_ASSERT(ldb>=dimj);
+        if (! detail::mtxmq_zzz(dimi, dimj, dimk, reinterpret_cast<double*>(c),
+                                reinterpret_cast<const double*>(a),
+                                reinterpret_cast<const double*>(b), ldb))
+            mTxmq_reference(dimi, dimj, dimk, c, a, b, ldb);
+    }
+
+    template <>
+    inline void mTxmq(long dimi, long dimj, long dimk,
+                      std::complex<double>* restrict c, const double* a,
+                      const std::complex<double>* b, long ldb) {
+        if (ldb == -1) ldb=dimj;
+        MADNESS_ASSERT(ldb>=dimj);
+        if (! detail::mtxmq_zdz(dimi, dimj, dimk, reinterpret_cast<double*>(c), a,
+                                reinterpret_cast<const double*>(b), ldb))
+            mTxmq_reference(dimi, dimj, dimk, c, a, b, ldb);
+    }
+
+    template <>
+    inline void mTxmq(long dimi, long dimj, long dimk,
+                      std::complex<double>* restrict c, const std::complex<double>* a,
+                      const double* b, long ldb) {
+        if (ldb == -1) ldb=dimj;
+        MADNESS_ASSERT(ldb>=dimj);
+        if (! detail::mtxmq_zzd(dimi, dimj, dimk, reinterpret_cast<double*>(c),
+                                reinterpret_cast<const double*>(a), b, ldb))
+            mTxmq_reference(dimi, dimj, dimk, c, a, b, ldb);
+    }
+#endif // HAVE_IBMBGP
+
     // The following are restricted to double only
     
     /// Matrix transpose * matrix (hand unrolled version)
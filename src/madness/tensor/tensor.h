@@ -35,6 +35,8 @@
 #include <madness/madness_config.h>
 #include <madness/misc/ran.h>
 #include <madness/world/posixmem.h>
+#include <madness/world/numa.h>
+#include <madness/world/memory_pool.h>
 
 #include <memory>
 #include <complex>
@@ -44,6 +46,7 @@
 #include <cstddef>
 
 #include <madness/world/archive.h>
+#include <madness/world/mmap_archive.h>
 // #include <madness/world/print.h>
 //
 // typedef std::complex<float> float_complex;
@@ -372,8 +375,17 @@ namespace madness {
                     _p = new T[_size];
                     _shptr = std::shared_ptr<T>(_p);
 #else
-                    if (posix_memalign((void **) &_p, TENSOR_ALIGNMENT, sizeof(T)*_size)) throw 1;
-                    _shptr.reset(_p, &free);
+                    if (MemoryPool::enabled()) {
+                        // Data and shared_ptr control block both come from the pool
+                        const std::size_t nbyte = sizeof(T)*_size;
+                        _p = static_cast<T*>(MemoryPool::allocate(nbyte));
+                        _shptr.reset(_p, MemoryPool::Deleter(nbyte), MemoryPool::Allocator<T>());
+                    }
+                    else {
+                        // Placed on the NUMA node of this thread if that is enabled
+                        if (numa_memalign((void **) &_p, TENSOR_ALIGNMENT, sizeof(T)*_size)) throw 1;
+                        _shptr.reset(_p, &free);
+                    }
 #endif
                 }
                 catch (...) {
@@ -549,6 +561,21 @@ namespace madness {
             allocate(nd,d,dozero);
         }
 
+#ifndef TENSOR_USE_SHARED_ALIGNED_ARRAY
+        /// Create a contiguous n-d tensor that aliases existing data.
+
+        /// No data is allocated or copied; the tensor shares ownership of
+        /// \c data, which must hold at least as many elements as the
+        /// product of the dimensions.
+        /// @param[in] nd Number of dimensions
+        /// @param[in] d Size of each dimension
+        /// @param[in] data The data to alias
+        explicit Tensor(long nd, const long d[], const std::shared_ptr<T>& data) : _p(data.get()), _shptr(data) {
+            _id = TensorTypeData<T>::id;
+            set_dims_and_size(nd, d);
+        }
+#endif
+
         /// Inplace fill tensor with scalar
 
         /// @param[in] x Value used to fill tensor via assigment
@@ -1914,6 +1941,50 @@ namespace madness {
             };
         };
 
+        /// Serialize a tensor with its data aligned for mapping back into memory
+        template <typename T>
+        struct ArchiveStoreImpl< MMapOutputArchive, Tensor<T> > {
+            static void store(const MMapOutputArchive& s, const Tensor<T>& t) {
+                if (t.iscontiguous()) {
+                    s & t.size() & t.id();
+                    if (t.size()) {
+                        s & t.ndim() & wrap(t.dims(),TENSOR_MAXDIM);
+                        s.align(TENSOR_ALIGNMENT);
+                        s.store(reinterpret_cast<const unsigned char*>(t.ptr()), t.size()*sizeof(T));
+                    }
+                }
+                else {
+                    s & copy(t);
+                }
+            };
+        };
+
+        /// Deserialize a tensor that aliases the mapped file until it is modified
+        template <typename T>
+        struct ArchiveLoadImpl< MMapInputArchive, Tensor<T> > {
+            static void load(const MMapInputArchive& s, Tensor<T>& t) {
+                long sz = 0l, id = 0l;
+                s & sz & id;
+                if (id != t.id()) throw "type mismatch deserializing a tensor";
+                if (sz) {
+                    long _ndim = 0l, _dim[TENSOR_MAXDIM];
+                    s & _ndim & wrap(_dim,TENSOR_MAXDIM);
+                    s.align(TENSOR_ALIGNMENT);
+#ifdef TENSOR_USE_SHARED_ALIGNED_ARRAY
+                    t = Tensor<T>(_ndim, _dim, false);
+                    if (sz != t.size()) throw "size mismatch deserializing a tensor";
+                    s.load(reinterpret_cast<unsigned char*>(t.ptr()), t.size()*sizeof(T));
+#else
+                    t = Tensor<T>(_ndim, _dim, s.alias<T>(sz));
+                    if (sz != t.size()) throw "size mismatch deserializing a tensor";
+#endif
+                }
+                else {
+                    t = Tensor<T>();
+                }
+            };
+        };
+
     }
 
     /// The class defines tensor op scalar ... here define scalar op tensor.
@@ -44,6 +44,7 @@ int main() {std::cout << "x86 only\n"; return 0;}
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <algorithm>
 //#include <xmmintrin.h>
 
 #include <madness/world/safempi.h>
@@ -51,6 +52,7 @@ int main() {std::cout << "x86 only\n"; return 0;}
 #include <madness/tensor/cblas.h>
 #include <madness/tensor/tensor.h>
 #include <madness/tensor/mxm.h>
+#include <madness/tensor/mtxmq.h>
 
 using namespace madness;
 
@@ -162,8 +164,40 @@ void trantimer(const char* s, long ni, long nj, long nk, double *a, double *b, d
   printf("%20s %3ld %3ld %3ld %8.2f %8.2f\n",s, ni,nj,nk, fastest, fastest_dgemm);
 }
 
+/// Sweep k over the range used by MADNESS for every available kernel
+void kernel_sweep(double *a, double *b, double *c) {
+    printf("\n%20s %3s", "(k*k,k)T*(k,k)", "K");
+    for (int kernel=MTXMQ_REFERENCE; kernel<=MTXMQ_AVX512; ++kernel)
+        if (mtxmq_kernel_available(MTxmqKernel(kernel)))
+            printf(" %9s", mtxmq_kernel_name(MTxmqKernel(kernel)));
+    printf(" (GF/s)\n");
+
+    const MTxmqKernel save = mtxmq_kernel();
+    for (long k=2; k<=40; ++k) {
+        const long ni=k*k, nj=k, nk=k;
+        const double nflop = 2.0*ni*nj*nk;
+        const long nloop = std::max(1L, long(2e7/nflop));
+        printf("%20s %3ld", "", k);
+        for (int kernel=MTXMQ_REFERENCE; kernel<=MTXMQ_AVX512; ++kernel) {
+            if (! set_mtxmq_kernel(MTxmqKernel(kernel))) continue;
+            double fastest = 0.0;
+            for (int t=0; t<5; t++) {
+                double start = SafeMPI::Wtime();
+                for (long loop=0; loop<nloop; ++loop) mTxmq(ni,nj,nk,c,a,b);
+                start = SafeMPI::Wtime() - start;
+                double rate = 1.e-9*nflop*nloop/start;
+                crap(rate,fastest,start);
+                if (rate > fastest) fastest = rate;
+            }
+            printf(" %9.2f", fastest);
+        }
+        printf("\n");
+    }
+    set_mtxmq_kernel(save);
+}
+
 int main(int argc, char * argv[]) {
-    const long nimax=30*30;
+    const long nimax=40*40;
     const long njmax=100;
     const long nkmax=100;
     long ni, nj, nk, i, m;
@@ -192,29 +226,59 @@ int main(int argc, char * argv[]) {
 /*     } */
 /*     return 0; */
 
+    // Test every kernel that the CPU supports
+    const MTxmqKernel save = mtxmq_kernel();
     printf("Starting to test ... \n");
     for (ni=1; ni<60; ni+=1) {
         for (nj=1; nj<100; nj+=1) {
             for (nk=1; nk<100; nk+=1) {
-                for (i=0; i<ni*nj; ++i) d[i] = c[i] = 0.0;
+                for (i=0; i<ni*nj; ++i) c[i] = 0.0;
                 mTxm (ni,nj,nk,c,a,b);
-                mTxmq(ni,nj,nk,d,a,b);
-                for (i=0; i<ni*nj; ++i) {
-                    double err = std::abs(d[i]-c[i]);
-                    /* This test is sensitive to the compilation options.
-                       Be sure to have the reference code above compiled
-                       -msse2 -fpmath=sse if using GCC.  Otherwise, to
-                       pass the test you may need to change the threshold
-                       to circa 1e-13.
-                    */
-                    if (err > 1e-13) {
-                        printf("test_mtxmq: error %ld %ld %ld %e\n",ni,nj,nk,err);
-                        exit(1);
+                for (int kernel=MTXMQ_REFERENCE; kernel<=MTXMQ_AVX512; ++kernel) {
+                    if (! set_mtxmq_kernel(MTxmqKernel(kernel))) continue;
+                    for (i=0; i<ni*nj; ++i) d[i] = 0.0;
+                    mTxmq(ni,nj,nk,d,a,b);
+                    for (i=0; i<ni*nj; ++i) {
+                        double err = std::abs(d[i]-c[i]);
+                        /* This test is sensitive to the compilation options.
+                           Be sure to have the reference code above compiled
+                           -msse2 -fpmath=sse if using GCC.  Otherwise, to
+                           pass the test you may need to change the threshold
+                           to circa 1e-13.
+                        */
+                        if (err > 1e-13) {
+                            printf("test_mtxmq: error %s %ld %ld %ld %e\n",
+                                   mtxmq_kernel_name(MTxmqKernel(kernel)),ni,nj,nk,err);
+                            exit(1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // b with leading dimension larger than nj (low rank transformations)
+    for (ni=1; ni<60; ni+=7) {
+        for (nj=1; nj<40; nj+=1) {
+            for (nk=1; nk<40; nk+=3) {
+                const long ldb = nj+5;
+                mTxmq_reference(ni,nj,nk,c,a,b,ldb);
+                for (int kernel=MTXMQ_REFERENCE; kernel<=MTXMQ_AVX512; ++kernel) {
+                    if (! set_mtxmq_kernel(MTxmqKernel(kernel))) continue;
+                    mTxmq(ni,nj,nk,d,a,b,ldb);
+                    for (i=0; i<ni*nj; ++i) {
+                        double err = std::abs(d[i]-c[i]);
+                        if (err > 1e-13) {
+                            printf("test_mtxmq: ldb error %s %ld %ld %ld %e\n",
+                                   mtxmq_kernel_name(MTxmqKernel(kernel)),ni,nj,nk,err);
+                            exit(1);
+                        }
                     }
                 }
             }
         }
     }
+    set_mtxmq_kernel(save);
     printf("... OK!\n");
 
     printf("%20s %3s %3s %3s %8s %8s (GF/s)\n", "type", "M", "N", "K", "LOOP", "BLAS");
@@ -222,6 +286,7 @@ int main(int argc, char * argv[]) {
     for (m=2; m<=30; m+=2) timer("(m*m,m)T*(m*m)", m*m,m,m,a,b,c);
     for (m=2; m<=30; m+=2) trantimer("tran(m,m,m)", m*m,m,m,a,b,c);
     for (m=2; m<=20; m+=2) timer("(20*20,20)T*(20,m)", 20*20,m,20,a,b,c);
+    kernel_sweep(a,b,c);
 
     SafeMPI::Finalize();
 
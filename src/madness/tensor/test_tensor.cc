@@ -415,6 +415,61 @@ namespace {
         ITERATOR3(b,ASSERT_EQ(b(_i,_j,_k), a(_j,_i,_k)));
     }
 
+    TYPED_TEST(TensorTest, MemoryPool) {
+        madness::MemoryPool::enable(true);
+        const madness::MemoryPool::Stats before = madness::MemoryPool::get_stats();
+        for (int iter=0; iter<10; ++iter) {
+            madness::Tensor<TypeParam> a(7,8,9), b(7,8,9);
+            ASSERT_EQ(((unsigned long) a.ptr()) % madness::MemoryPool::alignment, 0ul);
+            a.fillindex();
+            b = a;  // Shallow copy shares the block
+            ITERATOR3(a,ASSERT_EQ(b(_i,_j,_k), TypeParam(_i*72 + _j*9 + _k)));
+        }
+        const madness::MemoryPool::Stats after = madness::MemoryPool::get_stats();
+        madness::MemoryPool::enable(false);
+        madness::MemoryPool::release_thread_cache();
+
+        // After the first iteration data and control blocks are reused
+        ASSERT_EQ(after.nalloc - before.nalloc, after.nfree - before.nfree);
+        ASSERT_GE(after.nhit - before.nhit, 9*4ul);
+    }
+
+    TYPED_TEST(TensorTest, MMapArchive) {
+        const char* f = "test_tensor_mmap.dat";
+        madness::Tensor<TypeParam> a(7,8,9), b(3,4), c;
+        a.fillindex();
+        b.fillindex();
+        {
+            madness::archive::MMapOutputArchive oar(f);
+            oar & a & 1.5 & b & c;
+            oar.close();
+        }
+        madness::Tensor<TypeParam> aa, bb, cc;
+        double x = 0.0;
+        {
+            madness::archive::MMapInputArchive iar(f);
+            iar & aa & x & bb & cc;
+            iar.close();
+        }
+        ASSERT_EQ(x, 1.5);
+        ASSERT_EQ(cc.size(), 0);
+        ASSERT_EQ(((unsigned long) aa.ptr()) % TENSOR_ALIGNMENT, 0ul);
+        ASSERT_EQ(((unsigned long) bb.ptr()) % TENSOR_ALIGNMENT, 0ul);
+        ITERATOR3(a,ASSERT_EQ(aa(_i,_j,_k), a(_i,_j,_k)));
+        ITERATOR2(b,ASSERT_EQ(bb(_i,_j), b(_i,_j)));
+
+        // Writing to the mapped data copies the page and leaves the file alone
+        aa(0,0,0) = TypeParam(-1);
+        {
+            madness::archive::MMapInputArchive iar(f);
+            madness::Tensor<TypeParam> again;
+            iar & again;
+            ASSERT_EQ(again(0,0,0), TypeParam(0));
+        }
+        ASSERT_EQ(aa(0,0,0), TypeParam(-1));
+        std::remove(f);
+    }
+
 //     TYPED_TEST(TensorTest, Container) {
 //         typedef madness::ConcurrentHashMap< int, Tensor<TypeParam> > containerT;
 //         static const int N = 100;
@@ -42,6 +42,7 @@
 typedef std::complex<double> double_complex;
 
 #include <madness/madness_config.h>
+#include <madness/tensor/vmath.h>
 #ifdef HAVE_MKL
 #include <mkl.h>
 
@@ -81,6 +82,69 @@ void vzExp(int n, const double_complex* x, double_complex* y) {
 }
 
 #else
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+    inline std::int64_t double_bits(double x) {
+        std::int64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        return bits;
+    }
+
+    inline double bits_double(std::int64_t bits) {
+        double x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+}
+
+void vdExp(int n, const double *x, double *y) {
+    // exp(x) = 2^k exp(r) with k = nint(x/ln2) and |r| <= ln2/2.  The
+    // reduction uses ln2 split in two so that x - k*ln2 is exact, and
+    // exp(r) is its Taylor series through r^13 (truncation error below
+    // 1e-17).  k is rounded by adding 1.5*2^52, which leaves it in the
+    // low bits of the sum, so that 2^k can be assembled with integer
+    // adds and shifts.  2^k is applied in two halves so that results
+    // in the subnormal range come out right, and clamping x to
+    // [-746,710] makes the same multiplications produce 0 and inf
+    // beyond the range of doubles.  There are no branches or
+    // conversions so both loops vectorize with SSE2 (the clamp is a
+    // separate pass since gcc will not if-convert it otherwise).
+    static const double log2e = 1.4426950408889634074;
+    static const double ln2hi = 6.93147180369123816490e-01;
+    static const double ln2lo = 1.90821492927058770002e-10;
+    static const double shifter = 6755399441055744.0; // 1.5*2^52
+    const std::int64_t shifterbits = double_bits(shifter);
+    for (int i=0; i<n; ++i) y[i] = std::min(std::max(x[i], -746.0), 710.0);
+    for (int i=0; i<n; ++i) {
+        const double xc = y[i];
+        const double kd = xc*log2e + shifter;
+        const double k1d = (xc*log2e)*0.5 + shifter;
+        const double dk = kd - shifter;
+        const double r = (xc - dk*ln2hi) - dk*ln2lo;
+        // exp(r) = 1 + r + r^2 T(r) with T evaluated by Estrin's scheme
+        // to keep the dependency chains short
+        const double r2 = r*r, r4 = r2*r2;
+        const double t01 = 1.0/2.0 + r*(1.0/6.0);
+        const double t23 = 1.0/24.0 + r*(1.0/120.0);
+        const double t45 = 1.0/720.0 + r*(1.0/5040.0);
+        const double t67 = 1.0/40320.0 + r*(1.0/362880.0);
+        const double t89 = 1.0/3628800.0 + r*(1.0/39916800.0);
+        const double tab = 1.0/479001600.0 + r*(1.0/6227020800.0);
+        const double t03 = t01 + r2*t23;
+        const double t47 = t45 + r2*t67;
+        const double t8b = t89 + r2*tab;
+        const double t = t03 + r4*(t47 + r4*t8b);
+        const double p = 1.0 + (r + r2*t);
+        const std::int64_t k = double_bits(kd) - shifterbits;
+        const std::int64_t k1 = double_bits(k1d) - shifterbits;
+        y[i] = p*bits_double((k1 + 1023) << 52)*bits_double((k - k1 + 1023) << 52);
+    }
+}
 
 void vzExp(int n, const double_complex* x, double_complex* y) {
     for (int i=0; i<n; ++i) y[i] = exp(x[i]);
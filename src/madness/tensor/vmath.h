@@ -38,8 +38,18 @@
 #ifdef HAVE_MKL
 #include <mkl.h>
 
-#elif defined(HAVE_ACML)
-void vzExp(int n, const double_complex* x, double_complex* y);
+#else
+#include <complex>
+
+/// Computes \c y[i]=exp(x[i]) for \c i=0..n-1
+
+/// Without ACML this is a branch-free loop that the compiler can
+/// vectorize; it is accurate to 1 ulp over the whole range of
+/// doubles.  \c x and \c y may be the same array.
+void vdExp(int n, const double* x, double* y);
+
+/// Computes \c y[i]=exp(x[i]) for \c i=0..n-1
+void vzExp(int n, const std::complex<double>* x, std::complex<double>* y);
 #endif
 
 #endif // MADNESS_TENSOR_VMATH_H__INCLUDED
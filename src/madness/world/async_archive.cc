@@ -0,0 +1,149 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/**
+ \file async_archive.cc
+ \brief Implements \c AsyncParallelOutputArchive and its I/O thread.
+ \ingroup serialization
+*/
+
+#include <madness/world/async_archive.h>
+#include <madness/world/worldmutex.h>
+#include <madness/world/thread.h>
+#include <list>
+#include <cstdio>
+
+namespace madness {
+    namespace archive {
+
+        namespace {
+
+            /// The thread that writes snapshots to disk, in the order submitted.
+
+            /// Started on first use and never stopped; it sleeps while
+            /// there is nothing to write.
+            class AsyncWriter : public ThreadBase {
+                struct Job {
+                    std::string filename;
+                    std::shared_ptr< std::vector<unsigned char> > data;
+                    Future<bool> done;
+                };
+
+                PthreadConditionVariable cv; ///< Protects and signals \c jobs.
+                std::list<Job> jobs; ///< Snapshots waiting to be written.
+
+                /// Writes a snapshot under a temporary name and renames it into place.
+
+                /// \param[in] job The snapshot.
+                /// \return True on success.
+                static bool write(const Job& job) {
+                    const std::string tmpname = job.filename + ".tmp";
+                    std::FILE* f = std::fopen(tmpname.c_str(), "wb");
+                    if (!f) return false;
+                    const std::size_t n = job.data->size();
+                    bool ok = (n == 0) || (std::fwrite(&(*job.data)[0], 1, n, f) == n);
+                    ok = (std::fclose(f) == 0) && ok;
+                    return ok && (std::rename(tmpname.c_str(), job.filename.c_str()) == 0);
+                }
+
+            public:
+                void submit(const std::string& filename,
+                            const std::shared_ptr< std::vector<unsigned char> >& data,
+                            const Future<bool>& done)
+                {
+                    Job job = {filename, data, done};
+                    cv.lock();
+                    jobs.push_back(job);
+                    cv.signal();
+                    cv.unlock();
+                }
+
+                void run() {
+                    while (true) {
+                        cv.lock();
+                        while (jobs.empty()) cv.wait();
+                        Job job = jobs.front();
+                        jobs.pop_front();
+                        cv.unlock();
+
+                        const bool ok = write(job);
+                        job.data.reset(); // Release the memory before waking anyone
+                        job.done.set(ok);
+                    }
+                }
+
+                /// Returns the writer, starting it on first use.
+                static AsyncWriter& instance() {
+                    static Mutex mutex;
+                    static AsyncWriter* writer = nullptr;
+                    ScopedMutex<Mutex> lock(mutex);
+                    if (!writer) {
+                        writer = new AsyncWriter;
+                        writer->start();
+                    }
+                    return *writer;
+                }
+            };
+
+        } // namespace
+
+        void AsyncParallelOutputArchive::open(World& world, const char* filename) {
+            MADNESS_ASSERT(filename);
+            close();
+            this->world = &world;
+            fname = filename;
+            ar = SnapshotOutputArchive();
+            // Same leading content as the files of a ParallelOutputArchive
+            ar.store(ARCHIVE_COOKIE, strlen(ARCHIVE_COOKIE)+1);
+            if (world.rank() == 0) {
+                int nio = world.size();
+                ar & nio;
+            }
+        }
+
+        Future<bool> AsyncParallelOutputArchive::close() {
+            Future<bool> done;
+            if (world) {
+                char buf[256];
+                MADNESS_ASSERT(fname.size()+7 <= sizeof(buf));
+                sprintf(buf, "%s.%5.5d", fname.c_str(), world->rank());
+                AsyncWriter::instance().submit(buf, ar.data(), done);
+                ar = SnapshotOutputArchive();
+                world = nullptr;
+            }
+            else {
+                done.set(true);
+            }
+            return done;
+        }
+
+    } // namespace archive
+} // namespace madness
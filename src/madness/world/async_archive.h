@@ -0,0 +1,287 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_WORLD_ASYNC_ARCHIVE_H__INCLUDED
+#define MADNESS_WORLD_ASYNC_ARCHIVE_H__INCLUDED
+
+/**
+ \file async_archive.h
+ \brief Implements \c AsyncParallelOutputArchive for checkpointing without stalling the computation.
+ \ingroup serialization
+*/
+
+#include <type_traits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <madness/world/archive.h>
+#include <madness/world/parallel_archive.h>
+#include <madness/world/future.h>
+
+namespace madness {
+    namespace archive {
+
+        /// \addtogroup serialization
+        /// @{
+
+        /// An archive that serializes into memory, with random access for patching.
+
+        /// Used as the local archive of \c AsyncParallelOutputArchive.
+        /// The bytes are exactly those a \c BinaryFstreamOutputArchive would
+        /// write to its file (after the leading cookie).
+        class SnapshotOutputArchive : public BaseOutputArchive {
+            std::shared_ptr< std::vector<unsigned char> > v; ///< The data.
+            mutable std::size_t pos; ///< Current write position.
+
+        public:
+            /// Creates an empty snapshot.
+            SnapshotOutputArchive()
+                : v(std::make_shared< std::vector<unsigned char> >()), pos(0) {}
+
+            /// Write to the snapshot, overwriting data at the current position if any.
+
+            /// The function only appears (due to \c enable_if) if \c T is
+            /// serializable.
+            /// \tparam T The type of data to be written.
+            /// \param[in] t Location of the data to be written.
+            /// \param[in] n The number of data items to be written.
+            template <class T>
+            inline
+            typename std::enable_if< madness::is_serializable<T>::value, void >::type
+            store(const T* t, long n) const {
+                const unsigned char* ptr = (const unsigned char*) t;
+                const std::size_t nbyte = n*sizeof(T);
+                if (pos == v->size()) {
+                    v->insert(v->end(), ptr, ptr+nbyte);
+                }
+                else {
+                    MADNESS_ASSERT(pos+nbyte <= v->size());
+                    std::memcpy(&(*v)[pos], ptr, nbyte);
+                }
+                pos += nbyte;
+            }
+
+            /// Returns the current write position.
+
+            /// \return The offset in bytes from the start of the snapshot.
+            long tell() const {
+                return pos;
+            }
+
+            /// Moves the write position within the data already written.
+
+            /// \param[in] p The offset in bytes from the start of the snapshot.
+            void seek(long p) {
+                MADNESS_ASSERT(p >= 0 && std::size_t(p) <= v->size());
+                pos = p;
+            }
+
+            /// Returns the data, which is shared and not copied.
+
+            /// \return The data.
+            const std::shared_ptr< std::vector<unsigned char> >& data() const {
+                return v;
+            }
+        };
+
+
+        /// A parallel output archive that snapshots data in memory and writes it from a background thread.
+
+        /// Every process is its own I/O node. Writing a \c WorldContainer
+        /// serializes the local entries into the process's in-memory
+        /// snapshot without any communication or fences, and serial objects
+        /// are recorded by process zero only. \c close() hands the snapshot
+        /// to a dedicated I/O thread and returns immediately with a future
+        /// that is assigned once the file is on disk. The files have the same
+        /// layout as those of a \c ParallelOutputArchive with one writer per
+        /// process, and are read back with \c ParallelInputArchive by any
+        /// number of processes.
+        ///
+        /// The snapshot is a deep copy made at the time of writing, so the
+        /// objects may be modified as soon as they have been written to the
+        /// archive. The caller must ensure that the objects are complete
+        /// (no pending updates) when writing them, and should wait for the
+        /// future before overwriting the same archive or exiting.
+        ///
+        /// Each file is written under a temporary name and then renamed, so a
+        /// crash during the write leaves the previous file intact.
+        class AsyncParallelOutputArchive : public BaseOutputArchive {
+            World* world; ///< The world.
+            mutable SnapshotOutputArchive ar; ///< The local snapshot.
+            std::string fname; ///< Base name of the archive.
+
+        public:
+            static const bool is_parallel_archive = true; ///< Mark this class as a parallel archive.
+
+            /// Default constructor.
+            AsyncParallelOutputArchive() : world(nullptr) {}
+
+            /// Creates an archive for output with the given base filename.
+
+            /// \param[in] world The world.
+            /// \param[in] filename Base name of the file.
+            AsyncParallelOutputArchive(World& world, const char* filename) : world(nullptr) {
+                open(world, filename);
+            }
+
+            /// Starts writing the archive if it is still open.
+            ~AsyncParallelOutputArchive() {
+                close();
+            }
+
+            /// Opens the archive.
+
+            /// \param[in] world The world.
+            /// \param[in] filename Base name of the file.
+            void open(World& world, const char* filename);
+
+            /// Hands the snapshot to the I/O thread and closes the archive.
+
+            /// \return A future assigned once this process's file has been
+            ///     written; its value is false if writing failed.
+            Future<bool> close();
+
+            /// Returns a pointer to the world.
+
+            /// \return A pointer to the world.
+            World* get_world() const {
+                MADNESS_ASSERT(world);
+                return world;
+            }
+
+            /// Returns a reference to the local snapshot.
+
+            /// \return A reference to the local snapshot.
+            SnapshotOutputArchive& local_archive() const {
+                MADNESS_ASSERT(world);
+                return ar;
+            }
+
+            /// Parallel objects are written without fences.
+
+            /// \return False.
+            bool dofence() const {
+                return false;
+            }
+        };
+
+        /// Disable type info for asynchronous parallel output archives.
+
+        /// \tparam T The data type.
+        template <class T>
+        struct ArchivePrePostImpl<AsyncParallelOutputArchive,T> {
+            /// Store the preamble for this data type in the parallel archive.
+
+            /// \param[in] ar The archive.
+            static void preamble_store(const AsyncParallelOutputArchive& ar) {}
+
+            /// Store the postamble for this data type in the parallel archive.
+
+            /// \param[in] ar The archive.
+            static inline void postamble_store(const AsyncParallelOutputArchive& ar) {}
+        };
+
+        /// Specialization of \c ArchiveImpl for asynchronous parallel output archives.
+
+        /// \attention No type-checking is performed.
+        /// \tparam T The data type.
+        template <class T>
+        struct ArchiveImpl<AsyncParallelOutputArchive, T> {
+            /// Parallel objects are forwarded to their implementation of parallel store.
+
+            /// \tparam Q The data type.
+            /// \param[in] ar The parallel archive.
+            /// \param[in] t The parallel object to store.
+            /// \return The parallel archive.
+            template <typename Q>
+            static inline
+            typename std::enable_if<std::is_base_of<ParallelSerializableObject, Q>::value, const AsyncParallelOutputArchive&>::type
+            wrap_store(const AsyncParallelOutputArchive& ar, const Q& t) {
+                ArchiveStoreImpl<AsyncParallelOutputArchive,T>::store(ar,t);
+                return ar;
+            }
+
+            /// Serial objects write only from process 0.
+
+            /// \tparam Q The data type.
+            /// \param[in] ar The parallel archive.
+            /// \param[in] t The serial data.
+            /// \return The parallel archive.
+            template <typename Q>
+            static inline
+            typename std::enable_if<!std::is_base_of<ParallelSerializableObject, Q>::value, const AsyncParallelOutputArchive&>::type
+            wrap_store(const AsyncParallelOutputArchive& ar, const Q& t) {
+                if (ar.get_world()->rank()==0) {
+                    ar.local_archive() & t;
+                }
+                return ar;
+            }
+        };
+
+        /// Write the archive array only from process zero.
+
+        /// \tparam T The array data type.
+        template <class T>
+        struct ArchiveImpl< AsyncParallelOutputArchive, archive_array<T> > {
+            /// Store the \c archive_array in the parallel archive.
+
+            /// \param[in] ar The parallel archive.
+            /// \param[in] t The array to store.
+            /// \return The parallel archive.
+            static inline const AsyncParallelOutputArchive& wrap_store(const AsyncParallelOutputArchive& ar, const archive_array<T>& t) {
+                if (ar.get_world()->rank() == 0) ar.local_archive() & t;
+                return ar;
+            }
+        };
+
+        /// Forward a fixed-size array to \c archive_array.
+
+        /// \tparam T The array data type.
+        /// \tparam n The number of items in the array.
+        template <class T, std::size_t n>
+        struct ArchiveImpl<AsyncParallelOutputArchive, T[n]> {
+            /// Store the array in the parallel archive.
+
+            /// \param[in] ar The parallel archive.
+            /// \param[in] t The array to store.
+            /// \return The parallel archive.
+            static inline const AsyncParallelOutputArchive& wrap_store(const AsyncParallelOutputArchive& ar, const T(&t)[n]) {
+                ar << wrap(&t[0],n);
+                return ar;
+            }
+        };
+
+        /// @}
+    }
+}
+
+#endif // MADNESS_WORLD_ASYNC_ARCHIVE_H__INCLUDED
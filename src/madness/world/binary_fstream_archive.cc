@@ -70,6 +70,15 @@ namespace madness {
             os.flush();
         }
 
+        long BinaryFstreamOutputArchive::tell() const {
+            return long(os.tellp());
+        }
+
+        void BinaryFstreamOutputArchive::seek(long pos) {
+            os.seekp(pos);
+            if (!os) MADNESS_EXCEPTION("BinaryFstreamOutputArchive: seek: failed", 1);
+        }
+
         BinaryFstreamInputArchive::BinaryFstreamInputArchive(const char* filename, std::ios_base::openmode mode)
                 : iobuf() {
             if (filename) open(filename, mode);
@@ -95,5 +104,15 @@ namespace madness {
             }
         }
 
+        long BinaryFstreamInputArchive::tell() const {
+            return long(is.tellg());
+        }
+
+        void BinaryFstreamInputArchive::seek(long pos) const {
+            is.clear();
+            is.seekg(pos);
+            if (!is) MADNESS_EXCEPTION("BinaryFstreamInputArchive: seek: failed", 1);
+        }
+
     } // namespace archive
 } // namespace madness
@@ -93,6 +93,16 @@ namespace madness {
 
             /// Flush the filestream.
             void flush();
+
+            /// Returns the current write position in the file.
+
+            /// \return The offset in bytes from the start of the file.
+            long tell() const;
+
+            /// Moves the write position in the file.
+
+            /// \param[in] pos The offset in bytes from the start of the file.
+            void seek(long pos);
         };
 
         /// Wraps an archive around a binary filestream for input.
@@ -132,6 +142,16 @@ namespace madness {
 
             /// Close the filestream.
             void close();
+
+            /// Returns the current read position in the file.
+
+            /// \return The offset in bytes from the start of the file.
+            long tell() const;
+
+            /// Moves the read position in the file.
+
+            /// \param[in] pos The offset in bytes from the start of the file.
+            void seek(long pos) const;
         };
 
         /// @}
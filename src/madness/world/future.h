@@ -44,6 +44,7 @@
 #include <madness/world/nodefaults.h>
 #include <madness/world/dependency_interface.h>
 #include <madness/world/stack.h>
+#include <madness/world/memory_pool.h>
 #include <madness/world/worldref.h>
 #include <madness/world/world.h>
 
@@ -433,13 +434,24 @@ namespace madness {
         /// \param[in] blah Description needed.
         explicit Future(const dddd& blah) : f(), value(nullptr) { }
 
+        /// Makes the implementation of an unassigned future.
+
+        /// The \c FutureImpl and the control block of its \c shared_ptr are
+        /// allocated together, in one block recycled by the \c SlabAllocator.
+        /// \param[in] args The arguments of the \c FutureImpl constructor.
+        /// \return The implementation.
+        template <typename... argsT>
+        static std::shared_ptr< FutureImpl<T> > make_impl(const argsT&... args) {
+            return std::allocate_shared< FutureImpl<T> >(SlabAllocator::Allocator< FutureImpl<T> >(), args...);
+        }
+
     public:
         /// \todo Brief description needed.
         typedef RemoteReference< FutureImpl<T> > remote_refT;
 
         /// Makes an unassigned future.
         Future() :
-            f(new FutureImpl<T>()), value(nullptr)
+            f(make_impl()), value(nullptr)
         { }
 
         /// Makes an assigned future.
@@ -457,8 +469,7 @@ namespace madness {
         explicit Future(const remote_refT& remote_ref) :
                 f(remote_ref.is_local() ?
                         remote_ref.get_shared() :
-                        std::make_shared<FutureImpl<T> >(remote_ref)),
-                //                        std::shared_ptr<FutureImpl<T> >(new FutureImpl<T>(remote_ref))),
+                        make_impl(remote_ref)),
                 value(nullptr)
         { }
 
@@ -483,7 +494,7 @@ namespace madness {
                 nullptr)
         {
             if(other.is_default_initialized())
-                f.reset(new FutureImpl<T>()); // Other was default constructed so make a new f
+                f = make_impl(); // Other was default constructed so make a new f
         }
 
         /// Destructor.
@@ -0,0 +1,302 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/**
+ \file memory_pool.cc
+ \brief Implements MemoryPool, a thread-caching size-class allocator, and
+    SlabAllocator, which recycles the small objects of the runtime.
+ \ingroup world
+*/
+
+#include <madness/world/memory_pool.h>
+#include <madness/world/numa.h>
+#include <madness/world/worldmutex.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+namespace madness {
+
+    volatile bool MemoryPool::enabled_ = false;
+    std::size_t MemoryPool::max_cached_bytes_ = 64ul << 20;
+    std::size_t MemoryPool::max_block_bytes_ = 16ul << 20;
+
+    /// Free lists and statistics of one thread.
+    class MemoryPool::ThreadCache {
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        std::unordered_map<std::size_t, FreeBlock*> bins; ///< Free lists keyed by rounded size.
+        std::size_t nbyte_cached; ///< Bytes in the free lists.
+
+    public:
+        Stats stats; ///< Statistics of this thread.
+
+        ThreadCache();
+
+        ~ThreadCache();
+
+        static std::size_t round(std::size_t nbyte) {
+            return ((nbyte + alignment - 1)/alignment)*alignment;
+        }
+
+        void* allocate(std::size_t nbyte) {
+            ++stats.nalloc;
+            const std::size_t key = round(nbyte);
+            std::unordered_map<std::size_t, FreeBlock*>::iterator it = bins.find(key);
+            if (it != bins.end() && it->second) {
+                FreeBlock* const block = it->second;
+                it->second = block->next;
+                nbyte_cached -= key;
+                stats.cur_cached_bytes = nbyte_cached;
+                ++stats.nhit;
+                return block;
+            }
+
+            void* p = nullptr;
+            if (numa_memalign(&p, alignment, key)) throw std::bad_alloc();
+            return p;
+        }
+
+        void deallocate(void* p, std::size_t nbyte) {
+            ++stats.nfree;
+            const std::size_t key = round(nbyte);
+            if (key > max_block_bytes_ || nbyte_cached + key > max_cached_bytes_) {
+                ++stats.nrelease;
+                free(p);
+                return;
+            }
+
+            FreeBlock* const block = static_cast<FreeBlock*>(p);
+            FreeBlock*& head = bins[key];
+            block->next = head;
+            head = block;
+            nbyte_cached += key;
+            stats.cur_cached_bytes = nbyte_cached;
+            stats.max_cached_bytes = std::max(stats.max_cached_bytes, stats.cur_cached_bytes);
+        }
+
+        void release() {
+            for (std::unordered_map<std::size_t, FreeBlock*>::iterator it = bins.begin(); it != bins.end(); ++it) {
+                while (it->second) {
+                    FreeBlock* const block = it->second;
+                    it->second = block->next;
+                    free(block);
+                    ++stats.nrelease;
+                }
+            }
+            bins.clear();
+            nbyte_cached = 0;
+            stats.cur_cached_bytes = 0;
+        }
+    };
+
+    namespace {
+
+        // Registry of live thread caches and totals of those that have exited
+        Mutex registry_mutex;
+        std::vector<const MemoryPool::Stats*> registry;
+        MemoryPool::Stats retired;
+
+        // 0 = not constructed, 1 = live, 2 = destroyed. Trivially destructible
+        // so it can be tested while the thread is exiting.
+        thread_local int cache_state = 0;
+
+        void add_stats(MemoryPool::Stats& sum, const MemoryPool::Stats& s) {
+            sum.nalloc += s.nalloc;
+            sum.nhit += s.nhit;
+            sum.nfree += s.nfree;
+            sum.nrelease += s.nrelease;
+            sum.cur_cached_bytes += s.cur_cached_bytes;
+            sum.max_cached_bytes += s.max_cached_bytes;
+        }
+
+    } // namespace
+
+    MemoryPool::ThreadCache::ThreadCache() : bins(), nbyte_cached(0), stats() {
+        ScopedMutex<Mutex> lock(registry_mutex);
+        registry.push_back(&stats);
+        cache_state = 1;
+    }
+
+    MemoryPool::ThreadCache::~ThreadCache() {
+        release();
+        cache_state = 2;
+        ScopedMutex<Mutex> lock(registry_mutex);
+        registry.erase(std::remove(registry.begin(), registry.end(), &stats), registry.end());
+        add_stats(retired, stats);
+    }
+
+    MemoryPool::ThreadCache* MemoryPool::this_cache() {
+        if (cache_state == 2) return nullptr;
+        static thread_local ThreadCache cache;
+        return &cache;
+    }
+
+    void* MemoryPool::allocate(std::size_t nbyte) {
+        if (nbyte == 0) nbyte = 1;
+        ThreadCache* const cache = this_cache();
+        if (cache) return cache->allocate(nbyte);
+
+        void* p = nullptr;
+        if (numa_memalign(&p, alignment, ThreadCache::round(nbyte))) throw std::bad_alloc();
+        return p;
+    }
+
+    void MemoryPool::deallocate(void* p, std::size_t nbyte) {
+        if (!p) return;
+        ThreadCache* const cache = this_cache();
+        if (cache) cache->deallocate(p, nbyte);
+        else free(p);
+    }
+
+    void MemoryPool::release_thread_cache() {
+        ThreadCache* const cache = this_cache();
+        if (cache) cache->release();
+    }
+
+    MemoryPool::Stats MemoryPool::get_stats() {
+        ScopedMutex<Mutex> lock(registry_mutex);
+        Stats sum = retired;
+        sum.cur_cached_bytes = 0; // Exited threads hold nothing
+        for (std::size_t i=0; i<registry.size(); ++i)
+            add_stats(sum, *registry[i]);
+        return sum;
+    }
+
+    /// The slabs and free lists of one thread.
+
+    /// Owned by its thread and never destroyed, since blocks made by a thread
+    /// may be freed by another after the first has exited.
+    class SlabAllocator::ThreadSlabs {
+        static const std::size_t nclass = max_size/granularity;
+        static const std::size_t header_size = 64; ///< Bytes before the first block of a slab.
+
+        struct Block {
+            Block* next;
+        };
+
+        Block* local[nclass];               ///< Free lists of this thread.
+        std::atomic<Block*> remote[nclass]; ///< Blocks freed by other threads.
+
+        /// Carves a new slab into blocks of size class \c c.
+
+        /// \return The list of blocks.
+        Block* new_slab(std::size_t c) {
+            void* slab = nullptr;
+            if (posix_memalign(&slab, slab_size, slab_size)) throw std::bad_alloc();
+            *static_cast<ThreadSlabs**>(slab) = this;
+
+            const std::size_t bsize = (c + 1)*granularity;
+            const std::size_t n = (slab_size - header_size)/bsize;
+            char* const first = static_cast<char*>(slab) + header_size;
+            for (std::size_t i=0; i<n-1; ++i)
+                reinterpret_cast<Block*>(first + i*bsize)->next = reinterpret_cast<Block*>(first + (i+1)*bsize);
+            reinterpret_cast<Block*>(first + (n-1)*bsize)->next = nullptr;
+            return reinterpret_cast<Block*>(first);
+        }
+
+    public:
+        ThreadSlabs() {
+            for (std::size_t c=0; c<nclass; ++c) {
+                local[c] = nullptr;
+                remote[c] = nullptr;
+            }
+        }
+
+        /// The size class of an object of \c nbyte bytes (at most \c max_size).
+        static std::size_t size_class(std::size_t nbyte) {
+            return (nbyte + granularity - 1)/granularity - 1;
+        }
+
+        /// The thread that owns the slab of block \c p.
+        static ThreadSlabs* owner(void* p) {
+            return *reinterpret_cast<ThreadSlabs**>(reinterpret_cast<std::uintptr_t>(p) & ~std::uintptr_t(slab_size - 1));
+        }
+
+        void* allocate(std::size_t c) {
+            Block* b = local[c];
+            if (!b) {
+                b = remote[c].exchange(nullptr, std::memory_order_acquire);
+                if (!b) b = new_slab(c);
+            }
+            local[c] = b->next;
+            return b;
+        }
+
+        /// Frees a block of this thread from this thread.
+        void deallocate_local(void* p, std::size_t c) {
+            Block* const b = static_cast<Block*>(p);
+            b->next = local[c];
+            local[c] = b;
+        }
+
+        /// Frees a block of this thread from another thread.
+        void deallocate_remote(void* p, std::size_t c) {
+            // Only the owner removes blocks, and only the whole list at once,
+            // so pushes cannot suffer from ABA
+            Block* const b = static_cast<Block*>(p);
+            b->next = remote[c].load(std::memory_order_relaxed);
+            while (!remote[c].compare_exchange_weak(b->next, b, std::memory_order_release,
+                                                    std::memory_order_relaxed)) ;
+        }
+    };
+
+    SlabAllocator::ThreadSlabs* SlabAllocator::this_slabs() {
+        static thread_local ThreadSlabs* slabs = nullptr;
+        if (!slabs) slabs = new ThreadSlabs;
+        return slabs;
+    }
+
+    void* SlabAllocator::allocate(std::size_t nbyte) {
+        if (nbyte > max_size) return ::operator new(nbyte);
+        if (nbyte == 0) nbyte = 1;
+        return this_slabs()->allocate(ThreadSlabs::size_class(nbyte));
+    }
+
+    void SlabAllocator::deallocate(void* p, std::size_t nbyte) {
+        if (!p) return;
+        if (nbyte > max_size) {
+            ::operator delete(p);
+            return;
+        }
+        if (nbyte == 0) nbyte = 1;
+        ThreadSlabs* const me = this_slabs();
+        ThreadSlabs* const owner = ThreadSlabs::owner(p);
+        if (owner == me) me->deallocate_local(p, ThreadSlabs::size_class(nbyte));
+        else owner->deallocate_remote(p, ThreadSlabs::size_class(nbyte));
+    }
+
+} // namespace madness
@@ -0,0 +1,278 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_WORLD_MEMORY_POOL_H__INCLUDED
+#define MADNESS_WORLD_MEMORY_POOL_H__INCLUDED
+
+/**
+ \file memory_pool.h
+ \brief Implements MemoryPool, a thread-caching size-class allocator, and
+    SlabAllocator, which recycles the small objects of the runtime.
+ \ingroup world
+*/
+
+#include <cstddef>
+#include <new>
+
+namespace madness {
+
+    /// A thread-caching, size-class allocator for short-lived blocks.
+
+    /// Numerical kernels allocate and free many blocks of a few recurring
+    /// sizes (e.g., the `(k)^NDIM` and `(2k)^NDIM` coefficient tensors of a
+    /// function). Each thread keeps free lists keyed by byte size (rounded
+    /// up to a multiple of \c alignment) so that a block freed by a thread
+    /// is handed back to the next request of the same size without calling
+    /// `malloc` or `free`. Blocks freed by a different thread than the one
+    /// that allocated them simply migrate to the cache of the freeing thread.
+    ///
+    /// Each thread caches at most \c max_cached_bytes() and blocks larger
+    /// than \c max_block_bytes() are never cached; the excess goes straight
+    /// back to the system. New blocks come from \c numa_memalign so NUMA
+    /// placement is respected.
+    ///
+    /// The pool is off by default. It is turned on with \c enable() or by
+    /// setting the environment variable `MAD_TENSOR_POOL` to a non-zero
+    /// value before \c initialize(). Memory obtained from the pool must be
+    /// returned with \c deallocate() (with the same size) even if the pool
+    /// has since been turned off.
+    class MemoryPool {
+    public:
+        static const std::size_t alignment = 64; ///< Alignment of all blocks, also the size granularity.
+
+        /// Statistics of the pool, summed over all threads.
+        struct Stats {
+            unsigned long nalloc;       ///< Calls to allocate
+            unsigned long nhit;         ///< Allocations served from a cache
+            unsigned long nfree;        ///< Calls to deallocate
+            unsigned long nrelease;     ///< Blocks returned to the system
+            unsigned long cur_cached_bytes; ///< Bytes currently held in the caches
+            unsigned long max_cached_bytes; ///< Sum of the per-thread lifetime maxima of cached bytes
+
+            Stats()
+                : nalloc(0), nhit(0), nfree(0), nrelease(0)
+                , cur_cached_bytes(0), max_cached_bytes(0) {}
+        };
+
+        /// Functor that returns a block of fixed size to the pool.
+
+        /// Suitable as the deleter of a \c std::shared_ptr.
+        class Deleter {
+            std::size_t nbyte; ///< Size of the block.
+        public:
+            explicit Deleter(std::size_t nbyte) : nbyte(nbyte) { }
+
+            void operator()(void* p) const {
+                MemoryPool::deallocate(p, nbyte);
+            }
+        };
+
+        /// Standard allocator drawing from the pool.
+
+        /// Used, e.g., for the control blocks of \c std::shared_ptr.
+        /// \tparam T The value type.
+        template <typename T>
+        class Allocator {
+        public:
+            typedef T value_type;
+
+            Allocator() { }
+
+            template <typename U>
+            Allocator(const Allocator<U>&) { }
+
+            T* allocate(std::size_t n) {
+                return static_cast<T*>(MemoryPool::allocate(n*sizeof(T)));
+            }
+
+            void deallocate(T* p, std::size_t n) {
+                MemoryPool::deallocate(p, n*sizeof(T));
+            }
+
+            template <typename U>
+            bool operator==(const Allocator<U>&) const { return true; }
+
+            template <typename U>
+            bool operator!=(const Allocator<U>&) const { return false; }
+        };
+
+    private:
+        static volatile bool enabled_; ///< True if the pool is in use.
+        static std::size_t max_cached_bytes_; ///< Per-thread cache capacity.
+        static std::size_t max_block_bytes_; ///< Largest block that is cached.
+
+        class ThreadCache;
+
+        /// The cache of the calling thread, or null if the thread is exiting.
+        static ThreadCache* this_cache();
+
+    public:
+        /// Turn the pool on or off.
+
+        /// \param[in] flag True to turn the pool on.
+        static void enable(bool flag=true) {
+            enabled_ = flag;
+        }
+
+        /// Test if the pool is on.
+
+        /// \return True if the pool is on.
+        static bool enabled() {
+            return enabled_;
+        }
+
+        /// Set the maximum number of bytes cached by each thread.
+
+        /// \param[in] nbyte The capacity in bytes.
+        static void set_max_cached_bytes(std::size_t nbyte) {
+            max_cached_bytes_ = nbyte;
+        }
+
+        /// Get the maximum number of bytes cached by each thread.
+
+        /// \return The capacity in bytes.
+        static std::size_t max_cached_bytes() {
+            return max_cached_bytes_;
+        }
+
+        /// Set the size of the largest block that is cached.
+
+        /// \param[in] nbyte The size in bytes.
+        static void set_max_block_bytes(std::size_t nbyte) {
+            max_block_bytes_ = nbyte;
+        }
+
+        /// Get the size of the largest block that is cached.
+
+        /// \return The size in bytes.
+        static std::size_t max_block_bytes() {
+            return max_block_bytes_;
+        }
+
+        /// Allocate a block aligned to \c alignment.
+
+        /// \param[in] nbyte The size of the block in bytes.
+        /// \return The block.
+        /// \throw std::bad_alloc If the allocation failed.
+        static void* allocate(std::size_t nbyte);
+
+        /// Return a block to the pool.
+
+        /// \param[in] p The block (may be null).
+        /// \param[in] nbyte The size used to allocate it.
+        static void deallocate(void* p, std::size_t nbyte);
+
+        /// Release all blocks cached by the calling thread to the system.
+        static void release_thread_cache();
+
+        /// Get the statistics of the pool, summed over all threads.
+
+        /// Counters of threads that are running are read without locking
+        /// so the result is only approximate while the pool is busy.
+        /// \return The statistics.
+        static Stats get_stats();
+    };
+
+    /// A per-thread slab allocator for the small objects of the runtime.
+
+    /// Every task allocates a task object and usually the \c FutureImpl of
+    /// its result, and these are typically freed by a different thread than
+    /// the one that made them (the main thread submits, a pool thread runs).
+    /// Objects of up to \c max_size bytes are therefore carved from slabs
+    /// of \c slab_size bytes owned by one thread, with a free list per size
+    /// class. A block freed by its owner goes back on the owner's free list;
+    /// a block freed by another thread is pushed onto a lock-free list of
+    /// the owner, which takes the whole list back when its own runs dry.
+    /// In the steady state no object of the runtime touches \c malloc.
+    ///
+    /// Slabs are never returned to the system, so the memory held is that
+    /// of the largest number of objects alive at any time. Larger objects
+    /// are passed to the global \c operator \c new.
+    class SlabAllocator {
+    public:
+        static const std::size_t granularity = 32;        ///< Sizes are rounded up to a multiple of this.
+        static const std::size_t max_size = 1024;         ///< Largest object taken from the slabs.
+        static const std::size_t slab_size = 64ul << 10;  ///< Size and alignment of each slab.
+
+        /// Standard allocator drawing from the slabs.
+
+        /// Used for \c std::allocate_shared, so that an object and the
+        /// control block of its \c shared_ptr share one block.
+        /// \tparam T The value type.
+        template <typename T>
+        class Allocator {
+        public:
+            typedef T value_type;
+
+            Allocator() { }
+
+            template <typename U>
+            Allocator(const Allocator<U>&) { }
+
+            T* allocate(std::size_t n) {
+                return static_cast<T*>(SlabAllocator::allocate(n*sizeof(T)));
+            }
+
+            void deallocate(T* p, std::size_t n) {
+                SlabAllocator::deallocate(p, n*sizeof(T));
+            }
+
+            template <typename U>
+            bool operator==(const Allocator<U>&) const { return true; }
+
+            template <typename U>
+            bool operator!=(const Allocator<U>&) const { return false; }
+        };
+
+    private:
+        class ThreadSlabs;
+
+        /// The slabs of the calling thread, made on first use.
+        static ThreadSlabs* this_slabs();
+
+    public:
+        /// Allocate an object.
+
+        /// \param[in] nbyte The size of the object in bytes.
+        /// \return The memory for the object.
+        /// \throw std::bad_alloc If the allocation failed.
+        static void* allocate(std::size_t nbyte);
+
+        /// Free an object from any thread.
+
+        /// \param[in] p The memory of the object (may be null).
+        /// \param[in] nbyte The size used to allocate it.
+        static void deallocate(void* p, std::size_t nbyte);
+    };
+
+} // namespace madness
+
+#endif // MADNESS_WORLD_MEMORY_POOL_H__INCLUDED
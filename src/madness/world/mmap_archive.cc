@@ -0,0 +1,133 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/**
+ \file mmap_archive.cc
+ \brief Implements an archive that is read back by mapping the file into memory.
+ \ingroup serialization
+*/
+
+#include <madness/world/mmap_archive.h>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace madness {
+    namespace archive {
+
+        namespace {
+            const char MMAP_ARCHIVE_COOKIE[] = "mmaparchive";
+            const long MMAP_ARCHIVE_ALIGNMENT = 64; ///< Alignment of the header, enough for any tensor
+        }
+
+        MMapOutputArchive::MMapOutputArchive(const char* filename)
+                : iobuf(), pos(0)
+        {
+            if (filename) open(filename);
+        }
+
+        void MMapOutputArchive::open(const char* filename) {
+            iobuf.reset(new char[IOBUFSIZE], std::default_delete<char[]>() );
+            os.open(filename, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+#ifndef ON_A_MAC
+            os.rdbuf()->pubsetbuf(iobuf.get(), IOBUFSIZE);
+#endif
+            if (!os) MADNESS_EXCEPTION("MMapOutputArchive: open: failed", 1);
+            pos = 0;
+
+            store(MMAP_ARCHIVE_COOKIE, sizeof(MMAP_ARCHIVE_COOKIE));
+            store(&MMAP_ARCHIVE_ALIGNMENT, 1);
+            align(MMAP_ARCHIVE_ALIGNMENT);
+        }
+
+        void MMapOutputArchive::align(std::size_t alignment) const {
+            static const char zeros[64] = {0};
+            long npad = (alignment - pos%alignment)%alignment;
+            while (npad > 0) {
+                long n = std::min(npad, long(sizeof(zeros)));
+                store(zeros, n);
+                npad -= n;
+            }
+        }
+
+        void MMapOutputArchive::close() {
+            if (iobuf) {
+                os.close();
+                iobuf.reset();
+            }
+        }
+
+        void MMapOutputArchive::flush() {
+            os.flush();
+        }
+
+        MMapInputArchive::MMapInputArchive(const char* filename)
+                : map(), length(0), pos(0)
+        {
+            if (filename) open(filename);
+        }
+
+        void MMapInputArchive::open(const char* filename) {
+            close();
+            int fd = ::open(filename, O_RDONLY);
+            if (fd < 0) MADNESS_EXCEPTION("MMapInputArchive: open: failed", 1);
+            struct stat st;
+            if (fstat(fd, &st) || st.st_size == 0) {
+                ::close(fd);
+                MADNESS_EXCEPTION("MMapInputArchive: open: not an archive?", 1);
+            }
+            const std::size_t len = st.st_size;
+            // Private and writable: modified pages are copied, the file is left alone
+            void* addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            ::close(fd); // The mapping keeps its own reference to the file
+            if (addr == MAP_FAILED) MADNESS_EXCEPTION("MMapInputArchive: open: mmap failed", 1);
+            map.reset(static_cast<char*>(addr), [len](char* p) { munmap(p, len); });
+            length = len;
+
+            char cookie[sizeof(MMAP_ARCHIVE_COOKIE)];
+            long alignment = 0;
+            load(cookie, sizeof(cookie));
+            if (strncmp(cookie, MMAP_ARCHIVE_COOKIE, sizeof(cookie)) != 0)
+                MADNESS_EXCEPTION("MMapInputArchive: open: not an archive?", 1);
+            load(&alignment, 1);
+            MADNESS_ASSERT(alignment == MMAP_ARCHIVE_ALIGNMENT);
+            align(alignment);
+        }
+
+        void MMapInputArchive::close() {
+            map.reset();
+            length = pos = 0;
+        }
+
+    } // namespace archive
+} // namespace madness
@@ -0,0 +1,188 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_WORLD_MMAP_ARCHIVE_H__INCLUDED
+#define MADNESS_WORLD_MMAP_ARCHIVE_H__INCLUDED
+
+/**
+ \file mmap_archive.h
+ \brief Implements an archive that is read back by mapping the file into memory.
+ \ingroup serialization
+*/
+
+#include <type_traits>
+#include <fstream>
+#include <memory>
+#include <cstring>
+#include <madness/world/archive.h>
+#include <madness/world/madness_exception.h>
+
+namespace madness {
+    namespace archive {
+
+        /// \addtogroup serialization
+        /// @{
+
+        /// Wraps an archive around a binary filestream for output, with support for aligned payloads.
+
+        /// The file starts with a header (a cookie and the alignment of the
+        /// payloads). Large arrays, such as the data of a \c Tensor, are
+        /// padded to start at a multiple of the alignment so that
+        /// \c MMapInputArchive can hand out pointers into the mapped file
+        /// rather than copying the data.
+        class MMapOutputArchive : public BaseOutputArchive {
+            static const std::size_t IOBUFSIZE = 4*1024*1024; ///< Buffer size.
+            std::shared_ptr<char> iobuf; ///< Buffer.
+            mutable std::ofstream os; ///< The filestream.
+            mutable long pos; ///< Number of bytes written so far.
+
+        public:
+            /// Default constructor.
+
+            /// The filename is optional here; it can be specified later
+            /// by calling \c open().
+            /// \param[in] filename Name of the file to write to.
+            MMapOutputArchive(const char* filename = nullptr);
+
+            /// Write to the filestream.
+
+            /// The function only appears (due to \c enable_if) if \c T is
+            /// serializable.
+            /// \tparam T The type of data to be written.
+            /// \param[in] t Location of the data to be written.
+            /// \param[in] n The number of data items to be written.
+            template <class T>
+            inline
+            typename std::enable_if< madness::is_serializable<T>::value, void >::type
+            store(const T* t, long n) const {
+                os.write((const char *) t, n*sizeof(T));
+                pos += n*sizeof(T);
+            }
+
+            /// Pads the file with zeros so that the next item starts at a multiple of \c alignment.
+
+            /// \param[in] alignment The alignment in bytes.
+            void align(std::size_t alignment) const;
+
+            /// Open the filestream.
+
+            /// \param[in] filename The name of the file.
+            void open(const char* filename);
+
+            /// Close the filestream.
+            void close();
+
+            /// Flush the filestream.
+            void flush();
+        };
+
+
+        /// An archive that maps a file written by \c MMapOutputArchive into memory.
+
+        /// The file is mapped privately and writable, so data handed out by
+        /// \c alias() shares the pages of the file until it is modified, at
+        /// which point the kernel copies just the touched pages (the file
+        /// itself is never changed). The mapping stays alive until the
+        /// archive is closed and every alias has been released.
+        class MMapInputArchive : public BaseInputArchive {
+            std::shared_ptr<char> map; ///< The mapped file.
+            std::size_t length; ///< Length of the mapped file in bytes.
+            mutable std::size_t pos; ///< Current read position.
+
+            /// Throws unless another \c nbyte bytes can be read.
+
+            /// \param[in] nbyte The number of bytes to be read.
+            void check(std::size_t nbyte) const {
+                if (pos + nbyte > length)
+                    MADNESS_EXCEPTION("MMapInputArchive: read past end of file", 1);
+            }
+
+        public:
+            /// Default constructor.
+
+            /// The filename is optional here; it can be specified later
+            /// by calling \c open().
+            /// \param[in] filename Name of the file to read from.
+            MMapInputArchive(const char* filename = nullptr);
+
+            /// Load from the mapped file.
+
+            /// The function only appears (due to \c enable_if) if \c T is
+            /// serializable.
+            /// \tparam T The type of data to be read.
+            /// \param[out] t Where to put the loaded data.
+            /// \param[in] n The number of data items to be loaded.
+            template <class T>
+            inline
+            typename std::enable_if< madness::is_serializable<T>::value, void >::type
+            load(T* t, long n) const {
+                check(n*sizeof(T));
+                std::memcpy((void*) t, map.get() + pos, n*sizeof(T));
+                pos += n*sizeof(T);
+            }
+
+            /// Returns a pointer to the next \c n items in the mapped file and skips past them.
+
+            /// The pointer shares ownership of the mapping. It is aligned
+            /// if the items were written after a matching call to
+            /// \c MMapOutputArchive::align().
+            /// \tparam T The type of data to be aliased.
+            /// \param[in] n The number of data items.
+            /// \return A pointer to the data within the mapping.
+            template <class T>
+            std::shared_ptr<T> alias(long n) const {
+                check(n*sizeof(T));
+                std::shared_ptr<T> p(map, reinterpret_cast<T*>(map.get() + pos));
+                pos += n*sizeof(T);
+                return p;
+            }
+
+            /// Skips the padding written by \c MMapOutputArchive::align().
+
+            /// \param[in] alignment The alignment in bytes.
+            void align(std::size_t alignment) const {
+                pos = ((pos + alignment - 1)/alignment)*alignment;
+            }
+
+            /// Map the file.
+
+            /// \param[in] filename Name of the file to read from.
+            void open(const char* filename);
+
+            /// Release the archive's reference to the mapping.
+            void close();
+        };
+
+        /// @}
+    }
+}
+
+#endif // MADNESS_WORLD_MMAP_ARCHIVE_H__INCLUDED
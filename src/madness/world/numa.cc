@@ -0,0 +1,175 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/**
+ \file numa.cc
+ \brief Discovery of the NUMA topology and node-local memory placement.
+ \ingroup threads
+*/
+
+#include <madness/world/numa.h>
+#include <madness/world/thread.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace madness {
+
+    std::vector< std::vector<int> > NumaTopology::node_cpus;
+    bool NumaTopology::enabled_ = false;
+    std::size_t NumaTopology::bind_threshold_ = 4096;
+
+    namespace {
+
+        // Parse a sysfs cpu list such as "0-7,16-23"
+        std::vector<int> parse_cpulist(const std::string& s) {
+            std::vector<int> cpus;
+            std::istringstream ss(s);
+            std::string range;
+            while (std::getline(ss, range, ',')) {
+                int lo, hi;
+                const std::size_t dash = range.find('-');
+                if (dash == std::string::npos) {
+                    if (sscanf(range.c_str(), "%d", &lo) != 1) continue;
+                    hi = lo;
+                }
+                else if (sscanf(range.c_str(), "%d-%d", &lo, &hi) != 2) {
+                    continue;
+                }
+                for (int i=lo; i<=hi; ++i) cpus.push_back(i);
+            }
+            return cpus;
+        }
+
+        std::size_t page_size() {
+            static const long sz = sysconf(_SC_PAGESIZE);
+            return (sz > 0) ? std::size_t(sz) : 4096;
+        }
+
+    } // namespace
+
+    void NumaTopology::discover() {
+        if (! node_cpus.empty()) return;
+
+#if defined(__linux__)
+        // Nodes may be numbered sparsely, so stop only after a run of misses
+        for (int node=0, nmiss=0; nmiss<64; ++node) {
+            std::stringstream name;
+            name << "/sys/devices/system/node/node" << node << "/cpulist";
+            std::ifstream f(name.str().c_str());
+            std::string line;
+            if (f && std::getline(f, line)) {
+                node_cpus.resize(node+1);
+                node_cpus[node] = parse_cpulist(line);
+                nmiss = 0;
+            }
+            else {
+                ++nmiss;
+            }
+        }
+#endif
+
+        // Drop memory-only nodes and fall back to one node with all CPUs
+        std::vector< std::vector<int> > nodes;
+        for (std::size_t i=0; i<node_cpus.size(); ++i)
+            if (! node_cpus[i].empty()) nodes.push_back(node_cpus[i]);
+        if (nodes.empty()) {
+            nodes.resize(1);
+            const int ncpu = ThreadBase::num_hw_processors();
+            for (int i=0; i<ncpu; ++i) nodes[0].push_back(i);
+        }
+        node_cpus.swap(nodes);
+    }
+
+    void NumaTopology::enable(bool flag) {
+        discover();
+        enabled_ = flag;
+    }
+
+    int NumaTopology::num_nodes() {
+        discover();
+        return node_cpus.size();
+    }
+
+    const std::vector<int>& NumaTopology::cpus(int node) {
+        discover();
+        MADNESS_ASSERT(node >= 0 && node < int(node_cpus.size()));
+        return node_cpus[node];
+    }
+
+    int NumaTopology::node_of_cpu(int cpu) {
+        discover();
+        for (std::size_t node=0; node<node_cpus.size(); ++node)
+            for (std::size_t i=0; i<node_cpus[node].size(); ++i)
+                if (node_cpus[node][i] == cpu) return node;
+        return -1;
+    }
+
+    void NumaTopology::set_bind_threshold(std::size_t nbyte) {
+        const std::size_t page = page_size();
+        bind_threshold_ = ((nbyte + page - 1)/page)*page;
+    }
+
+    bool NumaTopology::bind_memory(void* p, std::size_t nbyte, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+        const unsigned long MPOL_PREFERRED_ = 1;
+        const int nbit = 8*sizeof(unsigned long);
+        if (node < 0 || node >= nbit) return false;
+        unsigned long mask = 1ul << node;
+        // maxnode is one more than the number of bits in the mask
+        return syscall(SYS_mbind, p, nbyte, MPOL_PREFERRED_, &mask, nbit + 1, 0) == 0;
+#else
+        return false;
+#endif
+    }
+
+    namespace detail {
+
+        int numa_memalign_bound(void** memptr, std::size_t alignment, std::size_t size) {
+            const int node = ThreadBase::this_numa_node();
+            if (node < 0) return posix_memalign(memptr, alignment, size);
+
+            // Whole pages so that the policy does not leak onto neighbors
+            const std::size_t page = page_size();
+            const std::size_t nbyte = ((size + page - 1)/page)*page;
+            const int rc = posix_memalign(memptr, (alignment > page ? alignment : page), nbyte);
+            if (rc == 0) NumaTopology::bind_memory(*memptr, nbyte, node);
+            return rc;
+        }
+
+    } // namespace detail
+
+} // namespace madness
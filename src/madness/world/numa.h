@@ -0,0 +1,146 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_WORLD_NUMA_H__INCLUDED
+#define MADNESS_WORLD_NUMA_H__INCLUDED
+
+/**
+ \file numa.h
+ \brief Discovery of the NUMA topology and node-local memory placement.
+ \ingroup threads
+*/
+
+#include <madness/world/posixmem.h>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+namespace madness {
+
+    /// \addtogroup threads
+    /// @{
+
+    /// NUMA topology of this node and control of memory placement.
+
+    /// The topology is read from `/sys/devices/system/node` (Linux only;
+    /// elsewhere, or if that fails, a single node holding all CPUs is
+    /// assumed). Placement is opt-in: \c ThreadPool binds its threads to
+    /// NUMA nodes and \c numa_memalign places memory on the node of the
+    /// calling thread only after \c enable() has been called, which
+    /// \c initialize() does if the environment variable `MAD_NUMA` is
+    /// non-zero.
+    class NumaTopology {
+        static std::vector< std::vector<int> > node_cpus; ///< CPUs of each node.
+        static bool enabled_; ///< True if NUMA placement is on.
+        static std::size_t bind_threshold_; ///< Smallest allocation that is explicitly placed.
+
+    public:
+        /// Read the topology (idempotent).
+        static void discover();
+
+        /// Turn NUMA placement of threads and memory on or off.
+
+        /// \param[in] flag True to turn placement on.
+        static void enable(bool flag=true);
+
+        /// Test if NUMA placement is on.
+
+        /// \return True if placement is on.
+        static bool enabled() {
+            return enabled_;
+        }
+
+        /// Number of NUMA nodes.
+
+        /// \return The number of nodes (at least 1).
+        static int num_nodes();
+
+        /// CPUs belonging to a NUMA node.
+
+        /// \param[in] node The node index.
+        /// \return The (OS) indices of the CPUs on \c node.
+        static const std::vector<int>& cpus(int node);
+
+        /// NUMA node of a CPU.
+
+        /// \param[in] cpu The (OS) index of the CPU.
+        /// \return The node index, or -1 if \c cpu is unknown.
+        static int node_of_cpu(int cpu);
+
+        /// Set the smallest allocation that \c numa_memalign will place.
+
+        /// Smaller allocations rely on first-touch by the allocating thread.
+        /// \param[in] nbyte The threshold in bytes (rounded up to a page).
+        static void set_bind_threshold(std::size_t nbyte);
+
+        /// Smallest allocation that \c numa_memalign will place.
+
+        /// \return The threshold in bytes.
+        static std::size_t bind_threshold() {
+            return bind_threshold_;
+        }
+
+        /// Prefer to place the pages of a region on a NUMA node.
+
+        /// Only affects pages that have not been touched yet. Fails quietly
+        /// if the system does not support it.
+        /// \param[in] p The start of the region (page aligned).
+        /// \param[in] nbyte The size of the region (a multiple of the page size).
+        /// \param[in] node The node.
+        /// \return True if the policy was set.
+        static bool bind_memory(void* p, std::size_t nbyte, int node);
+    };
+
+    namespace detail {
+        int numa_memalign_bound(void** memptr, std::size_t alignment, std::size_t size);
+    }
+
+    /// Aligned allocation on the NUMA node of the calling thread.
+
+    /// Behaves like `posix_memalign` and the memory must be released with
+    /// `free`. When NUMA placement is on, a pool thread bound to a node
+    /// allocates large blocks page aligned and binds them to its node before
+    /// first touch.
+    /// \param[out] memptr The allocated memory.
+    /// \param[in] alignment The alignment in bytes (a power of 2).
+    /// \param[in] size The size in bytes.
+    /// \return 0 on success, otherwise an error code as `posix_memalign`.
+    inline int numa_memalign(void** memptr, std::size_t alignment, std::size_t size) {
+        if (NumaTopology::enabled() && size >= NumaTopology::bind_threshold())
+            return detail::numa_memalign_bound(memptr, alignment, size);
+        return posix_memalign(memptr, alignment, size);
+    }
+
+    /// @}
+
+} // namespace madness
+
+#endif // MADNESS_WORLD_NUMA_H__INCLUDED
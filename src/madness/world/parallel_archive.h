@@ -47,6 +47,8 @@
 #include <unistd.h>
 #include <cstring>
 #include <cstdio>
+#include <string>
+#include <vector>
 
 namespace madness {
     namespace archive {
@@ -96,6 +98,25 @@ namespace madness {
                 return io_node(world->rank());
             }
 
+            /// Returns the number of I/O nodes, which is also the number of local files.
+
+            /// \return The number of I/O nodes.
+            int num_io_nodes() const {
+                MADNESS_ASSERT(world);
+                return nio;
+            }
+
+            /// Returns the name of the local file belonging to the given I/O node.
+
+            /// \param[in] ionode The I/O node.
+            /// \return The name of the local file of \c ionode.
+            std::string local_filename(ProcessID ionode) const {
+                char buf[256];
+                MADNESS_ASSERT(strlen(fname)+7 <= sizeof(buf));
+                sprintf(buf, "%s.%5.5d", fname, ionode);
+                return std::string(buf);
+            }
+
             /// Returns the number of I/O clients for this node, including self (zero if not an I/O node).
 
             /// \return The number of I/O clients for this node, including self (zero if not an I/O node).
@@ -125,11 +146,11 @@ namespace madness {
             /// \attention When writing to a new archive, the number of writers
             /// specified is used. When reading from an existing archive,
             /// the number of `ionode`s is adjusted to to be the same as
-            /// the number that wrote the original archive. Presently,
-            /// we don't have logic to handle reading an archive using
-            /// fewer processes originally used to write it. If you
-            /// want to fix this have a look in worlddc.h for the only
-            /// spot that currently needs changing to make that work.
+            /// the number that wrote the original archive. If that exceeds
+            /// the number of processes every process becomes an I/O node;
+            /// parallel containers are then read from all files by all
+            /// processes (see worlddc.h), so an archive may be read back
+            /// by any number of processes.
             ///
             /// \note The default number of I/O nodes is one and there is an
             /// arbitrary maximum of 50 set. On IBM BG/P the maximum
@@ -160,7 +181,7 @@ namespace madness {
                 if (world.rank() == 0) {
                     ar.open(buf);
                     ar & nio; // read/write nio from/to the archive
-                    MADNESS_ASSERT(nio <= world.size());
+                    MADNESS_ASSERT((nio <= world.size() || std::is_base_of<BaseInputArchive, Archive>::value));
                 }
 
                 // Ensure all agree on value of nio that may also have changed if reading
@@ -232,14 +253,15 @@ namespace madness {
             /// Deletes the files associated with the archive of the given name.
 
             /// Presently assumes a shared file system since process zero does the
-            /// deleting.
+            /// deleting. The archive may have been written by more processes
+            /// than are now running, so files are removed until one is missing.
             /// \param[in] world The world.
             /// \param[in] filename Base name of the file.
             static void remove(World& world, const char* filename) {
                 if (world.rank() == 0) {
                     char buf[256];
                     MADNESS_ASSERT(strlen(filename)+7 <= sizeof(buf));
-                    for (ProcessID p=0; p<world.size(); ++p) {
+                    for (ProcessID p=0; ; ++p) {
                         sprintf(buf, "%s.%5.5d", filename, p);
                         if (::remove(buf)) break;
                     }
@@ -279,7 +301,7 @@ namespace madness {
         /// processes send their data to servers in a round-robin fashion.
         ///
         /// Process zero records the number of writers so that, when the archive is opened
-        /// for reading, the number of readers is forced to match.
+        /// for reading, the readers know how many files to look for.
         class ParallelOutputArchive : public BaseParallelArchive<BinaryFstreamOutputArchive>, public BaseOutputArchive {
         public:
             /// Default constructor.
@@ -307,11 +329,13 @@ namespace madness {
         ///
         /// \note Reads of parallel containers (presently only \c WorldContainer) load all data.
         ///
-        /// The number of I/O nodes or readers is presently ignored. It is
-        /// forced to be the same as the original number of writers and,
-        /// therefore, you cannot presently read an archive from a parallel job
-        /// with fewer total processes than the number of writers.
+        /// The number of I/O nodes is forced to be the same as the original
+        /// number of writers. Parallel containers carry an index per file
+        /// so that every process reads its share of the entries directly,
+        /// which lets an archive be read by any number of processes.
         class ParallelInputArchive : public BaseParallelArchive<BinaryFstreamInputArchive>, public  BaseInputArchive {
+            mutable std::vector<long> next_section; ///< Offset of the next parallel object in each local file.
+
         public:
             /// Default constructor.
             ParallelInputArchive() {}
@@ -324,6 +348,34 @@ namespace madness {
             ParallelInputArchive(World& world, const char* filename, int nio=1) {
                 open(world, filename, nio);
             }
+
+            /// Opens the parallel archive for input.
+
+            /// \param[in] world The world.
+            /// \param[in] filename Base name of the file.
+            /// \param[in] nio The number of writers. Ignored, see above.
+            void open(World& world, const char* filename, int nio=1) {
+                BaseParallelArchive<BinaryFstreamInputArchive>::open(world, filename, nio);
+                next_section.assign(num_io_nodes(), long(strlen(ARCHIVE_COOKIE)+1));
+            }
+
+            /// Returns the offset at which the next parallel object starts in a local file.
+
+            /// Local files other than that of process zero hold only parallel
+            /// objects, so their read positions are tracked here by every process.
+            /// \param[in] ionode The I/O node that wrote the file.
+            /// \return The offset in bytes from the start of the file.
+            long section_offset(ProcessID ionode) const {
+                return next_section[ionode];
+            }
+
+            /// Records the offset at which the next parallel object starts in a local file.
+
+            /// \param[in] ionode The I/O node that wrote the file.
+            /// \param[in] offset The offset in bytes from the start of the file.
+            void set_section_offset(ProcessID ionode, long offset) const {
+                next_section[ionode] = offset;
+            }
         };
 
         /// Disable type info for parallel output archives.
@@ -48,6 +48,10 @@ using madness::archive::TextFstreamOutputArchive;
 using madness::archive::BinaryFstreamInputArchive;
 using madness::archive::BinaryFstreamOutputArchive;
 
+#include <madness/world/mmap_archive.h>
+using madness::archive::MMapInputArchive;
+using madness::archive::MMapOutputArchive;
+
 #include <madness/world/vector_archive.h>
 using madness::archive::VectorInputArchive;
 using madness::archive::VectorOutputArchive;
@@ -422,6 +426,18 @@ int main() {
         iar.close();
     }
 
+    {
+        const char* f = "test.dat";
+        cout << endl << "testing mmap archive" << endl;
+        MMapOutputArchive oar(f);
+        test_out(oar);
+        oar.close();
+
+        MMapInputArchive iar(f);
+        test_in(iar);
+        iar.close();
+    }
+
     {
         cout << endl << "testing vector archive" << endl;
         std::vector<unsigned char> f;
@@ -77,10 +77,11 @@ void split(const Range<ConcurrentHashMap<int,int>::iterator>& range) {
     }
 }
 
-void test_coverage() {
+void test_coverage(bool flat) {
     // This test aims for complete code coverage for whatever that
     // is worth, and tests for basic sequential correctness.
     ConcurrentHashMap<int,int> a;
+    a.set_flat_storage(flat);
     typedef ConcurrentHashMap<int,int>::datumT datumT;
     typedef ConcurrentHashMap<int,int>::iterator iteratorT;
     typedef ConcurrentHashMap<int,int>::const_iterator const_iteratorT;
@@ -277,6 +278,39 @@ void test_random() {
     }
 }
 
+void test_growth(bool flat) {
+    // Lookup cost should not depend on the number of entries since
+    // the table grows as entries are inserted
+    typedef ConcurrentHashMap<int,int>::datumT datumT;
+    typedef ConcurrentHashMap<int,int>::iterator iteratorT;
+    ConcurrentHashMap<int,int> a;
+    a.set_flat_storage(flat);
+    int n = 0;
+    for (int nentries=1000; nentries<=1000000; nentries*=10) {
+        for (; n<nentries; ++n) a.insert(datumT(n,n));
+        if (a.size() != size_t(nentries)) cout << "growth: size should have been " << nentries << " " << a.size() << endl;
+
+        vector<int> v = random_perm(nentries);
+        const int nfind = 1000000;
+        double used = madness::cpu_time();
+        for (int i=0; i<nfind; ++i) {
+            iteratorT it = a.find(v[i%nentries]);
+            if (it == a.end() || it->second != v[i%nentries]) cout << "growth: did not find " << v[i%nentries] << endl;
+        }
+        used = madness::cpu_time() - used;
+        printf("%s nbin=%8lu   nent=%8d   find=%.1es/call\n", flat ? "flat" : "list",
+               (unsigned long) a.bin_count(), nentries, used/nfind);
+    }
+
+    size_t count = 0;
+    for (iteratorT it=a.begin(); it!=a.end(); ++it) {
+        count++;
+        if (it->second != it->first) cout << "growth: key/value mismatch" << it->first << " " << it->second << endl;
+    }
+    if (count != a.size()) cout << "growth: count should have been " << a.size() << " " << count << endl;
+    split(Range<iteratorT>(a.begin(), a.end(), 1000));
+}
+
 madness::AtomicInt ndone;
 
 class Worker : public madness::ThreadBase {
@@ -300,8 +334,9 @@ public:
 
 
 
-void test_thread() {
+void test_thread(bool flat) {
     ConcurrentHashMap<int,double> a(131);
+    a.set_flat_storage(flat);
     //typedef ConcurrentHashMap<int,double>::datumT datumT; // unused
     typedef ConcurrentHashMap<int,double>::iterator iteratorT;
     // typedef ConcurrentHashMap<int,double>::const_iterator const_iteratorT; // unused
@@ -358,8 +393,87 @@ public:
 };
 
 
-void test_accessors() {
+class Grower : public madness::ThreadBase {
+private:
+    ConcurrentHashMap<int,double>& a; // Better would be a shared pointer
+    int first, last;
+
+public:
+    Grower(ConcurrentHashMap<int,double>& a, int first, int last)
+            : ThreadBase(), a(a), first(first), last(last) {
+        start();
+    }
+
+    void run() {
+        typedef ConcurrentHashMap<int,double>::datumT datumT;
+        for (int i=first; i<last; ++i) a.insert(datumT(i,i));
+
+        ndone++;
+    }
+};
+
+
+class Reader : public madness::ThreadBase {
+private:
+    ConcurrentHashMap<int,double>& a; // Better would be a shared pointer
+    int nkey;
+
+public:
+    Reader(ConcurrentHashMap<int,double>& a, int nkey)
+            : ThreadBase(), a(a), nkey(nkey) {
+        start();
+    }
+
+    void run() {
+        while (ndone < 2) {
+            for (int i=0; i<nkey; ++i) {
+                ConcurrentHashMap<int,double>::const_accessor r;
+                if (!a.find(r, -1-i)) MADNESS_EXCEPTION("key lost while the table grows", i);
+                if (r->second != i) MADNESS_EXCEPTION("value changed while the table grows", i);
+            }
+        }
+
+        ndone++;
+    }
+};
+
+
+void test_thread_growth() {
+    // Two threads insert into a small table, forcing it to grow many
+    // times, while another looks up keys that were inserted beforehand
+    typedef ConcurrentHashMap<int,double>::datumT datumT;
+    typedef ConcurrentHashMap<int,double>::iterator iteratorT;
+    ConcurrentHashMap<int,double> a(16);
+    const int nkey = 1000, nentries = 2000000;
+    for (int i=0; i<nkey; ++i) a.insert(datumT(-1-i,i));
+
+    ndone = 0;
+
+    Reader reader(a,nkey);
+    Grower grower1(a,0,nentries/2), grower2(a,nentries/2,nentries);
+    while (ndone != 3) sched_yield();
+
+    if (a.size() != size_t(nkey+nentries))
+        cout << "thread growth: size should have been " << nkey+nentries << " " << a.size() << endl;
+
+    size_t count = 0;
+    for (iteratorT it=a.begin(); it!=a.end(); ++it) {
+        count++;
+        if (it->first >= 0 && it->second != it->first) cout << "thread growth: key/value mismatch" << it->first << endl;
+    }
+    if (count != a.size()) cout << "thread growth: count should have been " << a.size() << " " << count << endl;
+    for (int i=0; i<nentries; ++i) {
+        if (a.find(i) == a.end()) {
+            cout << "thread growth: did not find " << i << endl;
+            break;
+        }
+    }
+}
+
+
+void test_accessors(bool flat) {
     ConcurrentHashMap<int,double> a(131);
+    a.set_flat_storage(flat);
     // typedef ConcurrentHashMap<int,double>::datumT datumT; // unused
     typedef ConcurrentHashMap<int,double>::accessor accessorT;
 
@@ -387,11 +501,17 @@ void test_accessors() {
 int main(int argc, char** argv) {
     madness::initialize(argc,argv);
     try {
-        test_coverage();
+        test_coverage(false);
+        test_coverage(true);
         test_random();
         test_time();
-        test_thread();
-        test_accessors();
+        test_thread(false);
+        test_thread(true);
+        test_growth(false);
+        test_growth(true);
+        test_thread_growth();
+        test_accessors(false);
+        test_accessors(true);
 
         cout << "Things seem to be working!\n";
     }
@@ -1074,18 +1074,44 @@ void test13(World& world) {
     world.gop.fence();
 
     fout.open(world,"fred",nio);
-    fout & d;
+    fout & d & 2.0 & d;
     fout.close();
 
-    WorldContainer<int,double> c(world);
+    // Serial objects between containers must not disturb the per-file positions
+    WorldContainer<int,double> c(world), c2(world);
+    double two = 0.0;
     fin.open(world,"fred");
-    fin & c;
+    fin & c & two & c2;
+    MADNESS_ASSERT(two == 2.0);
 
     for (int i=0; i<100; ++i) {
         int key = me*100+i;
         MADNESS_ASSERT(c.find(key).get()->second == key);
+        MADNESS_ASSERT(c2.find(key).get()->second == key);
     }
 
+    fin.close();
+    archive::ParallelOutputArchive::remove(world, "fred");
+    world.gop.fence();
+
+    // Asynchronous writes produce the same files, one per process
+    archive::AsyncParallelOutputArchive aout(world, "fred");
+    aout & 3.0 & d;
+    Future<bool> written = aout.close();
+    d.clear(); // The archive holds its own copy
+    const bool ok = written.get(); // Not inside MADNESS_ASSERT, which may be compiled out
+    MADNESS_ASSERT(ok);
+    world.gop.fence();
+
+    WorldContainer<int,double> c3(world);
+    double three = 0.0;
+    fin.open(world,"fred");
+    fin & three & c3;
+    MADNESS_ASSERT(three == 3.0);
+    for (int i=0; i<100; ++i) {
+        int key = me*100+i;
+        MADNESS_ASSERT(c3.find(key).get()->second == key);
+    }
     fin.close();
     archive::ParallelOutputArchive::remove(world, "fred");
 
@@ -1093,6 +1119,54 @@ void test13(World& world) {
     world.gop.fence();
 }
 
+static int bench_task(int i) {
+    return i;
+}
+
+static int bench_sum(int a, int b) {
+    return a + b;
+}
+
+void test_task_rate(World& world) {
+    PROFILE_FUNC;
+    // Microbenchmark of the allocation-heavy paths of the runtime: every
+    // task allocates a task object and the future of its result, and the
+    // tree algorithms in mra create 2^NDIM futures per node
+    const int ntask = 100000;
+
+    world.gop.fence();
+    double start = wall_time();
+    for (int i=0; i<ntask; ++i) world.taskq.add(bench_task, i);
+    world.gop.fence();
+    const double task_time = wall_time() - start;
+
+    start = wall_time();
+    long sum = 0;
+    for (int i=0; i<ntask; ++i) {
+        Future<int> f;
+        f.set(i);
+        sum += f.get();
+    }
+    const double future_time = wall_time() - start;
+    MADNESS_ASSERT(sum == long(ntask)*(ntask-1)/2);
+
+    // Pairs of tasks combined by a dependent task, as in compress_spawn
+    start = wall_time();
+    std::vector< Future<int> > results;
+    results.reserve(ntask/2);
+    for (int i=0; i<ntask/2; ++i)
+        results.push_back(world.taskq.add(bench_sum, world.taskq.add(bench_task, i), Future<int>(i)));
+    world.gop.fence();
+    const double spawn_time = wall_time() - start;
+    for (int i=0; i<ntask/2; ++i) MADNESS_ASSERT(results[i].get() == 2*i);
+
+    if (world.rank() == 0) {
+        print("test_task_rate: tasks/s  ", long(ntask/task_time));
+        print("                futures/s", long(ntask/future_time));
+        print("                dependent task pairs/s", long(ntask/2/spawn_time));
+    }
+}
+
 inline bool is_odd(int i) {
     return i & 0x1;
 }
@@ -1242,6 +1316,7 @@ int main(int argc, char** argv) {
         //test11(world);
         test12(world);
         test13(world);
+        test_task_rate(world);
 
         for (int i=0; i<10; ++i) {
           print("REPETITION",i);
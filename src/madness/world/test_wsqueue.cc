@@ -0,0 +1,87 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#include <madness/world/wsqueue.h>
+#include <madness/world/atomicint.h>
+#include <iostream>
+#include <vector>
+#include <pthread.h>
+
+using namespace madness;
+
+const long NITEM = 2000000;
+const int NTHIEF = 3;
+
+WSQueue<long> q(16); // Small so that it must grow while being stolen from
+std::vector<unsigned char> seen(NITEM+1, 0);
+volatile bool owner_done = false;
+AtomicInt nerror;
+
+void take(long item) {
+    if (item < 1 || item > NITEM || seen[item]++) nerror++;
+}
+
+void* thief(void*) {
+    long item;
+    while (!owner_done || !q.empty()) {
+        if (q.steal(item)) take(item);
+    }
+    return 0;
+}
+
+int main() {
+    nerror = 0;
+
+    pthread_t threads[NTHIEF];
+    for (int i=0; i<NTHIEF; ++i) pthread_create(threads+i, nullptr, thief, nullptr);
+
+    // The owner pushes in bursts and pops some of its own work
+    long item;
+    for (long i=1; i<=NITEM; ++i) {
+        q.push(i);
+        if ((i % 3) == 0 && q.pop(item)) take(item);
+    }
+    while (q.pop(item)) take(item);
+    owner_done = true;
+
+    for (int i=0; i<NTHIEF; ++i) pthread_join(threads[i], nullptr);
+
+    long nseen = 0;
+    for (long i=1; i<=NITEM; ++i) nseen += seen[i];
+
+    std::cout << "items " << NITEM << " seen " << nseen << " errors " << int(nerror) << std::endl;
+    if (nseen != NITEM || nerror != 0) {
+        std::cout << "FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -36,6 +36,7 @@
 */
 
 #include <madness/world/thread.h>
+#include <madness/world/numa.h>
 #include <madness/world/worldprofile.h>
 #include <madness/world/madness_exception.h>
 #include <madness/world/print.h>
@@ -262,6 +263,25 @@ namespace madness {
 #endif
     }
 
+    void ThreadBase::set_numa_affinity(int node) {
+        if (node < 0 || node >= NumaTopology::num_nodes()) {
+            std::cout << "ThreadBase: set_numa_affinity: node bad?" << std::endl;
+            return;
+        }
+        numa_node = node;
+
+#ifndef ON_A_MAC
+        const std::vector<int>& cpus = NumaTopology::cpus(node);
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (std::size_t i=0; i<cpus.size(); ++i) CPU_SET(cpus[i],&mask);
+        if (sched_setaffinity(0, sizeof(mask), &mask) == -1) {
+            perror("system error message");
+            std::cout << "ThreadBase: set_numa_affinity: Could not set cpu affinity" << std::endl;
+        }
+#endif
+    }
+
 #if defined(HAVE_IBMBGQ) and defined(HPM)
   void ThreadBase::set_hpm_thread_env(int hpm_thread_id) {
     if (hpm_thread_id == ThreadBase::hpm_thread_id_all) {
@@ -337,8 +357,9 @@ namespace madness {
   dague_context_t *ThreadPool::parsec = NULL;
 #endif
     // The constructor is private to enforce the singleton model
-    ThreadPool::ThreadPool(int nthread) :
-            threads(nullptr), main_thread(), nthreads(nthread), finish(false)
+    ThreadPool::ThreadPool(int nthread, bool work_stealing) :
+            threads(nullptr), main_thread(), nthreads(nthread), finish(false),
+            work_stealing(work_stealing), nsleeping(0)
     {
         nfinished = 0;
         instance_ptr = this;
@@ -438,7 +459,14 @@ namespace madness {
 
     void ThreadPool::thread_main(ThreadPoolThread* const thread) {
         PROFILE_MEMBER_FUNC(ThreadPool);
-        thread->set_affinity(2, thread->get_pool_thread_index());
+        if (NumaTopology::enabled()) {
+            // Contiguous blocks of pool threads share a node
+            const int nnode = NumaTopology::num_nodes();
+            thread->set_numa_affinity((thread->get_pool_thread_index()*nnode)/nthreads);
+        }
+        else {
+            thread->set_affinity(2, thread->get_pool_thread_index());
+        }
 
 #if !HAVE_PARSEC
 #define MULTITASK
@@ -460,6 +488,92 @@ namespace madness {
         nfinished++;
     }
 
+    bool ThreadPool::run_tasks_ws(bool wait, ThreadPoolThread* const this_thread) {
+        PoolTaskInterface* taskbuf[nmax];
+        PoolTaskInterface* task = nullptr;
+        const bool pool_thread = this_thread && (this_thread->get_pool_thread_index() >= 0);
+        MutexWaiter waiter;
+        const int nspin = 1000; // Failed attempts before sleeping
+
+        for (int attempt=0; ; ++attempt) {
+            // Shared queue first to keep high-priority and multi-threaded tasks
+            // ahead of everything else. Don't take the lock if it looks empty.
+            int ntask = 0;
+            if (! queue.empty())
+                ntask = queue.pop_front(nmax, taskbuf, false);
+
+            // Local deque next (LIFO), then steal
+            if (ntask == 0) {
+                if ((pool_thread && this_thread->tasks().pop(task)) || steal(task, this_thread)) {
+                    taskbuf[0] = task;
+                    ntask = 1;
+                }
+            }
+
+            if (ntask == 0 && wait && !finish) {
+                if (attempt < nspin) {
+                    waiter.wait();
+                    continue;
+                }
+
+                // Sleep on the shared queue. Re-check the deques after announcing
+                // ourselves so a push racing with us is not missed.
+                nsleeping++;
+                if ((pool_thread && this_thread->tasks().pop(task)) || steal(task, this_thread)) {
+                    taskbuf[0] = task;
+                    ntask = 1;
+                }
+                else {
+                    ntask = queue.pop_front(nmax, taskbuf, true);
+                }
+                nsleeping--;
+                attempt = 0;
+                waiter.reset();
+            }
+
+#ifdef MADNESS_TASK_PROFILING
+            profiling::TaskEventList* event_list =
+                    (ntask ? this_thread->profiler().new_list(ntask) : nullptr);
+#endif // MADNESS_TASK_PROFILING
+            bool ran = false;
+            for (int i=0; i<ntask; ++i) {
+                if (taskbuf[i]) { // Null tasks are used to wake sleeping threads
+#ifdef MADNESS_TASK_PROFILING
+                    taskbuf[i]->set_event(event_list->event());
+#endif // MADNESS_TASK_PROFILING
+                    if (taskbuf[i]->run_multi_threaded())
+                        delete taskbuf[i];
+                    ran = true;
+                }
+            }
+
+            if (ran || !wait || finish) return ran;
+        }
+    }
+
+    bool ThreadPool::steal(PoolTaskInterface*& task, ThreadPoolThread* const this_thread) {
+        if (nthreads == 0) return false;
+        const int me = (this_thread ? this_thread->get_pool_thread_index() : -1);
+        const int node = (this_thread ? this_thread->get_numa_node() : -1);
+        const int start = (this_thread ? this_thread->random(nthreads) : 0);
+
+        // Prefer victims on our own NUMA node, whose data is local to us
+        if (node >= 0) {
+            for (int i=0, victim=start; i<nthreads; ++i, victim=(victim+1)%nthreads) {
+                if (victim != me && threads[victim].get_numa_node() == node &&
+                        threads[victim].tasks().steal(task))
+                    return true;
+            }
+        }
+
+        for (int i=0, victim=start; i<nthreads; ++i, victim=(victim+1)%nthreads) {
+            if (victim != me && (node < 0 || threads[victim].get_numa_node() != node) &&
+                    threads[victim].tasks().steal(task))
+                return true;
+        }
+        return false;
+    }
+
     // Forwards thread to bound member function
     void* ThreadPool::pool_thread_main(void *v) {
         instance()->thread_main((ThreadPoolThread*)(v));
@@ -467,13 +581,25 @@ namespace madness {
     }
 
     void ThreadPool::begin(int nthread) {
+        bool work_stealing = false;
+        const char* mad_work_stealing = getenv("MAD_WORK_STEALING");
+        if (mad_work_stealing) {
+            int flag = 0;
+            std::stringstream ss(mad_work_stealing);
+            ss >> flag;
+            work_stealing = (flag != 0);
+        }
+        begin(nthread, work_stealing);
+    }
+
+    void ThreadPool::begin(int nthread, bool work_stealing) {
         // Check that the singleton has not been previously initialized
         if(instance_ptr) return;
 
         ThreadBase::init_thread_key();
 
         // Construct the thread pool singleton
-        instance_ptr = new ThreadPool(nthread);
+        instance_ptr = new ThreadPool(nthread, work_stealing);
 
         const char* mad_wait_timeout = getenv("MAD_WAIT_TIMEOUT");
         if(mad_wait_timeout) {
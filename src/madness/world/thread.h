@@ -39,7 +39,10 @@
 */
 
 #include <madness/world/dqueue.h>
+#include <madness/world/wsqueue.h>
 #include <madness/world/function_traits.h>
+#include <madness/world/worldtrace.h>
+#include <madness/world/memory_pool.h>
 #include <vector>
 #include <cstddef>
 #include <cstdio>
@@ -117,6 +120,7 @@ namespace madness {
         static void* main(void* self);
 
         int pool_num; ///< Stores index of thread in pool or -1.
+        int numa_node; ///< NUMA node this thread is bound to or -1.
         pthread_t id; ///< \todo Brief description needed.
 
         /// \todo Brief description needed.
@@ -153,7 +157,7 @@ namespace madness {
 
         /// Sets up the thread; however, \c start() must be invoked to
         /// actually begin the thread.
-        ThreadBase() : pool_num(-1) { }
+        ThreadBase() : pool_num(-1), numa_node(-1) { }
 
         virtual ~ThreadBase() { }
 
@@ -207,6 +211,28 @@ namespace madness {
         /// \param[in] ind Description needed.
         static void set_affinity(int logical_id, int ind=-1);
 
+        /// Bind the calling thread to all CPUs of a NUMA node.
+
+        /// The node is recorded so that stealing and memory placement can
+        /// prefer it. Must be called by the thread itself.
+        /// \param[in] node The NUMA node (see \c NumaTopology).
+        void set_numa_affinity(int node);
+
+        /// Get the NUMA node this thread is bound to.
+
+        /// \return The node, or -1 if the thread is not bound to one.
+        int get_numa_node() const {
+            return numa_node;
+        }
+
+        /// Get the NUMA node of the calling thread.
+
+        /// \return The node, or -1 if the thread is not bound to one.
+        static int this_numa_node() {
+            const ThreadBase* const thread = this_thread();
+            return thread ? thread->numa_node : -1;
+        }
+
         /// \todo Brief description needed.
 
         /// \todo Descriptions needed.
@@ -824,6 +850,7 @@ namespace madness {
             public TaskAttributes
     {
         friend class ThreadPool;
+        friend class WorldTrace;
 
     private:
 
@@ -916,6 +943,7 @@ namespace madness {
             // A downside is this does not preserve any relationships between thread
             // numbering and the architecture ... more work ahead.
             int nthread = get_nthread();
+            const double trace_start = WorldTrace::enabled() ? wall_time() : 0.0;
             if (nthread == 1) {
 #ifdef MADNESS_TASK_PROFILING
                 task_event_->start(id_, nthread, submit_time_);
@@ -924,6 +952,7 @@ namespace madness {
 #ifdef MADNESS_TASK_PROFILING
                 task_event_->stop();
 #endif // MADNESS_TASK_PROFILING
+                if (trace_start) WorldTrace::task_run(this, trace_start, 1);
                 return true;
             }
             else {
@@ -937,6 +966,7 @@ namespace madness {
 #endif // MADNESS_TASK_PROFILING
 
                 run(TaskThreadEnv(nthread, id, barrier));
+                if (trace_start && id == 0) WorldTrace::task_run(this, trace_start, nthread);
 
 #ifdef MADNESS_TASK_PROFILING
                 const bool cleanup = barrier->enter(id);
@@ -980,6 +1010,24 @@ namespace madness {
             delete barrier;
         }
 
+        /// Allocate a task object from the \c SlabAllocator.
+
+        /// Task objects are recycled through per-thread free lists instead
+        /// of \c malloc, even when they are freed by another thread.
+        /// \param[in] size The size of the task object.
+        /// \return The memory for the task object.
+        static void* operator new(std::size_t size) {
+            return SlabAllocator::allocate(size);
+        }
+
+        /// Return the memory of a task object to the \c SlabAllocator.
+
+        /// \param[in] p The memory of the task object.
+        /// \param[in] size The size of the (most derived) task object.
+        static void operator delete(void* p, std::size_t size) {
+            SlabAllocator::deallocate(p, size);
+        }
+
         /// Call this to reset the number of threads before the task is submitted.
 
         /// Once a task has been constructed, /c TaskAttributes::set_nthread()
@@ -1125,11 +1173,36 @@ namespace madness {
 #ifdef MADNESS_TASK_PROFILING
         profiling::TaskProfiler profiler_; ///< \todo Description needed.
 #endif // MADNESS_TASK_PROFILING
+        WSQueue<PoolTaskInterface*> tasks_; ///< Local deque used in work-stealing mode.
+        unsigned int seed_; ///< State of the random number generator used to pick victims.
 
     public:
-        ThreadPoolThread() : Thread() { }
+        ThreadPoolThread() : Thread(), tasks_(), seed_(0) { }
         virtual ~ThreadPoolThread() = default;
 
+        /// Local task deque accessor.
+
+        /// Only the owning thread may push or pop; other threads may steal.
+        /// \return The task deque of this thread.
+        WSQueue<PoolTaskInterface*>& tasks() {
+            return tasks_;
+        }
+
+        /// Pick a random integer in `[0,n)`, e.g.\ a victim for stealing.
+
+        /// Uses a per-thread xorshift generator so no state is shared.
+        /// \param[in] n The upper bound (exclusive).
+        /// \return A random integer in `[0,n)`.
+        int random(int n) {
+            unsigned int x = seed_;
+            if (x == 0) x = 2463534242u + 97u*(get_pool_thread_index() + 2);
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            seed_ = x;
+            return int(x % (unsigned int)(n));
+        }
+
 #ifdef MADNESS_TASK_PROFILING
         /// Task profiler accessor.
 
@@ -1156,6 +1229,8 @@ namespace madness {
         int nthreads; ///< Number of threads.
         volatile bool finish; ///< Set to true when time to stop.
         AtomicInt nfinished; ///< Thread pool exit counter.
+        bool work_stealing; ///< True if pool threads schedule from their own deques.
+        std::atomic<int> nsleeping; ///< Number of work-stealing threads blocked on \c queue.
 
         // Static data
         static ThreadPool* instance_ptr; ///< Singleton pointer.
@@ -1169,7 +1244,8 @@ namespace madness {
 
         /// \todo Description needed.
         /// \param[in] nthread Description needed.
-        ThreadPool(int nthread=-1);
+        /// \param[in] work_stealing Use per-thread deques with stealing.
+        ThreadPool(int nthread=-1, bool work_stealing=false);
 
         /// \todo Could we use C++11's `= delete` to hide this?
         ThreadPool(const ThreadPool&);           // Verboten
@@ -1231,6 +1307,8 @@ namespace madness {
             MADNESS_EXCEPTION("run_tasks should not be called when using Intel TBB", 1);
 #else
 
+            if (work_stealing) return run_tasks_ws(wait, this_thread);
+
             PoolTaskInterface* taskbuf[nmax];
             int ntask = queue.pop_front(nmax, taskbuf, wait);
 #ifdef MADNESS_TASK_PROFILING
@@ -1251,6 +1329,27 @@ namespace madness {
 #endif
         }
 
+        /// Run tasks in work-stealing mode.
+
+        /// Tasks in the shared queue (high-priority and multi-threaded tasks,
+        /// and those submitted from outside the pool) are run first so that
+        /// their semantics are unchanged. Otherwise the most recently pushed
+        /// task of the local deque is run or, failing that, one stolen from
+        /// a randomly chosen victim. If \c wait is true and there is no work
+        /// anywhere the thread backs off and eventually sleeps on the shared
+        /// queue until a task arrives there or it is woken by \c add().
+        /// \param[in] wait Block until a task was run or the pool finishes.
+        /// \param[in,out] this_thread The calling thread.
+        /// \return True if a task was run.
+        bool run_tasks_ws(bool wait, ThreadPoolThread* const this_thread);
+
+        /// Steal a task from a random pool thread.
+
+        /// \param[out] task The stolen task.
+        /// \param[in,out] this_thread The calling thread (used to pick the victim).
+        /// \return True if a task was stolen.
+        bool steal(PoolTaskInterface*& task, ThreadPoolThread* const this_thread);
+
         /// \todo Brief description needed.
 
         /// \todo Description needed.
@@ -1292,10 +1391,30 @@ namespace madness {
 
         /// Please invoke while in a single-threaded environment.
 
-        /// \todo Verify documentation.
+        /// The scheduler is selected with the environment variable
+        /// `MAD_WORK_STEALING` (see the two-argument version); by default
+        /// all threads share a single task queue.
         /// \param[in] nthread The number of threads.
         static void begin(int nthread=-1);
 
+        /// Please invoke while in a single-threaded environment.
+
+        /// If \c work_stealing is true, each pool thread owns a lock-free
+        /// deque. Tasks submitted from inside a pool thread are pushed onto
+        /// its deque and run LIFO, while idle threads steal from random
+        /// victims. High-priority and multi-threaded tasks, and those
+        /// submitted by other threads, still go through the shared queue.
+        /// \param[in] nthread The number of threads.
+        /// \param[in] work_stealing Use per-thread deques with stealing.
+        static void begin(int nthread, bool work_stealing);
+
+        /// Test if the pool is running in work-stealing mode.
+
+        /// \return True if pool threads schedule from their own deques.
+        static bool is_work_stealing() {
+            return instance()->work_stealing;
+        }
+
         /// \todo Description needed.
         static void end();
 
@@ -1308,6 +1427,7 @@ namespace madness {
 #ifdef MADNESS_TASK_PROFILING
             task->submit();
 #endif // MADNESS_TASK_PROFILING
+            if (WorldTrace::enabled() && task) WorldTrace::task_submit(task);
 
             //////////// Parsec Related Begin ////////////////////
             /* Initialize the execution context and give it to the scheduler*/
@@ -1326,13 +1446,25 @@ namespace madness {
 #else
             if (!task) MADNESS_EXCEPTION("ThreadPool: inserting a NULL task pointer", 1);
             int task_threads = task->get_nthread();
+            ThreadPool* const pool = instance();
+            if (pool->work_stealing && !task->is_high_priority() && (task_threads == 1)) {
+                // Tasks spawned by a pool thread go onto its own deque
+                ThreadBase* const thread = ThreadBase::this_thread();
+                if (thread && (thread->get_pool_thread_index() >= 0)) {
+                    static_cast<ThreadPoolThread*>(thread)->tasks().push(task);
+                    // A null task wakes a sleeping thread so it can steal
+                    if (pool->nsleeping.load(std::memory_order_relaxed) > 0)
+                        pool->queue.push_back(nullptr);
+                    return;
+                }
+            }
             // Currently multithreaded tasks must be shoved on the end of the q
             // to avoid a race condition as multithreaded task is starting up
             if (task->is_high_priority() && (task_threads == 1)) {
-                instance()->queue.push_front(task);
+                pool->queue.push_front(task);
             }
             else {
-                instance()->queue.push_back(task, task_threads);
+                pool->queue.push_back(task, task_threads);
             }
 #endif // HAVE_INTEL_TBB
         }
@@ -1383,13 +1515,16 @@ namespace madness {
             return false;
 #else
 
+            ThreadPool* const pool = instance();
 #ifdef MADNESS_TASK_PROFILING
             ThreadPoolThread* const thread = static_cast<ThreadPoolThread*>(ThreadBase::this_thread());
 #else
-            ThreadPoolThread* const thread = nullptr;
+            // The work-stealing scheduler needs the caller to find its deque
+            ThreadPoolThread* const thread = (pool->work_stealing ?
+                    static_cast<ThreadPoolThread*>(ThreadBase::this_thread()) : nullptr);
 #endif // MADNESS_TASK_PROFILING
 
-            return instance()->run_tasks(false, thread);
+            return pool->run_tasks(false, thread);
 #endif // HAVE_INTEL_TBB
         }
 
@@ -1402,13 +1537,22 @@ namespace madness {
 
         /// Returns the number of tasks in the queue.
 
+        /// In work-stealing mode this includes the tasks in the thread
+        /// deques and is only approximate while the pool is busy.
         /// \return The number of tasks in the queue.
         static std::size_t queue_size() {
-            return instance()->queue.size();
+            ThreadPool* const pool = instance();
+            std::size_t n = pool->queue.size();
+            if (pool->work_stealing) {
+                for (int i=0; i<pool->nthreads; ++i)
+                    n += pool->threads[i].tasks().size();
+            }
+            return n;
         }
 
         /// Returns queue statistics.
 
+        /// In work-stealing mode these only cover the shared queue.
         /// \return Queue statistics.
         static const DQStats& get_stats();
 
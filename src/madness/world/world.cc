@@ -41,6 +41,9 @@
 #include <madness/world/worldam.h>
 #include <madness/world/world_task_queue.h>
 #include <madness/world/worldgop.h>
+#include <madness/world/numa.h>
+#include <madness/world/memory_pool.h>
+#include <madness/world/worldtrace.h>
 #include <cstdlib>
 #include <sstream>
 
@@ -112,6 +115,10 @@ namespace madness {
     }
 
 
+    void World::flush_coalesced_am() {
+        AmCoalescer::flush_all_pending();
+    }
+
     void World::args(int argc, char** argv) {
         for (int arg=1; arg<argc; ++arg) {
             if (strcmp(argv[arg],"-dx")==0) xterm_debug("objtest", 0);
@@ -168,6 +175,14 @@ namespace madness {
         }
 
         ThreadBase::set_affinity_pattern(bind, cpulo); // Decide how to locate threads before doing anything
+
+        // NUMA placement replaces the binding of pool threads given by MAD_BIND
+        const char* snuma = getenv("MAD_NUMA");
+        if (snuma && atoi(snuma) != 0) NumaTopology::enable();
+
+        // Thread-caching pool for tensor data
+        const char* spool = getenv("MAD_TENSOR_POOL");
+        if (spool && atoi(spool) != 0) MemoryPool::enable();
         ThreadBase::set_affinity(0);         // The main thread is logical thread 0
 
 #if defined(HAVE_IBMBGQ) and defined(HPM)
@@ -193,10 +208,12 @@ namespace madness {
         ThreadPool::begin();        // Must have thread pool before any AM arrives
         if(SafeMPI::COMM_WORLD.Get_size() > 1) {
             RMI::begin();           // Must have RMI while still running single threaded
+            AmCoalescer::begin();
             // N.B. sync everyone up before messages start flying
             // this is needed to avoid hangs with some MPIs, e.g. Intel MPI on commodity hardware
             comm.Barrier();
         }
+        WorldTrace::begin();
 
 #ifdef HAVE_PAPI
         begin_papi_measurement();
@@ -212,7 +229,11 @@ namespace madness {
         madness_initialized_ = true;
         if(SafeMPI::COMM_WORLD.Get_rank() == 0)
             std::cout << "MADNESS runtime initialized with " << ThreadPool::size()
-                << " threads in the pool and affinity " << sbind << "\n";
+                << " threads in the pool and affinity " << sbind
+                << (ThreadPool::is_work_stealing() ? " (work stealing)" : "");
+            if (NumaTopology::enabled())
+                std::cout << " on " << NumaTopology::num_nodes() << " NUMA nodes";
+            std::cout << "\n";
 
         return * World::default_world;
     }
@@ -224,12 +245,16 @@ namespace madness {
         delete World::default_world;
         World::default_world = nullptr;
 
+        WorldTrace::end();
+
 #ifdef MADNESS_HAS_ELEMENTAL
         elem::Finalize();
 #endif
 
-        if(SafeMPI::COMM_WORLD.Get_size() > 1)
+        if(SafeMPI::COMM_WORLD.Get_size() > 1) {
             RMI::end();
+            AmCoalescer::end();
+        }
         ThreadPool::end();
         detail::WorldMpi::finalize();
         madness_initialized_ = false;
@@ -282,6 +307,12 @@ namespace madness {
         world.gop.min(min_nbyte_recv);
         world.gop.min(min_server_q);
 
+        const AmCoalescer* coalescer = AmCoalescer::instance();
+        double nmsg_coalesced = coalescer ? coalescer->get_nmsg() : 0;
+        double nbatch_coalesced = coalescer ? coalescer->get_nbatch() : 0;
+        world.gop.sum(nmsg_coalesced);
+        world.gop.sum(nbatch_coalesced);
+
         double npush_back = q.npush_back;
         double npush_front = q.npush_front;
         double npop_front = q.npop_front;
@@ -354,6 +385,10 @@ namespace madness {
                    min_nbyte_recv, nbyte_recv/world.size(), max_nbyte_recv);
             printf("        #msgs systemwide    %.2e\n", nmsg_sent);
             printf("       #bytes systemwide    %.2e\n", nbyte_sent);
+            if (coalescer) {
+                printf("   #AM coalesced systemwide %.2e in %.2e batches\n",
+                       nmsg_coalesced, nbatch_coalesced);
+            }
             printf("\n");
             printf("  Thread pool statistics (min / avg / max)\n");
             printf("  ----------------------\n");
@@ -384,6 +419,8 @@ namespace madness {
 #ifdef WORLD_GATHER_MEM_STATS
             world_mem_info()->print();
 #endif
+            if (MemoryPool::enabled())
+                world_mem_info()->print_pool();
 
             printf("         Total wall time    %.1fs\n", total_wall_time);
             printf("         Total  cpu time    %.1fs\n", total_cpu_time);
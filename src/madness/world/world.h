@@ -500,9 +500,16 @@ namespace madness {
 	/// \param sleep Sleep instead of spin while waiting - default is false
         template <typename Probe>
 	  static void inline await(const Probe& probe, bool dowork = true, bool sleep=false) {
+            flush_coalesced_am();
             ThreadPool::await(probe, dowork);
         }
 
+        /// Sends any active messages held back for coalescing.
+
+        /// Called before blocking since what we wait for may depend on
+        /// them (see \c AmCoalescer).
+        static void flush_coalesced_am();
+
         /// Crude seed function for random number generation.
 
         /// \param[in] seed The seed.
@@ -32,7 +32,9 @@
 #include <madness/world/worldam.h>
 #include <madness/world/MADworld.h>
 #include <madness/world/worldmpi.h>
+#include <madness/world/timers.h>
 #include <sstream>
+#include <algorithm>
 
 namespace madness {
 
@@ -89,4 +91,153 @@ namespace madness {
         // otherwise the send buffers are freed when the WorldAMInterface::send_req is freed
     }
 
+    AmCoalescer* AmCoalescer::instance_ptr = nullptr;
+
+    AmCoalescer::AmCoalescer(std::size_t batch_size, double latency_us)
+            : nproc(SafeMPI::COMM_WORLD.Get_size())
+            , max_batch(std::min(batch_size, RMI::max_msg_len()))
+            , max_item(max_batch/4)
+            , latency(latency_us*1e-6)
+            , buckets(new Bucket[nproc])
+            , nmsg(0)
+            , nbatch(0)
+    {
+        npending = 0;
+    }
+
+    void AmCoalescer::begin() {
+        MADNESS_ASSERT(instance_ptr == nullptr);
+        const char* mad_coalesce = getenv("MAD_AM_COALESCE");
+        if (!mad_coalesce) return;
+
+        long batch_size = 0;
+        std::stringstream ss(mad_coalesce);
+        ss >> batch_size;
+        if (batch_size <= 0) return;
+        if (batch_size < 1024) {
+            batch_size = 1024;
+            std::cerr << "!!! WARNING: MAD_AM_COALESCE must be at least 1024.\n"
+                      << "!!! WARNING: Increasing MAD_AM_COALESCE to " << batch_size << ".\n";
+        }
+
+        double latency_us = 100.0;
+        const char* mad_coalesce_us = getenv("MAD_AM_COALESCE_US");
+        if (mad_coalesce_us) {
+            std::stringstream ssus(mad_coalesce_us);
+            ssus >> latency_us;
+            if (latency_us < 0.0) latency_us = 0.0;
+        }
+
+        instance_ptr = new AmCoalescer(batch_size, latency_us);
+        RMI::set_idle_hook(&AmCoalescer::flush_stale);
+    }
+
+    void AmCoalescer::end() {
+        if (!instance_ptr) return;
+        RMI::set_idle_hook(nullptr);
+        for (int p=0; p<instance_ptr->nproc; ++p)
+            MADNESS_ASSERT(instance_ptr->buckets[p].buf == 0);
+        while (true) {
+            instance_ptr->free_sent();
+            ScopedMutex<Mutex> guard(instance_ptr->inflight_mutex);
+            if (instance_ptr->inflight.empty()) break;
+        }
+        delete instance_ptr;
+        instance_ptr = nullptr;
+    }
+
+    bool AmCoalescer::append(ProcessID dest, const AmArg* arg) {
+        const std::size_t n = padded_size(arg);
+        if (n > max_item) return false;
+
+        Bucket& b = buckets[dest];
+        b.lock();
+        if (b.buf && (b.used + n > max_batch)) send_batch(dest, b);
+        if (!b.buf) {
+            b.buf = alloc_am_arg(max_batch - sizeof(AmArg));
+            b.used = sizeof(AmArg);
+            b.start = wall_time();
+            npending++;
+        }
+        memcpy(reinterpret_cast<unsigned char*>(b.buf) + b.used, arg, arg->size() + sizeof(AmArg));
+        b.used += n;
+        b.unlock();
+
+        ++nmsg;
+        free_am_arg(const_cast<AmArg*>(arg));
+        return true;
+    }
+
+    void AmCoalescer::send_batch(ProcessID dest, Bucket& b) {
+        AmArg* batch = b.buf;
+        const std::size_t nbyte = b.used;
+        batch->set_size(nbyte - sizeof(AmArg));
+        b.buf = 0;
+        b.used = 0;
+        npending--;
+
+        // Still holding the bucket lock so that batches (and the
+        // uncoalesced messages that follow them) leave in order
+        RMI::Request req = RMI::isend(batch, nbyte, dest, batch_handler, RMI::ATTR_ORDERED);
+        ++nbatch;
+        {
+            ScopedMutex<Mutex> guard(inflight_mutex);
+            inflight.push_back(std::make_pair(batch, req));
+        }
+        free_sent();
+    }
+
+    void AmCoalescer::free_sent() {
+        ScopedMutex<Mutex> guard(inflight_mutex);
+        auto it = inflight.begin();
+        while (it != inflight.end()) {
+            if (it->second.Test()) {
+                free_am_arg(it->first);
+                it = inflight.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    void AmCoalescer::flush(ProcessID dest) {
+        Bucket& b = buckets[dest];
+        if (!b.buf) return;
+        b.lock();
+        if (b.buf) send_batch(dest, b);
+        b.unlock();
+    }
+
+    void AmCoalescer::flush_all() {
+        if (npending == 0) return;
+        for (ProcessID p=0; p<nproc; ++p) flush(p);
+    }
+
+    void AmCoalescer::flush_stale() {
+        AmCoalescer* c = instance_ptr;
+        if (!c) return;
+        if (c->npending == 0) return;
+        // The server must not wait on a bucket that a sender holds
+        const double now = wall_time();
+        for (ProcessID p=0; p<c->nproc; ++p) {
+            Bucket& b = c->buckets[p];
+            if (b.buf && (now - b.start) >= c->latency && b.try_lock()) {
+                if (b.buf) c->send_batch(p, b);
+                b.unlock();
+            }
+        }
+    }
+
+    void AmCoalescer::batch_handler(void* buf, std::size_t nbyte) {
+        unsigned char* p = static_cast<unsigned char*>(buf) + sizeof(AmArg);
+        unsigned char* const end = static_cast<unsigned char*>(buf) + nbyte;
+        while (p < end) {
+            AmArg* arg = reinterpret_cast<AmArg*>(p);
+            WorldAmInterface::handler(arg, arg->size() + sizeof(AmArg));
+            p += padded_size(arg);
+        }
+        MADNESS_ASSERT(p == end);
+    }
+
 } // namespace madness
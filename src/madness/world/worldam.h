@@ -41,6 +41,10 @@
 #include <vector>
 #include <cstddef>
 #include <memory>
+#include <list>
+#include <atomic>
+#include <cstdint>
+#include <utility>
 #include <pthread.h>
 
 namespace madness {
@@ -81,6 +85,7 @@ namespace madness {
     private:
         friend class WorldAmInterface;
         template <class Derived> friend class WorldObject;
+        friend class AmCoalescer;
 
         friend AmArg* alloc_am_arg(std::size_t nbyte);
 
@@ -203,10 +208,111 @@ namespace madness {
     }
 
 
+    /// Coalesces small outgoing active messages into one RMI message per destination
+
+    /// Enabled by setting the environment variable \c MAD_AM_COALESCE to
+    /// the batch size in bytes.  An active message that is small compared
+    /// to the batch is copied into the batch of its destination (rank in
+    /// COMM_WORLD) instead of being sent on its own.  The batch is a single
+    /// ordered RMI message whose payload is the concatenation of the queued
+    /// messages (each AmArg header plus payload, padded to a multiple of
+    /// sizeof(AmArg)); the receiving server thread unpacks it and invokes the
+    /// handlers in order.
+    ///
+    /// A batch is sent when it is full, before an uncoalesced message to the
+    /// same destination (so ordering is preserved), from
+    /// WorldAmInterface::fence() and World::await() (so the termination
+    /// detection of gop.fence() and waiting futures make progress), and by
+    /// the RMI server thread once its oldest message is older than
+    /// \c MAD_AM_COALESCE_US microseconds.
+    ///
+    /// There is one instance per process shared by all worlds.  It is
+    /// created by initialize() and destroyed by finalize().
+    class AmCoalescer {
+        /// The batch being filled for one destination
+        struct Bucket : public Spinlock {
+            AmArg* buf;         ///< Batch (first element is the batch header) or null
+            std::size_t used;   ///< Bytes used in buf, including the batch header
+            double start;       ///< Wall time at which the first message was queued
+            Bucket() : buf(0), used(0), start(0.0) {}
+        };
+
+        static AmCoalescer* instance_ptr;
+
+        const int nproc;                      ///< Size of COMM_WORLD
+        std::size_t max_batch;                ///< Size of a batch in bytes including its header
+        std::size_t max_item;                 ///< Largest padded message that is coalesced
+        double latency;                       ///< Max time a message may wait (seconds)
+        std::unique_ptr<Bucket[]> buckets;    ///< Indexed by rank in COMM_WORLD
+        AtomicInt npending;                   ///< No. of nonempty buckets
+        Mutex inflight_mutex;                 ///< Protects inflight
+        std::list< std::pair<AmArg*, RMI::Request> > inflight; ///< Batches being sent
+        std::atomic<std::uint64_t> nmsg;      ///< No. of messages coalesced
+        std::atomic<std::uint64_t> nbatch;    ///< No. of batches sent
+
+        AmCoalescer(std::size_t batch_size, double latency_us);
+
+        AmCoalescer(const AmCoalescer&) = delete;
+        AmCoalescer& operator=(const AmCoalescer&) = delete;
+
+        /// Padded size of a message inside a batch
+        static std::size_t padded_size(const AmArg* arg) {
+            return sizeof(AmArg)*((arg->size() + 2*sizeof(AmArg) - 1)/sizeof(AmArg));
+        }
+
+        /// Sends the batch of \c dest ... the bucket must be locked and nonempty
+        void send_batch(ProcessID dest, Bucket& b);
+
+        /// Invoked by the RMI server thread to send batches that waited too long
+        static void flush_stale();
+
+        /// RMI handler that unpacks a batch
+        static void batch_handler(void* buf, std::size_t nbyte);
+
+    public:
+        /// Returns the instance or null if coalescing is disabled
+        static AmCoalescer* instance() { return instance_ptr; }
+
+        /// Creates the instance if \c MAD_AM_COALESCE is set ... RMI must be running
+        static void begin();
+
+        /// Destroys the instance ... the RMI server thread must have been stopped
+        static void end();
+
+        /// Sends all batches of the instance, if any
+        static void flush_all_pending() {
+            if (instance_ptr) instance_ptr->flush_all();
+        }
+
+        /// Queues a message for \c dest (rank in COMM_WORLD)
+
+        /// On success ownership of \c arg is taken and it is freed
+        /// immediately.  Returns false (and does nothing) if the message is
+        /// too large to be coalesced.
+        bool append(ProcessID dest, const AmArg* arg);
+
+        /// Sends the batch for \c dest (rank in COMM_WORLD), if any
+        void flush(ProcessID dest);
+
+        /// Sends the batches for all destinations
+        void flush_all();
+
+        /// Frees the buffers of batches whose send has completed
+        void free_sent();
+
+        /// Returns the number of messages coalesced so far
+        std::uint64_t get_nmsg() const { return nmsg; }
+
+        /// Returns the number of batches sent so far
+        std::uint64_t get_nbatch() const { return nbatch; }
+    };
+
+
     /// Implements AM interface
     class WorldAmInterface : private SCALABLE_MUTEX_TYPE {
         friend class WorldGopInterface;
         friend class World;
+        friend class AmCoalescer;
     private:
 
 #ifdef HAVE_CRAYXT
@@ -270,8 +376,10 @@ namespace madness {
 
         virtual ~WorldAmInterface();
 
-        /// Currently a noop
-        void fence() {}
+        /// Sends any coalesced messages (see AmCoalescer)
+        void fence() {
+            AmCoalescer::flush_all_pending();
+        }
 
         /// Sends a managed non-blocking active message
         void send(ProcessID dest, am_handlerT op, const AmArg* arg,
@@ -294,6 +402,17 @@ namespace madness {
             // Map dest from world's communicator to comm_world
             dest = map_to_comm_world[dest];
 
+            // Small messages go into the batch for dest; any other
+            // message must follow what is already batched for dest.
+            AmCoalescer* coalescer = AmCoalescer::instance();
+            if (coalescer) {
+                if (coalescer->append(dest, arg)) {
+                    lock(); nsent++; unlock();
+                    return;
+                }
+                coalescer->flush(dest);
+            }
+
             // Remaining code refactored to avoid blocking with lock
             // and to enable finer grained calls into MPI send
 
@@ -353,6 +472,7 @@ namespace madness {
 
         /// Frees as many send buffers as possible, returning the number that are free
         int free_managed_buffers() {
+            if (AmCoalescer::instance()) AmCoalescer::instance()->free_sent();
             int nfree = 0;
             for (int i=0; i<nsend; i++) {
                 if (send_req[i].try_lock()) { // Someone may be trying to put a message into this buffer
@@ -43,8 +43,11 @@
 #include <madness/world/parallel_archive.h>
 #include <madness/world/worldhashmap.h>
 #include <madness/world/mpi_archive.h>
+#include <madness/world/mmap_archive.h>
+#include <madness/world/async_archive.h>
 #include <madness/world/world_object.h>
 #include <set>
+#include <algorithm>
 
 namespace madness {
 
@@ -450,6 +453,14 @@ namespace madness {
             return local.size();
         }
 
+        void set_flat_storage(bool flat) {
+            local.set_flat_storage(flat);
+        }
+
+        bool get_flat_storage() const {
+            return local.get_flat_storage();
+        }
+
         void insert(const pairT& datum) {
             ProcessID dest = owner(datum.first);
             if (dest == me) {
@@ -955,6 +966,22 @@ namespace madness {
             return p->size();
         }
 
+        /// Selects flat storage for the local data (no communication)
+
+        /// Flat storage (see ConcurrentHashMap::set_flat_storage) must
+        /// be selected before anything is inserted.
+        /// \param[in] flat True for flat storage, false for the default
+        void set_flat_storage(bool flat=true) {
+            check_initialized();
+            p->set_flat_storage(flat);
+        }
+
+        /// Returns true if the local data uses flat storage (no communication)
+        bool get_flat_storage() const {
+            check_initialized();
+            return p->get_flat_storage();
+        }
+
         /// Returns shared pointer to the process mapping
         inline const std::shared_ptr< WorldDCPmapInterface<keyT> >& get_pmap() const {
             check_initialized();
@@ -1528,16 +1555,112 @@ namespace madness {
     }
 
     namespace archive {
+        /// Write local data of a container to a memory-mapped archive
+
+        /// \ingroup worlddc
+        /// The layout is a cookie, the number of entries, the key index
+        /// (all keys), and then the values. Keeping the keys together lets
+        /// a reader scan them without touching the (aligned, possibly
+        /// large) payloads of the values, which are mapped rather than
+        /// copied on load. As with the sequential archives, only local data
+        /// is written and you should fence before and after.
+        template <class keyT, class valueT>
+        struct ArchiveStoreImpl< MMapOutputArchive, WorldContainer<keyT,valueT> > {
+            static void store(const MMapOutputArchive& ar, const WorldContainer<keyT,valueT>& t) {
+                const long magic = 5881829; // Sitar Indian restaurant in Knoxville, plus one for the mapped format
+                typedef typename WorldContainer<keyT,valueT>::const_iterator iterator;
+                unsigned long count = 0;
+                for (iterator it=t.begin(); it!=t.end(); ++it) ++count;
+                ar & magic & count;
+                for (iterator it=t.begin(); it!=t.end(); ++it) ar & it->first;
+                for (iterator it=t.begin(); it!=t.end(); ++it) ar & it->second;
+            }
+        };
+
+        /// Read local data of a container from a memory-mapped archive
+
+        /// \ingroup worlddc
+        /// See store method above for format of file content.
+        template <class keyT, class valueT>
+        struct ArchiveLoadImpl< MMapInputArchive, WorldContainer<keyT,valueT> > {
+            static void load(const MMapInputArchive& ar, WorldContainer<keyT,valueT>& t) {
+                const long magic = 5881829; // Sitar Indian restaurant in Knoxville, plus one for the mapped format
+                long cookie = 0l;
+                unsigned long count = 0;
+                ar & cookie & count;
+                MADNESS_ASSERT(cookie == magic);
+                std::vector<keyT> keys(count);
+                for (unsigned long i=0; i<count; ++i) ar & keys[i];
+                for (unsigned long i=0; i<count; ++i) {
+                    valueT value;
+                    ar & value;
+                    t.replace(keys[i], value);
+                }
+            }
+        };
+
+        namespace detail {
+
+            /// Writes the section of a parallel container to one local file
+
+            /// \ingroup worlddc
+            /// See the store method below for the layout. The local archive
+            /// must provide \c tell() and \c seek() so the header can be
+            /// filled in once the index has been written.
+            template <typename localarchiveT>
+            class ContainerSectionWriter {
+                localarchiveT& localar;
+                const long start; ///< Offset of the header
+                std::vector<long> index; ///< Offset of each entry
+
+            public:
+                static const long magic = -5881829; ///< Sitar Indian restaurant in Knoxville, less one for the indexed format
+
+                /// Starts the section at the current position of \c localar
+                explicit ContainerSectionWriter(localarchiveT& localar)
+                    : localar(localar), start(localar.tell())
+                {
+                    long header[3] = {magic, 0l, 0l};
+                    localar.store(header, 3);
+                }
+
+                /// Appends an entry
+                template <typename pairT>
+                void add(const pairT& datum) {
+                    index.push_back(localar.tell());
+                    localar & datum;
+                }
+
+                /// Writes the index and fills in the header
+                void finish() {
+                    long header[3] = {magic, localar.tell(), 0l};
+                    const long nentry = index.size();
+                    localar.store(&nentry, 1);
+                    if (nentry) localar.store(&index[0], nentry);
+                    header[2] = localar.tell();
+                    localar.seek(start);
+                    localar.store(header, 3);
+                    localar.seek(header[2]);
+                }
+            };
+        }
+
         /// Write container to parallel archive with optional fence
 
         /// \ingroup worlddc
         /// Each node (process) is served by a designated IO node.
-        /// The IO node has a binary local file archive to which is
-        /// first written a cookie and the number of servers.  The IO
-        /// node then loops thru all of its clients and in turn tells
-        /// each to write its data over an MPI stream, which is copied
-        /// directly to the output file.  The stream contents are then
-        /// cookie, no. of clients, foreach client (usual sequential archive).
+        /// The IO node loops thru all of its clients and in turn tells
+        /// each to write its data over an MPI stream, from which the
+        /// entries are copied directly to the IO node's local file.
+        /// The section written to each file is
+        /// - a header of three longs: cookie, offset of the index, and
+        ///   offset of the end of the section;
+        /// - the entries (key-value pairs) of all clients;
+        /// - the index: the number of entries followed by the offset of
+        ///   each entry.
+        ///
+        /// The index lets any number of readers split the entries of
+        /// each file into disjoint byte ranges (see the load method below).
         ///
         /// If ar.dofence() is true (default) fence is invoked before and
         /// after the IO. The fence is optional but it is of course
@@ -1548,20 +1671,18 @@ namespace madness {
         template <class keyT, class valueT>
         struct ArchiveStoreImpl< ParallelOutputArchive, WorldContainer<keyT,valueT> > {
             static void store(const ParallelOutputArchive& ar, const WorldContainer<keyT,valueT>& t) {
-                const long magic = -5881828; // Sitar Indian restaurant in Knoxville (negative to indicate parallel!)
                 typedef WorldContainer<keyT,valueT> dcT;
-                // typedef typename dcT::const_iterator iterator; // unused?
+                typedef typename dcT::const_iterator iterator;
                 typedef typename dcT::pairT pairT;
                 World* world = ar.get_world();
                 Tag tag = world->mpi.unique_tag();
                 ProcessID me = world->rank();
                 if (ar.dofence()) world->gop.fence();
                 if (ar.is_io_node()) {
-                    BinaryFstreamOutputArchive& localar = ar.local_archive();
-                    localar & magic & ar.num_io_clients();
+                    detail::ContainerSectionWriter<BinaryFstreamOutputArchive> section(ar.local_archive());
                     for (ProcessID p=0; p<world->size(); ++p) {
                         if (p == me) {
-                            localar & t;
+                            for (iterator it=t.begin(); it!=t.end(); ++it) section.add(*it);
                         }
                         else if (ar.io_node(p) == me) {
                             world->mpi.Send(int(1),p,tag); // Tell client to start sending
@@ -1569,19 +1690,15 @@ namespace madness {
                             long cookie = 0l;
                             unsigned long count = 0ul;
 
-                            ArchivePrePostImpl<BinaryFstreamOutputArchive,dcT>::preamble_store(localar);
-
                             source & cookie & count;
-                            localar & cookie & count;
                             while (count--) {
                                 pairT datum;
                                 source & datum;
-                                localar & datum;
+                                section.add(datum);
                             }
-
-                            ArchivePrePostImpl<BinaryFstreamOutputArchive,dcT>::postamble_store(localar);
                         }
                     }
+                    section.finish();
                 }
                 else {
                     ProcessID p = ar.my_io_node();
@@ -1595,33 +1712,122 @@ namespace madness {
             }
         };
 
+        /// Write local data of a container to an asynchronous parallel archive
+
+        /// \ingroup worlddc
+        /// Each process is its own IO node, so the local entries are
+        /// copied into the process's snapshot in the same format as
+        /// above, without fences or communication.
+        template <class keyT, class valueT>
+        struct ArchiveStoreImpl< AsyncParallelOutputArchive, WorldContainer<keyT,valueT> > {
+            static void store(const AsyncParallelOutputArchive& ar, const WorldContainer<keyT,valueT>& t) {
+                typedef typename WorldContainer<keyT,valueT>::const_iterator iterator;
+                detail::ContainerSectionWriter<SnapshotOutputArchive> section(ar.local_archive());
+                for (iterator it=t.begin(); it!=t.end(); ++it) section.add(*it);
+                section.finish();
+            }
+        };
+
         template <class keyT, class valueT>
         struct ArchiveLoadImpl< ParallelInputArchive, WorldContainer<keyT,valueT> > {
             /// Read container from parallel archive
 
             /// \ingroup worlddc
             /// See store method above for format of file content.
-            /// !!! We presently ASSUME that the number of writers and readers are
-            /// the same.  This is frustrating but not a show stopper since you
-            /// can always run a separate job to copy to a different number.
             ///
-            /// The IO node simply reads all data and inserts entries.
+            /// The number of readers need not match the number of
+            /// writers. One process per file reads its header and the
+            /// number of entries, which are then shared by all. The
+            /// entries of all files, taken in order, are split evenly
+            /// across all processes, so that each process opens the
+            /// files it needs, seeks to its first entry using the index,
+            /// and reads a contiguous byte range. Each entry is then
+            /// inserted by its owner under the container's process map.
+            ///
+            /// Archives written in the older format, in which each IO
+            /// node stored one sequential archive per client, are still
+            /// read, but only by as many IO nodes as wrote them.
             static void load(const ParallelInputArchive& ar, WorldContainer<keyT,valueT>& t) {
-                const long magic = -5881828; // Sitar Indian restaurant in Knoxville (negative to indicate parallel!)
-                // typedef WorldContainer<keyT,valueT> dcT; // unused
-                // typedef typename dcT::iterator iterator; // unused
-                // typedef typename dcT::pairT pairT; // unused
+                const long oldmagic = -5881828; // Sitar Indian restaurant in Knoxville (negative to indicate parallel!)
+                const long magic = detail::ContainerSectionWriter<BinaryFstreamOutputArchive>::magic;
+                typedef WorldContainer<keyT,valueT> dcT;
+                typedef typename dcT::pairT pairT;
                 World* world = ar.get_world();
+                const ProcessID me = world->rank();
+                const ProcessID nproc = world->size();
                 if (ar.dofence()) world->gop.fence();
-                if (ar.is_io_node()) {
-                    long cookie = 0l;
-                    int nclient = 0;
+
+                // Process zero also reads serial objects from its file, so it
+                // knows where this section starts and which format it has
+                long cookie = 0l;
+                long start = 0l;
+                if (me == 0) {
                     BinaryFstreamInputArchive& localar = ar.local_archive();
-                    localar & cookie & nclient;
-                    MADNESS_ASSERT(cookie == magic);
-                    while (nclient--) {
-                        localar & t;
+                    start = localar.tell();
+                    localar.load(&cookie, 1);
+                    localar.seek(start);
+                }
+                world->gop.broadcast(cookie, 0);
+
+                if (cookie != magic) {
+                    MADNESS_ASSERT(ar.num_io_nodes() <= nproc);
+                    if (ar.is_io_node()) {
+                        int nclient = 0;
+                        BinaryFstreamInputArchive& localar = ar.local_archive();
+                        localar & cookie & nclient;
+                        MADNESS_ASSERT(cookie == oldmagic);
+                        while (nclient--) {
+                            localar & t;
+                        }
+                    }
+                }
+                else {
+                    world->gop.broadcast(start, 0);
+                    ar.set_section_offset(0, start);
+                    const int nfile = ar.num_io_nodes();
+
+                    // Offset of the index, offset of the end, and number of entries for each file
+                    std::vector<long> info(3*nfile, 0l);
+                    for (int f=me; f<nfile; f+=nproc) {
+                        BinaryFstreamInputArchive localar(ar.local_filename(f).c_str());
+                        long header[3];
+                        localar.seek(ar.section_offset(f));
+                        localar.load(header, 3);
+                        MADNESS_ASSERT(header[0] == magic);
+                        localar.seek(header[1]);
+                        info[3*f] = header[1];
+                        info[3*f+1] = header[2];
+                        localar.load(&info[3*f+2], 1);
+                    }
+                    world->gop.sum(&info[0], info.size());
+
+                    long ntotal = 0l;
+                    for (int f=0; f<nfile; ++f) ntotal += info[3*f+2];
+                    const long lo = (ntotal*me)/nproc;
+                    const long hi = (ntotal*(me+1))/nproc;
+
+                    long first = 0l; // Global number of the first entry of file f
+                    for (int f=0; f<nfile && first<hi; ++f) {
+                        const long nentry = info[3*f+2];
+                        const long a = std::max(lo, first) - first;
+                        const long b = std::min(hi, first+nentry) - first;
+                        if (a < b) {
+                            BinaryFstreamInputArchive localar(ar.local_filename(f).c_str());
+                            long offset;
+                            localar.seek(info[3*f] + long(sizeof(long))*(1+a));
+                            localar.load(&offset, 1);
+                            localar.seek(offset);
+                            for (long i=a; i<b; ++i) {
+                                pairT datum;
+                                localar & datum;
+                                t.replace(datum);
+                            }
+                        }
+                        first += nentry;
                     }
+
+                    for (int f=0; f<nfile; ++f) ar.set_section_offset(f, info[3*f+1]);
+                    if (me == 0) ar.local_archive().seek(info[1]);
                 }
                 if (ar.dofence()) world->gop.fence();
             }
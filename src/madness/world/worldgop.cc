@@ -31,6 +31,7 @@
 
 #include <madness/world/worldgop.h>
 #include <madness/world/MADworld.h>
+#include <madness/world/worldtrace.h>
 #ifdef MADNESS_HAS_GOOGLE_PERF_MINIMAL
 #include <gperftools/malloc_extension.h>
 #endif
@@ -55,6 +56,7 @@ namespace madness {
         Tag gfence_tag = world_.mpi.unique_tag();
         Tag bcast_tag = world_.mpi.unique_tag();
         int npass = 0;
+        const double trace_start = WorldTrace::enabled() ? wall_time() : 0.0;
 
         //double start = wall_time();
 
@@ -70,6 +72,7 @@ namespace madness {
             uint64_t ntask1, nsent1, nrecv1, ntask2, nsent2, nrecv2;
             do {
                 world_.taskq.fence();
+                world_.am.fence(); // Send coalesced AM so they can be counted as received
 
                 // Since the number of outstanding tasks and number of AM sent/recv
                 // don't share a critical section read each twice and ensure they
@@ -134,6 +137,7 @@ namespace madness {
         MallocExtension::instance()->ReleaseFreeMemory();
 //        print("clearing memory");
 #endif
+        if (trace_start) WorldTrace::fence(trace_start, npass);
     }
 
 
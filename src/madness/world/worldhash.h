@@ -235,6 +235,22 @@ namespace madness {
         }
     }; // struct Hash
 
+    /// Family of a key for storage that groups related keys
+
+    /// The flat storage of ConcurrentHashMap keeps keys with the same
+    /// family close together in memory.  By default every key is its own
+    /// family; specialize this for key types with a natural grouping.
+    /// \tparam T The key type
+    template <typename T>
+    struct HashFamily {
+
+        /// \param t The key
+        /// \return The key that identifies the family of \c t
+        static const T& family(const T& t) {
+            return t;
+        }
+    }; // struct HashFamily
+
     namespace detail {
         /// Internal use only
         // We don't hash anything here. It is just used for combining a hashed
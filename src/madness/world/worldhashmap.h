@@ -46,9 +46,14 @@
 #include <madness/world/worldmutex.h>
 #include <madness/world/madness_exception.h>
 #include <madness/world/worldhash.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <new>
 #include <stdio.h>
 #include <map>
+#include <vector>
 
 namespace madness {
 
@@ -59,20 +64,90 @@ namespace madness {
 
     namespace Hash_private {
 
-        // A hashtable is an array of nbin bins.
-        // Each bin is a linked list of entries protected by a spinlock.
-        // Each entry holds a key+value pair, a read-write mutex, and a link to the next entry.
+        // A hashtable is a single linked list of entries sorted by the
+        // bit-reversed hash of their keys (a split-ordered list).  The
+        // list is cut into nbins bins, each of which starts with a
+        // sentinel link and is protected by a spinlock.  The entries of a
+        // bin are those between its sentinel and the next sentinel.
+        // Each entry holds a key+value pair and a read-write mutex.
+        //
+        // The number of bins is a power of two and is doubled when the
+        // load factor grows too large.  Doubling only changes the number
+        // that keys are hashed modulo; a new bin is split from the list
+        // the first time it is used by linking in its sentinel.  Entries
+        // never move in memory or in the list so accessors and iterators
+        // remain valid while the table grows, and a thread that looked in
+        // a bin that was split while it waited for the lock just retries.
+
+        /// Reverses the order of the bits in a hash value
+        inline hashT reverse_bits(hashT h) {
+            if (sizeof(hashT) == sizeof(uint64_t)) {
+                uint64_t x = h;
+                x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+                x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+                x = ((x >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+                x = ((x >> 8) & 0x00FF00FF00FF00FFull) | ((x & 0x00FF00FF00FF00FFull) << 8);
+                x = ((x >> 16) & 0x0000FFFF0000FFFFull) | ((x & 0x0000FFFF0000FFFFull) << 16);
+                x = (x >> 32) | (x << 32);
+                return hashT(x);
+            }
+            else {
+                hashT r = 0;
+                for (std::size_t i=0; i<8*sizeof(hashT); ++i, h>>=1) r = (r << 1) | (h & 1);
+                return r;
+            }
+        }
+
+        /// Scrambles the bits of a hash value
+
+        /// Bins are selected with the low bits of the hash, which are poor
+        /// for hash functions that just return a pointer or counter.
+        inline hashT mix_bits(hashT h) {
+            uint64_t x = h;
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdull;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ull;
+            x ^= x >> 33;
+            return hashT(x);
+        }
+
+        /// Returns floor(log2(n)) for n>0
+        inline unsigned int log2_floor(std::size_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+            return 8*sizeof(unsigned long long) - 1 - __builtin_clzll((unsigned long long)(n));
+#else
+            unsigned int r = 0;
+            while (n >>= 1) ++r;
+            return r;
+#endif
+        }
+
+        /// Link in the split-ordered list
+
+        /// Entries have odd \c order (the bit-reversed hash with the low bit
+        /// set) and bin sentinels have even \c order (the bit-reversed bin
+        /// index).
+        class link {
+        public:
+            link* volatile next;
+            hashT order;
+
+            link(hashT order, link* next) : next(next), order(order) {}
+
+            bool is_entry() const {
+                return order & 1;
+            }
+        };
 
         template <typename keyT, typename valueT>
-        class entry : public madness::MutexReaderWriter {
+        class entry : public madness::MutexReaderWriter, public link {
         public:
             typedef std::pair<const keyT, valueT> datumT;
             datumT datum;
 
-            class entry<keyT,valueT> * volatile next;
-
-            entry(const datumT& datum, entry<keyT,valueT>* next)
-                    : datum(datum), next(next) {}
+            entry(const datumT& datum, hashT order, link* next)
+                    : link(order, next), datum(datum) {}
         };
 
         template <class keyT, class valueT>
@@ -84,34 +159,46 @@ namespace madness {
             // perhaps better to just use more bins
         public:
 
-            entryT* volatile p;
-            int volatile ninbin;
+            link head;                  // Sentinel, linked into the list once ready
+            int volatile ninbin;        // Number of entries in this bin
+            std::atomic<bool> ready;    // True once this bin is split from its parent
 
-            bin() : p(0),ninbin(0) {}
+            bin() : head(0,0), ninbin(0), ready(false) {}
 
-            ~bin() {
-                clear();
-            }
+            using madness::Spinlock::lock;
+            using madness::Spinlock::unlock;
 
-            void clear() {
+            /// Deletes all entries in this bin and returns how many there were
+            int clear() {
                 lock();             // BEGIN CRITICAL SECTION
-                while (p) {
-                    entryT* n=p->next;
-                    delete p;
-                    p=n;
+                int n = 0;
+                link* t = head.next;
+                while (t && t->is_entry()) {
+                    link* next = t->next;
+                    delete static_cast<entryT*>(t);
+                    t = next;
                     ninbin--;
+                    ++n;
                 }
+                head.next = t;
                 MADNESS_ASSERT(ninbin == 0);
                 unlock();           // END CRITICAL SECTION
+                return n;
             }
 
-            entryT* find(const keyT& key, const int lockmode) const {
+            /// Finds key in this bin
+
+            /// \return false if the key now belongs to a bin split from this
+            /// one while waiting, in which case the caller must retry.
+            bool find(const keyT& key, hashT order, const int lockmode, entryT*& result) {
                 bool gotlock;
-                entryT* result;
                 madness::MutexWaiter waiter;
                 do {
                     lock();             // BEGIN CRITICAL SECTION
-                    result = match(key);
+                    if (!match(key, order, result)) {
+                        unlock();
+                        return false;
+                    }
                     if (result) {
                         gotlock = result->try_lock(lockmode);
                     }
@@ -123,51 +210,60 @@ namespace madness {
                 }
                 while (!gotlock);
 
-                return result;
+                return true;
             }
 
-            std::pair<entryT*,bool> insert(const datumT& datum, int lockmode) {
+            /// Inserts datum into this bin unless its key is already present
+
+            /// \return false if the key now belongs to a bin split from this
+            /// one while waiting, in which case the caller must retry.
+            bool insert(const datumT& datum, hashT order, int lockmode, std::pair<entryT*,bool>& result) {
                 bool gotlock;
-                entryT* result;
-                bool notfound;
                 madness::MutexWaiter waiter;
                 do {
                     lock();             // BEGIN CRITICAL SECTION
-                    result = match(datum.first);
-                    notfound = !result;
-                    if (notfound) {
-                        result = p = new entryT(datum,p);
+                    link* prev = match(datum.first, order, result.first);
+                    if (!prev) {
+                        unlock();
+                        return false;
+                    }
+                    result.second = !result.first;
+                    if (result.second) {
+                        result.first = new entryT(datum, order, prev->next);
+                        prev->next = result.first;
                         ++ninbin;
                     }
-                    gotlock = result->try_lock(lockmode);
+                    gotlock = result.first->try_lock(lockmode);
                     unlock();           // END CRITICAL SECTION
                     if (!gotlock) waiter.wait(); //cpu_relax();
                 }
                 while (!gotlock);
 
-                return std::pair<entryT*,bool>(result,notfound);
+                return true;
             }
 
-            bool del(const keyT& key, int lockmode) {
-                bool status = false;
+            /// Deletes key from this bin
+
+            /// \return false if the key now belongs to a bin split from this
+            /// one, in which case the caller must retry.
+            bool del(const keyT& key, hashT order, int lockmode, bool& status) {
+                entryT* t;
+                status = false;
                 lock();             // BEGIN CRITICAL SECTION
-                for (entryT *t=p,*prev=0; t; prev=t,t=t->next) {
-                    if (t->datum.first == key) {
-                        if (prev) {
-                            prev->next = t->next;
-                        }
-                        else {
-                            p = t->next;
-                        }
-                        t->unlock(lockmode);
-                        delete t;
-                        --ninbin;
-                        status = true;
-                        break;
-                    }
+                link* prev = match(key, order, t);
+                if (!prev) {
+                    unlock();
+                    return false;
+                }
+                if (t) {
+                    prev->next = t->next;
+                    t->unlock(lockmode);
+                    delete t;
+                    --ninbin;
+                    status = true;
                 }
                 unlock();           // END CRITICAL SECTION
-                return status;
+                return true;
             }
 
             std::size_t size() const {
@@ -175,15 +271,235 @@ namespace madness {
             };
 
         private:
-            entryT* match(const keyT& key) const {
-                entryT* t;
-                for (t=p; t; t=t->next)
-                    if (t->datum.first == key) break;
-                return t;
+            /// Locates key in this bin; the bin must be locked
+
+            /// \return the link after which the key is (or would be
+            /// inserted), or null if a sentinel of a newer bin was found
+            /// before the position of the key
+            link* match(const keyT& key, hashT order, entryT*& result) {
+                link* prev = &head;
+                result = 0;
+                for (link* t=prev->next; t && t->order<=order; prev=t, t=t->next) {
+                    if (!t->is_entry()) return 0;
+                    if (t->order == order && static_cast<entryT*>(t)->datum.first == key) {
+                        result = static_cast<entryT*>(t);
+                        break;
+                    }
+                }
+                return prev;
             }
 
         };
 
+        // Flat storage replaces the bins by a fixed number of shards.  A
+        // shard is an open-addressing table of (hash, entry) slots in
+        // cache-line-aligned memory, so a lookup compares hashes without
+        // touching the entries, and its entries are allocated from slabs
+        // owned by the shard.  Keys of the same family go to the same
+        // shard so that they are allocated next to each other.  The
+        // entries of a shard are also kept in a doubly linked list after
+        // its sentinel, and the sentinels of all shards are chained, so
+        // iteration is exactly as for the split-ordered list.
+
+        template <typename keyT, typename valueT>
+        class flat_entry : public entry<keyT,valueT> {
+        public:
+            typedef std::pair<const keyT, valueT> datumT;
+            link* volatile prev;
+
+            flat_entry(const datumT& datum, hashT order, link* prev, link* next)
+                    : entry<keyT,valueT>(datum, order, next), prev(prev) {}
+        };
+
+        template <class keyT, class valueT>
+        class flat_bin : public bin<keyT,valueT> {
+        private:
+            typedef entry<keyT,valueT> entryT;
+            typedef flat_entry<keyT,valueT> flat_entryT;
+            typedef std::pair<const keyT, valueT> datumT;
+
+            struct slot {
+                hashT hash;
+                flat_entryT* entry;     // Null if empty
+            };
+
+            static const std::size_t cache_line = 64;
+            static const std::size_t slab_size = 64; // Entries per slab
+
+            slot* slots;                // Table, 2^n slots or null
+            std::size_t mask;           // No. of slots - 1
+            std::vector<void*> slabs;   // Memory for entries
+            flat_entryT* freelist;      // Entries that were deleted
+            std::size_t nfresh;         // Never used entries in the last slab
+
+            using bin<keyT,valueT>::lock;
+            using bin<keyT,valueT>::unlock;
+            using bin<keyT,valueT>::head;
+            using bin<keyT,valueT>::ninbin;
+
+            flat_entryT* new_entry(const datumT& datum, hashT order) {
+                void* p;
+                if (freelist) {
+                    p = freelist;
+                    freelist = *static_cast<flat_entryT**>(p);
+                }
+                else {
+                    if (nfresh == 0) {
+                        void* slab;
+                        if (posix_memalign(&slab, cache_line, slab_size*sizeof(flat_entryT)))
+                            throw std::bad_alloc();
+                        slabs.push_back(slab);
+                        nfresh = slab_size;
+                    }
+                    p = static_cast<flat_entryT*>(slabs.back()) + (slab_size - nfresh--);
+                }
+                link* next = head.next;
+                flat_entryT* e = new (p) flat_entryT(datum, order, &head, next);
+                if (next && next->is_entry()) static_cast<flat_entryT*>(next)->prev = e;
+                head.next = e;
+                return e;
+            }
+
+            void delete_entry(flat_entryT* e) {
+                link* next = e->next;
+                e->prev->next = next;
+                if (next && next->is_entry()) static_cast<flat_entryT*>(next)->prev = e->prev;
+                e->~flat_entryT();
+                *reinterpret_cast<flat_entryT**>(e) = freelist;
+                freelist = e;
+            }
+
+            /// Returns the slot of key or the empty slot where it would go
+            std::size_t probe(const keyT& key, hashT hash) const {
+                std::size_t i = hash & mask;
+                while (slots[i].entry && !(slots[i].hash == hash && slots[i].entry->datum.first == key))
+                    i = (i+1) & mask;
+                return i;
+            }
+
+            /// Doubles the table if inserting one more entry would fill it beyond 70%
+            void grow() {
+                const std::size_t nslot = slots ? mask+1 : 0;
+                if (10*(std::size_t(ninbin)+1) <= 7*nslot) return;
+
+                const std::size_t newnslot = nslot ? 2*nslot : 16;
+                void* p;
+                if (posix_memalign(&p, cache_line, newnslot*sizeof(slot))) throw std::bad_alloc();
+                slot* newslots = static_cast<slot*>(p);
+                memset(newslots, 0, newnslot*sizeof(slot));
+                for (std::size_t i=0; i<nslot; ++i) {
+                    if (slots[i].entry) {
+                        std::size_t j = slots[i].hash & (newnslot-1);
+                        while (newslots[j].entry) j = (j+1) & (newnslot-1);
+                        newslots[j] = slots[i];
+                    }
+                }
+                free(slots);
+                slots = newslots;
+                mask = newnslot-1;
+            }
+
+            /// Empties slot i, moving back later entries of its probe sequence
+            void remove_slot(std::size_t i) {
+                for (std::size_t j=(i+1)&mask; slots[j].entry; j=(j+1)&mask) {
+                    const std::size_t k = slots[j].hash & mask;
+                    // Move entry j to i unless its home slot k is cyclically in (i,j]
+                    if ((i<=j) ? (i<k && k<=j) : (i<k || k<=j)) continue;
+                    slots[i] = slots[j];
+                    i = j;
+                }
+                slots[i].entry = 0;
+            }
+
+        public:
+            flat_bin() : slots(0), mask(0), freelist(0), nfresh(0) {}
+
+            ~flat_bin() {
+                clear();
+                free(slots);
+                for (std::size_t i=0; i<slabs.size(); ++i) free(slabs[i]);
+            }
+
+            /// Deletes all entries in this shard and returns how many there were
+            int clear() {
+                lock();             // BEGIN CRITICAL SECTION
+                int n = 0;
+                while (head.next && head.next->is_entry()) {
+                    delete_entry(static_cast<flat_entryT*>(head.next));
+                    ninbin--;
+                    ++n;
+                }
+                if (slots) memset(slots, 0, (mask+1)*sizeof(slot));
+                MADNESS_ASSERT(ninbin == 0);
+                unlock();           // END CRITICAL SECTION
+                return n;
+            }
+
+            /// Same as bin::find but never fails
+            bool find(const keyT& key, hashT hash, const int lockmode, entryT*& result) {
+                bool gotlock;
+                madness::MutexWaiter waiter;
+                do {
+                    lock();             // BEGIN CRITICAL SECTION
+                    result = slots ? slots[probe(key, hash)].entry : 0;
+                    if (result) {
+                        gotlock = result->try_lock(lockmode);
+                    }
+                    else {
+                        gotlock = true;
+                    }
+                    unlock();           // END CRITICAL SECTION
+                    if (!gotlock) waiter.wait(); //cpu_relax();
+                }
+                while (!gotlock);
+
+                return true;
+            }
+
+            /// Same as bin::insert but never fails
+            bool insert(const datumT& datum, hashT hash, int lockmode, std::pair<entryT*,bool>& result) {
+                bool gotlock;
+                madness::MutexWaiter waiter;
+                do {
+                    lock();             // BEGIN CRITICAL SECTION
+                    grow();
+                    const std::size_t i = probe(datum.first, hash);
+                    result.second = !slots[i].entry;
+                    if (result.second) {
+                        slots[i].hash = hash;
+                        slots[i].entry = new_entry(datum, hash | 1);
+                        ++ninbin;
+                    }
+                    result.first = slots[i].entry;
+                    gotlock = result.first->try_lock(lockmode);
+                    unlock();           // END CRITICAL SECTION
+                    if (!gotlock) waiter.wait(); //cpu_relax();
+                }
+                while (!gotlock);
+
+                return true;
+            }
+
+            /// Same as bin::del but never fails
+            bool del(const keyT& key, hashT hash, int lockmode, bool& status) {
+                status = false;
+                lock();             // BEGIN CRITICAL SECTION
+                if (slots) {
+                    const std::size_t i = probe(key, hash);
+                    flat_entryT* t = slots[i].entry;
+                    if (t) {
+                        remove_slot(i);
+                        t->unlock(lockmode);
+                        delete_entry(t);
+                        --ninbin;
+                        status = true;
+                    }
+                }
+                unlock();           // END CRITICAL SECTION
+                return true;
+            }
+        };
+
         /// iterator for hash
         template <class hashT> class HashIterator {
         public:
@@ -201,38 +517,34 @@ namespace madness {
 
         private:
             hashT* h;               // Associated hash table
-            int bin;                // Current bin
+            std::size_t bin;        // Current bin
             entryT* entry;          // Current entry in bin ... zero means at end
 
             template <class otherHashT>
             friend class HashIterator;
 
-            /// If the entry is null (end of current bin) finds next non-empty bin
-            void next_non_null_entry() {
-                while (!entry) {
-                    ++bin;
-                    if ((unsigned) bin == h->nbins) {
-                        entry = 0;
-                        return;
-                    }
-                    entry = h->bins[bin].p;
+            /// Moves to the first entry at or after t, keeping track of the bin
+            void next_entry(link* t) {
+                while (t && !t->is_entry()) {
+                    bin = reverse_bits(t->order);
+                    t = t->next;
                 }
-                return;
+                entry = static_cast<entryT*>(t);
             }
 
         public:
 
             /// Makes invalid iterator
-            HashIterator() : h(0), bin(-1), entry(0) {}
+            HashIterator() : h(0), bin(0), entry(0) {}
 
             /// Makes begin/end iterator
             HashIterator(hashT* h, bool begin)
-                    : h(h), bin(-1), entry(0) {
-                if (begin) next_non_null_entry();
+                    : h(h), bin(0), entry(0) {
+                if (begin) next_entry(h->get_bin(0).head.next);
             }
 
             /// Makes iterator to specific entry
-            HashIterator(hashT* h, int bin, entryT* entry)
+            HashIterator(hashT* h, std::size_t bin, entryT* entry)
                     : h(h), bin(bin), entry(entry) {}
 
             /// Copy constructor
@@ -249,8 +561,7 @@ namespace madness {
 
             HashIterator& operator++() {
                 if (!entry) return *this;
-                entry = entry->next;
-                next_non_null_entry();
+                next_entry(entry->next);
                 return *this;
             }
 
@@ -277,29 +588,35 @@ namespace madness {
                 MADNESS_ASSERT(n>=0);
 
                 // Linear increment up to end of this bin
-                while (n-- && (entry=entry->next)) {}
-                next_non_null_entry();
-                if (!entry) return; // end
-
-                if (n <= 0) return;
+                link* t = entry->next;
+                while (n && t && t->is_entry()) {
+                    entry = static_cast<entryT*>(t);
+                    t = t->next;
+                    --n;
+                }
+                if (n == 0) return;
+                if (!t) {
+                    entry = 0;
+                    return; // end
+                }
 
-                // If here, will point to first entry in
-                // a bin ... determine which bin contains
+                // If here, t is the sentinel of the next bin in list
+                // order ... skip whole bins until the one that contains
                 // our end point.
-                while (unsigned(n) >= h->bins[bin].size()) {
-                    n -= h->bins[bin].size();
-                    ++bin;
-                    if (unsigned(bin) == h->nbins) {
+                bin = reverse_bits(t->order);
+                while (unsigned(n) > h->get_bin(bin).size()) {
+                    n -= h->get_bin(bin).size();
+                    if (!h->next_bin(bin)) {
                         entry = 0;
                         return; // end
                     }
                 }
 
-                entry = h->bins[bin].p;
-                MADNESS_ASSERT(entry);
-
                 // Linear increment to target
-                while (n--) entry=entry->next;
+                t = h->get_bin(bin).head.next;
+                while (--n) t = t->next;
+                entry = static_cast<entryT*>(t);
+                MADNESS_ASSERT(entry && t->is_entry());
 
                 return;
             }
@@ -399,6 +716,7 @@ namespace madness {
         typedef std::pair<const keyT,valueT> datumT;
         typedef Hash_private::entry<keyT,valueT> entryT;
         typedef Hash_private::bin<keyT,valueT> binT;
+        typedef Hash_private::flat_bin<keyT,valueT> flat_binT;
         typedef Hash_private::HashIterator<hashT> iterator;
         typedef Hash_private::HashIterator<const hashT> const_iterator;
         typedef Hash_private::HashAccessor<hashT,entryT::WRITELOCK> accessor;
@@ -407,50 +725,228 @@ namespace madness {
         friend class Hash_private::HashIterator<hashT>;
         friend class Hash_private::HashIterator<const hashT>;
 
-    protected:
-        const size_t nbins;         // Number of bins
-        binT* bins;                 // Array of bins
-
     private:
+        // Bins are allocated in segments that are never moved.  Segment 0
+        // holds the first 2^lognbins0 bins and segment s>0 holds bins
+        // [2^(lognbins0+s-1), 2^(lognbins0+s)).
+        static const unsigned int nsegment = 32;
+
+        /// Table is doubled when the average no. of entries per bin exceeds this
+        static const std::size_t maxload = 2;
+
+        /// Log2 of the no. of shards of flat storage
+        static const unsigned int lognshard = 6;
+
+        const unsigned int lognbins0;                   // Log2 of no. of bins in segment 0
+        mutable std::atomic<binT*> segments[nsegment];  // Segments of bins
+        std::atomic<std::size_t> nbins;                 // Number of bins
+        std::atomic<std::size_t> nentries;              // Number of entries
+        flat_binT* shards;                              // Shards if flat storage, else null
+
         hashfunT hashfun;
 
-        //unsigned int hash(const keyT& key) const {return hashfunT::hash(key)%nbins;}
-
-        static int nbins_prime(int n) {
-            static const int primes[] = {11, 23, 31, 41, 53, 61, 71, 83, 101,
-                131, 181, 239, 293, 359, 421, 557, 673, 821, 953, 1021, 1231,
-                1531, 1747, 2069, 2543, 3011, 4003, 5011, 6073, 7013, 8053,
-                9029, 9907, 17401, 27479, 37847, 48623, 59377, 70667, 81839,
-                93199, 104759, 224759, 350411, 479951, 611969, 746791, 882391,
-                1299743, 2750171, 4256257, 5800159, 7368811, 8960477, 10570871,
-                12195269, 13834133};
-            static const int nprimes = sizeof(primes)/sizeof(int);
+        static unsigned int lognbins_initial(int n) {
             // n is a user provided estimate of the no. of elements to be put
-            // in the table.  Want to make the number of bins a prime number
-            // larger than this.
-            for (int i=0; i<nprimes; ++i) if (n<=primes[i]) return primes[i];
-            return primes[nprimes-1];
+            // in the table.  Want the number of bins to be the power of two
+            // at least n/maxload, but not so small that the table must grow
+            // right away.
+            unsigned int logn = 4;
+            while (logn < 24 && (std::size_t(1) << logn)*maxload < std::size_t(n)) ++logn;
+            return logn;
         }
 
-        unsigned int hash_to_bin(const keyT& key) const {
-            return hashfun(key)%nbins;
+        void init() {
+            shards = 0;
+            for (unsigned int s=0; s<nsegment; ++s) segments[s] = 0;
+            nbins = std::size_t(1) << lognbins0;
+            nentries = 0;
+            binT& b = get_bin(0);
+            b.head.order = 0;
+            b.ready = true;
+        }
+
+        /// Returns bin (or shard) b, allocating its segment if necessary
+        binT& get_bin(std::size_t b) const {
+            if (shards) return shards[b];
+            unsigned int s = 0;
+            std::size_t offset = b;
+            if (b >> lognbins0) {
+                const unsigned int logb = Hash_private::log2_floor(b);
+                s = logb - lognbins0 + 1;
+                offset = b - (std::size_t(1) << logb);
+            }
+            binT* seg = segments[s].load(std::memory_order_acquire);
+            if (!seg) {
+                const std::size_t n = std::size_t(1) << (s ? lognbins0+s-1 : lognbins0);
+                binT* newseg = new binT[n];
+                if (segments[s].compare_exchange_strong(seg, newseg, std::memory_order_acq_rel)) {
+                    seg = newseg;
+                }
+                else {
+                    delete [] newseg;
+                }
+            }
+            return seg[offset];
+        }
+
+        /// Returns true if bin b has been split from its parent
+        bool is_ready(std::size_t b) const {
+            return get_bin(b).ready.load(std::memory_order_acquire);
+        }
+
+        /// Moves b to the next ready bin in list order, returns false at end
+
+        /// Bins are in the list in the bit-reversed order of their index,
+        /// shards in the order of their index.
+        bool next_bin(std::size_t& b) const {
+            if (shards) return ++b < (std::size_t(1) << lognshard);
+            const std::size_t nb = nbins;
+            const unsigned int shift = 8*sizeof(madness::hashT) - Hash_private::log2_floor(nb);
+            std::size_t pos = Hash_private::reverse_bits(madness::hashT(b)) >> shift;
+            do {
+                if (++pos == nb) return false;
+                b = Hash_private::reverse_bits(madness::hashT(pos)) >> shift;
+            } while (!is_ready(b));
+            return true;
+        }
+
+        /// Returns the shard of key for flat storage
+        std::size_t shard_index(const keyT& key) const {
+            return Hash_private::mix_bits(hashfun(HashFamily<keyT>::family(key))) >> (8*sizeof(madness::hashT) - lognshard);
+        }
+
+        /// Returns the index of the bin for hash h, splitting the bin if necessary
+        std::size_t bin_index(madness::hashT h) const {
+            const std::size_t b = h & (nbins.load(std::memory_order_acquire) - 1);
+            if (!is_ready(b)) split_bin(b);
+            return b;
+        }
+
+        /// Links the sentinel of bin b into the list
+
+        /// The sentinel goes into the bin that currently holds the entries
+        /// of b.  That is its nearest ready ancestor or, if another
+        /// descendant of that ancestor was split first, a bin found
+        /// further down the list.  Entries after the sentinel move to b.
+        void split_bin(std::size_t b) const {
+            using Hash_private::link;
+            binT& target = get_bin(b);
+            const madness::hashT order = Hash_private::reverse_bits(madness::hashT(b));
+
+            std::size_t a = b;
+            do {
+                a &= ~(std::size_t(1) << Hash_private::log2_floor(a));
+            } while (!is_ready(a));
+
+            binT* p = &get_bin(a);
+            p->lock();              // BEGIN CRITICAL SECTION
+            while (!target.ready.load(std::memory_order_acquire)) {
+                link* prev = &p->head;
+                link* t;
+                for (t=prev->next; t && t->order<order && t->is_entry(); prev=t, t=t->next) {}
+                if (t && t->order<order) {
+                    // Walk on in the bin that now precedes b in the list
+                    binT* q = &get_bin(Hash_private::reverse_bits(t->order));
+                    p->unlock();
+                    q->lock();
+                    p = q;
+                    continue;
+                }
+                int n = 0;
+                for (link* u=t; u && u->is_entry(); u=u->next) ++n;
+                target.head.order = order;
+                target.head.next = t;
+                target.ninbin = n;
+                prev->next = &target.head;
+                p->ninbin -= n;
+                target.ready.store(true, std::memory_order_release);
+            }
+            p->unlock();            // END CRITICAL SECTION
+        }
+
+        /// Doubles the number of bins if the load factor is too large
+        void grow(std::size_t n) {
+            std::size_t nb = nbins.load(std::memory_order_relaxed);
+            if (n > maxload*nb && Hash_private::log2_floor(nb) < lognbins0+nsegment-1)
+                nbins.compare_exchange_strong(nb, 2*nb);
+        }
+
+        madness::hashT hash(const keyT& key) const {
+            return Hash_private::mix_bits(hashfun(key));
+        }
+
+        static madness::hashT entry_order(madness::hashT h) {
+            return Hash_private::reverse_bits(h) | 1;
+        }
+
+        std::pair<std::size_t,std::pair<entryT*,bool> > insert_entry(const datumT& datum, int lockmode) {
+            const madness::hashT h = hash(datum.first);
+            std::pair<entryT*,bool> r;
+            std::size_t bin;
+            if (shards) {
+                bin = shard_index(datum.first);
+                shards[bin].insert(datum, h, lockmode, r);
+                if (r.second) ++nentries;
+                return std::make_pair(bin, r);
+            }
+            do {
+                bin = bin_index(h);
+            } while (!get_bin(bin).insert(datum, entry_order(h), lockmode, r));
+            if (r.second) grow(++nentries);
+            return std::make_pair(bin, r);
+        }
+
+        std::pair<std::size_t,entryT*> find_entry(const keyT& key, int lockmode) const {
+            const madness::hashT h = hash(key);
+            entryT* entry;
+            std::size_t bin;
+            if (shards) {
+                bin = shard_index(key);
+                shards[bin].find(key, h, lockmode, entry);
+                return std::make_pair(bin, entry);
+            }
+            do {
+                bin = bin_index(h);
+            } while (!get_bin(bin).find(key, entry_order(h), lockmode, entry));
+            return std::make_pair(bin, entry);
+        }
+
+        bool del_entry(const keyT& key, int lockmode) {
+            const madness::hashT h = hash(key);
+            bool status;
+            if (shards)
+                shards[shard_index(key)].del(key, h, lockmode, status);
+            else
+                while (!get_bin(bin_index(h)).del(key, entry_order(h), lockmode, status)) {}
+            if (status) --nentries;
+            return status;
         }
 
     public:
         ConcurrentHashMap(int n=1021, const hashfunT& hf = hashfunT())
-                : nbins(hashT::nbins_prime(n))
-                , bins(new binT[nbins])
-                , hashfun(hf) {}
+                : lognbins0(hashT::lognbins_initial(n))
+                , hashfun(hf) {
+            init();
+        }
 
         ConcurrentHashMap(const  hashT& h)
-                : nbins(h.nbins)
-                , bins(new binT[nbins])
+                : lognbins0(hashT::lognbins_initial(h.size()))
                 , hashfun(h.hashfun) {
+            init();
+            set_flat_storage(h.get_flat_storage());
             *this = h;
         }
 
         virtual ~ConcurrentHashMap() {
-            delete [] bins;
+            delete [] shards;
+            shards = 0;
+            Hash_private::link* t = get_bin(0).head.next;
+            while (t) {
+                Hash_private::link* next = t->next;
+                if (t->is_entry()) delete static_cast<entryT*>(t);
+                t = next;
+            }
+            for (unsigned int s=0; s<nsegment; ++s) delete [] segments[s].load();
         }
 
         hashT& operator=(const  hashT& h) {
@@ -465,27 +961,24 @@ namespace madness {
         }
 
         std::pair<iterator,bool> insert(const datumT& datum) {
-            int bin = hash_to_bin(datum.first);
-            std::pair<entryT*,bool> result = bins[bin].insert(datum,entryT::NOLOCK);
-            return std::pair<iterator,bool>(iterator(this,bin,result.first),result.second);
+            std::pair<std::size_t,std::pair<entryT*,bool> > r = insert_entry(datum,entryT::NOLOCK);
+            return std::pair<iterator,bool>(iterator(this,r.first,r.second.first),r.second.second);
         }
 
         /// Returns true if new pair was inserted; false if key is already in the map and the datum was not inserted
         bool insert(accessor& result, const datumT& datum) {
             result.release();
-            int bin = hash_to_bin(datum.first);
-            std::pair<entryT*,bool> r = bins[bin].insert(datum,entryT::WRITELOCK);
-            result.set(r.first);
-            return r.second;
+            std::pair<std::size_t,std::pair<entryT*,bool> > r = insert_entry(datum,entryT::WRITELOCK);
+            result.set(r.second.first);
+            return r.second.second;
         }
 
         /// Returns true if new pair was inserted; false if key is already in the map and the datum was not inserted
         bool insert(const_accessor& result, const datumT& datum) {
             result.release();
-            int bin = hash_to_bin(datum.first);
-            std::pair<entryT*,bool> r = bins[bin].insert(datum,entryT::READLOCK);
-            result.set(r.first);
-            return r.second;
+            std::pair<std::size_t,std::pair<entryT*,bool> > r = insert_entry(datum,entryT::READLOCK);
+            result.set(r.second.first);
+            return r.second.second;
         }
 
         /// Returns true if new pair was inserted; false if key is already in the map
@@ -499,7 +992,7 @@ namespace madness {
         }
 
         std::size_t erase(const keyT& key) {
-            if (bins[hash_to_bin(key)].del(key,entryT::NOLOCK)) return 1;
+            if (del_entry(key,entryT::NOLOCK)) return 1;
             else return 0;
         }
 
@@ -509,34 +1002,31 @@ namespace madness {
         }
 
         void erase(accessor& item) {
-            bins[hash_to_bin(item->first)].del(item->first,entryT::WRITELOCK);
+            del_entry(item->first,entryT::WRITELOCK);
             item.unset();
         }
 
         void erase(const_accessor& item) {
             item.convert_read_lock_to_write_lock();
-            bins[hash_to_bin(item->first)].del(item->first,entryT::WRITELOCK);
+            del_entry(item->first,entryT::WRITELOCK);
             item.unset();
         }
 
         iterator find(const keyT& key) {
-            int bin = hash_to_bin(key);
-            entryT* entry = bins[bin].find(key,entryT::NOLOCK);
-            if (!entry) return end();
-            else return iterator(this,bin,entry);
+            std::pair<std::size_t,entryT*> r = find_entry(key,entryT::NOLOCK);
+            if (!r.second) return end();
+            else return iterator(this,r.first,r.second);
         }
 
         const_iterator find(const keyT& key) const {
-            int bin = hash_to_bin(key);
-            const entryT* entry = bins[bin].find(key,entryT::NOLOCK);
-            if (!entry) return end();
-            else return const_iterator(this,bin,entry);
+            std::pair<std::size_t,entryT*> r = find_entry(key,entryT::NOLOCK);
+            if (!r.second) return end();
+            else return const_iterator(this,r.first,r.second);
         }
 
         bool find(accessor& result, const keyT& key) {
             result.release();
-            int bin = hash_to_bin(key);
-            entryT* entry = bins[bin].find(key,entryT::WRITELOCK);
+            entryT* entry = find_entry(key,entryT::WRITELOCK).second;
             bool foundit = entry;
             if (foundit) result.set(entry);
             return foundit;
@@ -544,21 +1034,62 @@ namespace madness {
 
         bool find(const_accessor& result, const keyT& key) const {
             result.release();
-            int bin = hash_to_bin(key);
-            entryT* entry = bins[bin].find(key,entryT::READLOCK);
+            entryT* entry = find_entry(key,entryT::READLOCK).second;
             bool foundit = entry;
             if (foundit) result.set(entry);
             return foundit;
         }
 
+        /// Selects flat storage (open addressing in shards) or the default split-ordered list
+
+        /// Flat storage makes lookups cheaper and keeps the entries of a
+        /// family of keys (see HashFamily) together in memory, but a shard
+        /// is locked while its table is resized.  Can only be changed
+        /// while the map is empty.
+        /// \param[in] flat True to select flat storage
+        void set_flat_storage(bool flat=true) {
+            MADNESS_ASSERT(size() == 0);
+            if (flat == get_flat_storage()) return;
+            if (flat) {
+                const std::size_t nshard = std::size_t(1) << lognshard;
+                flat_binT* s = new flat_binT[nshard];
+                for (std::size_t i=0; i<nshard; ++i) {
+                    binT& b = s[i];
+                    b.head.order = Hash_private::reverse_bits(madness::hashT(i));
+                    b.head.next = (i+1<nshard) ? &static_cast<binT&>(s[i+1]).head : 0;
+                    b.ready = true;
+                }
+                shards = s;
+            }
+            else {
+                delete [] shards;
+                shards = 0;
+            }
+        }
+
+        /// Returns true if flat storage is selected
+        bool get_flat_storage() const {
+            return shards;
+        }
+
         void clear() {
-            for (unsigned int i=0; i<nbins; ++i) bins[i].clear();
+            if (shards) {
+                for (std::size_t i=0; i<(std::size_t(1) << lognshard); ++i) nentries -= shards[i].clear();
+                return;
+            }
+            const std::size_t nb = nbins;
+            for (std::size_t i=0; i<nb; ++i) {
+                if (is_ready(i)) nentries -= get_bin(i).clear();
+            }
         }
 
         size_t size() const {
-            size_t sum = 0;
-            for (size_t i=0; i<nbins; ++i) sum += bins[i].size();
-            return sum;
+            return nentries;
+        }
+
+        /// Returns the number of bins, which grows with the number of entries
+        size_t bin_count() const {
+            return shards ? (std::size_t(1) << lognshard) : std::size_t(nbins);
         }
 
         valueT& operator[](const keyT& key) {
@@ -585,9 +1116,10 @@ namespace madness {
         hashfunT& get_hash() const { return hashfun; }
 
         void print_stats() const {
-            for (unsigned int i=0; i<nbins; ++i) {
+            const std::size_t nb = shards ? (std::size_t(1) << lognshard) : std::size_t(nbins);
+            for (std::size_t i=0; i<nb; ++i) {
                 if (i && (i%10)==0) printf("\n");
-                printf("%8d", int(bins[i].size()));
+                printf("%8d", is_ready(i) ? int(get_bin(i).size()) : -1);
             }
             printf("\n");
         }
@@ -33,6 +33,7 @@
 */
 
 #include <madness/world/worldmem.h>
+#include <madness/world/memory_pool.h>
 #include <cstdlib>
 //#include <cstdio>
 #include <climits>
@@ -100,6 +101,21 @@ namespace madness {
             << cur_num_bytes << " " << std::setw(12) << max_num_bytes << "\n";
     }
 
+    void WorldMemInfo::print_pool() const {
+        const MemoryPool::Stats s = MemoryPool::get_stats();
+        std::cout.flush();
+        std::cout << "\n    MADNESS memory pool statistics\n";
+        std::cout << "    ------------------------------\n";
+        std::cout << "   calls to allocate and free " << std::setw(12)
+            << s.nalloc << " " << std::setw(12) << s.nfree << "\n";
+        std::cout << "       allocations from cache " << std::setw(12)
+            << s.nhit << "\n";
+        std::cout << "    blocks returned to system " << std::setw(12)
+            << s.nrelease << "\n";
+        std::cout << "  cur and max bytes in caches " << std::setw(12)
+            << s.cur_cached_bytes << " " << std::setw(12) << s.max_cached_bytes << "\n";
+    }
+
     void WorldMemInfo::reset() {
         num_new_calls = 0;
         num_del_calls = 0;
@@ -93,6 +93,9 @@ namespace madness {
         /// Prints memory use statistics to std::cout
         void print() const;
 
+        /// Prints statistics of the tensor memory pool (see \c MemoryPool) to std::cout
+        void print_pool() const;
+
         /// Resets all counters to zero
         void reset();
 
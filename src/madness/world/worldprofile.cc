@@ -33,6 +33,7 @@
 #include <madness/world/mpi_archive.h>
 #include <madness/world/MADworld.h>
 #include <madness/world/atomicint.h>
+#include <madness/world/worldtrace.h>
 
 namespace madness {
 
@@ -404,7 +405,8 @@ namespace madness {
         }
     }
 
-    WorldProfileObj::WorldProfileObj(int id) : prev(call_stack), id(id), cpu_base(madness::cpu_time()), stats_base(::madness::RMI::get_stats()) {
+    WorldProfileObj::WorldProfileObj(int id) : prev(call_stack), id(id), cpu_base(madness::cpu_time()), stats_base(::madness::RMI::get_stats())
+                                             , trace_start(WorldTrace::enabled() ? wall_time() : 0.0) {
         int tid = mythreadid;
         if (tid == -1) tid = mythreadid = ++threadcounter;
         MADNESS_ASSERT(mythreadid < 64);
@@ -458,6 +460,7 @@ namespace madness {
         }
         call_stack = prev;
         if (call_stack) call_stack->resume(now, stats);
+        if (trace_start) WorldTrace::profile(id, trace_start);
     }
 
 } // namespace madness
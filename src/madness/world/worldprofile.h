@@ -179,6 +179,7 @@ namespace madness {
         RMIStats stats_base;         ///< Msg stats when I start executing
         double cpu_start;            ///< Time that I was at top of stack
         RMIStats stats_start;        ///< Msg stats when I was at top of stack;
+        const double trace_start;    ///< Wall time that I started executing if tracing, else 0
     public:
 
         WorldProfileObj(int id);
@@ -34,6 +34,7 @@
 #include <madness/world/worldrmi.h>
 #include <madness/world/posixmem.h>
 #include <madness/world/timers.h>
+#include <madness/world/worldtrace.h>
 #include <iostream>
 #include <algorithm>
 #include <utility>
@@ -47,6 +48,7 @@ namespace madness {
     RMI::RmiTask* RMI::task_ptr = nullptr;
     RMIStats RMI::stats;
     volatile bool RMI::debugging = false;
+    volatile RMI::idle_hookT RMI::idle_hook = nullptr;
     std::list< std::unique_ptr<RMISendReq> > RMI::send_req;
 
     thread_local bool RMI::is_server_thread = false;
@@ -72,6 +74,8 @@ namespace madness {
 
         MutexWaiter waiter;
         while((narrived == 0) && (iterations < 1000)) {
+          const idle_hookT hook = idle_hook;
+          if (hook) hook();
 	  narrived = SafeMPI::Request::Testsome(maxq_, recv_req.get(), ind.get(), status.get());
           if (narrived) break;
 	  ++iterations;
@@ -113,7 +117,9 @@ namespace madness {
                                   << std::endl;
 
                     if (is_ordered(attr)) ++(recv_counters[src]);
+                    const double trace_start = WorldTrace::enabled() ? wall_time() : 0.0;
                     func(recv_buf[i], len);
+                    if (trace_start) WorldTrace::rmi_recv(reinterpret_cast<const void*>(func), src, len, trace_start);
                     post_recv_buf(i);
                 }
                 else {
@@ -156,7 +162,10 @@ namespace madness {
                                   << std::endl;
 
                     ++(recv_counters[src]);
+                    const double trace_start = WorldTrace::enabled() ? wall_time() : 0.0;
                     q[m].func(recv_buf[q[m].i], q[m].len);
+                    if (trace_start)
+                        WorldTrace::rmi_recv(reinterpret_cast<const void*>(q[m].func), src, q[m].len, trace_start);
                     post_recv_buf(q[m].i);
                 }
                 else {
@@ -458,6 +467,8 @@ namespace madness {
 
         unlock();
 
+        if (WorldTrace::enabled()) WorldTrace::rmi_send(dest, nbyte);
+
         return result;
     }
 
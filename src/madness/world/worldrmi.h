@@ -143,6 +143,10 @@ namespace madness {
     class RMI  {
         typedef uint16_t counterT;
         typedef uint32_t attrT;
+    public:
+        /// Type of the function the server thread calls while polling
+        typedef void (*idle_hookT)();
+    private:
 
         static thread_local bool is_server_thread; //< if true this thread is the server thread
 
@@ -279,6 +283,7 @@ namespace madness {
 #endif // HAVE_INTEL_TBB
 
         static RmiTask* task_ptr;    // Pointer to the singleton instance
+        static volatile idle_hookT idle_hook; // Called by the server thread while polling
         static RMIStats stats;
         static volatile bool debugging;    // True if debugging
 
@@ -347,6 +352,13 @@ namespace madness {
             }
         }
 
+        /// Sets the function that the server thread calls each time it polls for messages
+
+        /// The hook runs in the server thread so it must not block; pass
+        /// nullptr to remove it.  Used by AmCoalescer to send batches that
+        /// have waited too long.
+        static void set_idle_hook(idle_hookT hook) { idle_hook = hook; }
+
         static void set_debug(bool status) { debugging = status; }
 
         static bool get_debug() { return debugging; }
@@ -0,0 +1,296 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/**
+ \file worldtrace.cc
+ \brief Implementation of the Chrome trace-event recorder.
+ \ingroup world
+*/
+
+#include <madness/world/worldtrace.h>
+#include <madness/world/thread.h>
+#include <madness/world/worldprofile.h>
+#include <madness/world/safempi.h>
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace madness {
+
+    bool WorldTrace::enabled_ = false;
+
+    namespace {
+
+        /// One recorded event
+        struct TraceEvent {
+            double start, stop;
+            const void* task;
+            const void* name;
+            long arg0, arg1;
+            unsigned short kind, namekind;
+        };
+
+        /// The events recorded by one thread, in chunks of fixed size
+        struct TraceBuffer {
+            static const std::size_t chunk_size = 4096;
+
+            int tid;            ///< Thread id in the trace
+            int pool_index;     ///< Index of the thread in the pool, or -1
+            std::size_t n;      ///< Number of recorded events
+            std::size_t ndropped; ///< Number of events beyond max_events
+            std::vector< std::unique_ptr<TraceEvent[]> > chunks;
+
+            TraceBuffer(int tid, int pool_index)
+                : tid(tid), pool_index(pool_index), n(0), ndropped(0) { }
+
+            TraceEvent& operator[](std::size_t i) {
+                return chunks[i/chunk_size][i%chunk_size];
+            }
+        };
+
+        Mutex buffers_mutex;                // Guards buffers
+        std::vector<TraceBuffer*> buffers;  // Buffers are kept for the life of the process
+        thread_local TraceBuffer* my_buffer = nullptr;
+        std::string file_prefix;
+        double sync_begin = 0.0;            // Wall time when all processes left the first barrier
+
+        TraceBuffer* get_buffer() {
+            if (! my_buffer) {
+                const ThreadBase* thread = ThreadBase::this_thread();
+                ScopedMutex<Mutex> obolus(buffers_mutex);
+                my_buffer = new TraceBuffer(buffers.size(), thread ? thread->get_pool_thread_index() : -1);
+                buffers.push_back(my_buffer);
+            }
+            return my_buffer;
+        }
+
+        /// Writes \c s as a JSON string
+        void write_json_string(std::ostream& os, const std::string& s) {
+            os << '"';
+            for (std::size_t i=0; i<s.size(); ++i) {
+                const char c = s[i];
+                if (c == '"' || c == '\\') os << '\\' << c;
+                else if (static_cast<unsigned char>(c) < 0x20) os << ' ';
+                else os << c;
+            }
+            os << '"';
+        }
+
+        /// Demangled name of a C++ symbol, or the symbol itself
+        std::string demangle(const char* symbol) {
+            int status = 0;
+            char* name = abi::__cxa_demangle(symbol, 0, 0, &status);
+            std::string result = (status == 0 && name) ? name : symbol;
+            free(name);
+            return result;
+        }
+
+        /// Name of the function at address \c fn from the dynamic symbol table
+        std::string function_name(const void* fn) {
+            void* const ptr = const_cast<void*>(fn);
+            char** sym = backtrace_symbols(&ptr, 1);
+            std::string mangled;
+            if (sym) {
+                // Format is <file>(<mangled name>+<offset>) [<address>]
+                const char* first = strchr(sym[0], '(');
+                if (first) {
+                    ++first;
+                    const char* last = strrchr(first, '+');
+                    if (last) mangled.assign(first, last - first);
+                }
+                free(sym);
+            }
+            if (mangled.empty()) {
+                std::ostringstream s;
+                s << fn;
+                return s.str();
+            }
+            return demangle(mangled.c_str());
+        }
+
+        /// Resolves and caches the names of tasks and RMI handlers
+        class NameCache {
+            std::map<const void*, std::string> names;
+        public:
+            const std::string& get(const void* name, unsigned short namekind, const char* dflt) {
+                std::map<const void*, std::string>::iterator it = names.find(name);
+                if (it != names.end()) return it->second;
+                std::string s;
+                if (namekind == 1 && name) s = function_name(name);
+                else if (namekind == 2 && name) s = demangle(static_cast<const char*>(name));
+                else s = dflt;
+                return names[name] = s;
+            }
+        };
+
+    } // namespace
+
+    void WorldTrace::record(Kind kind, double start, double stop, const void* task,
+                            const void* name, unsigned short namekind, long arg0, long arg1) {
+        TraceBuffer* buf = get_buffer();
+        if (buf->n >= max_events) {
+            ++(buf->ndropped);
+            return;
+        }
+        if (buf->n == buf->chunks.size()*TraceBuffer::chunk_size)
+            buf->chunks.emplace_back(new TraceEvent[TraceBuffer::chunk_size]);
+        TraceEvent& e = (*buf)[buf->n++];
+        e.start = start;
+        e.stop = stop;
+        e.task = task;
+        e.name = name;
+        e.arg0 = arg0;
+        e.arg1 = arg1;
+        e.kind = kind;
+        e.namekind = namekind;
+    }
+
+    void WorldTrace::task_run(const PoolTaskInterface* task, double start, int nthread) {
+        std::pair<void*,unsigned short> id;
+        task->get_id(id);
+        record(TASK_RUN, start, wall_time(), task, id.first, id.second, nthread, 0);
+    }
+
+    void WorldTrace::begin() {
+        const char* prefix = getenv("MAD_TRACE");
+        if (! prefix || ! *prefix) return;
+        file_prefix = prefix;
+
+        // Leaving a barrier at (nearly) the same time gives the common origin
+        // of the clocks of all processes
+        SafeMPI::COMM_WORLD.Barrier();
+        sync_begin = wall_time();
+        get_buffer(); // The main thread is the first thread of the trace
+        enabled_ = true;
+    }
+
+    void WorldTrace::end() {
+        if (! enabled_) return;
+
+        // The end of this barrier is the second synchronization point, from
+        // which the merge corrects for the drift of the clocks
+        SafeMPI::COMM_WORLD.Barrier();
+        const double sync_end = wall_time();
+        enabled_ = false;
+
+        const int rank = SafeMPI::COMM_WORLD.Get_rank();
+        std::ostringstream file_name;
+        file_name << file_prefix << "." << rank << ".json";
+        std::ofstream file(file_name.str().c_str());
+        if (file.fail()) {
+            std::cerr << "!!! ERROR: WorldTrace cannot open file: " << file_name.str() << "\n";
+            return;
+        }
+        file.precision(15);
+
+        // One event per line so that the files can be merged by a simple script
+        file << "{\"otherData\":{\"rank\":" << rank
+             << ",\"nproc\":" << SafeMPI::COMM_WORLD.Get_size()
+             << ",\"sync_us\":" << (sync_end - sync_begin)*1e6
+             << "},\n\"traceEvents\":[\n";
+        file << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << rank
+             << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+
+        NameCache names;
+        std::size_t ndropped = 0;
+        ScopedMutex<Mutex> obolus(buffers_mutex);
+        for (std::size_t b=0; b<buffers.size(); ++b) {
+            TraceBuffer& buf = *buffers[b];
+            const std::string common = ",\"pid\":" + std::to_string(rank) + ",\"tid\":" + std::to_string(buf.tid);
+
+            file << ",\n{\"ph\":\"M\",\"name\":\"thread_name\"" << common << ",\"args\":{\"name\":\"";
+            if (buf.pool_index >= 0) file << "pool thread " << buf.pool_index;
+            else if (buf.tid == 0) file << "main thread";
+            else file << "thread " << buf.tid;
+            file << "\"}}";
+
+            for (std::size_t i=0; i<buf.n; ++i) {
+                const TraceEvent& e = buf[i];
+                const double ts = (e.start - sync_begin)*1e6;
+                const double dur = (e.stop - e.start)*1e6;
+                file << ",\n";
+                switch (e.kind) {
+                case TASK_SUBMIT:
+                    file << "{\"ph\":\"s\",\"name\":\"task\",\"cat\":\"task\",\"id\":\"" << rank << ":"
+                         << e.task << "\",\"ts\":" << ts << common << "}";
+                    break;
+                case TASK_RUN:
+                    file << "{\"ph\":\"X\",\"name\":";
+                    write_json_string(file, names.get(e.name, e.namekind, "task"));
+                    file << ",\"cat\":\"task\",\"ts\":" << ts << ",\"dur\":" << dur << common
+                         << ",\"args\":{\"nthread\":" << e.arg0 << "}},\n";
+                    file << "{\"ph\":\"f\",\"bp\":\"e\",\"name\":\"task\",\"cat\":\"task\",\"id\":\"" << rank << ":"
+                         << e.task << "\",\"ts\":" << ts << common << "}";
+                    break;
+                case RMI_SEND:
+                    file << "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"rmi send\",\"cat\":\"rmi\",\"ts\":" << ts << common
+                         << ",\"args\":{\"dest\":" << e.arg0 << ",\"nbyte\":" << e.arg1 << "}}";
+                    break;
+                case RMI_RECV:
+                    file << "{\"ph\":\"X\",\"name\":";
+                    write_json_string(file, names.get(e.name, e.namekind, "rmi handler"));
+                    file << ",\"cat\":\"rmi\",\"ts\":" << ts << ",\"dur\":" << dur << common
+                         << ",\"args\":{\"src\":" << e.arg0 << ",\"nbyte\":" << e.arg1 << "}}";
+                    break;
+                case FENCE:
+                    file << "{\"ph\":\"X\",\"name\":\"fence\",\"cat\":\"gop\",\"ts\":" << ts << ",\"dur\":" << dur << common
+                         << ",\"args\":{\"npass\":" << e.arg0 << "}}";
+                    break;
+                case PROFILE:
+                    file << "{\"ph\":\"X\",\"name\":";
+                    write_json_string(file, WorldProfile::get_entry(int(e.arg0)).name);
+                    file << ",\"cat\":\"profile\",\"ts\":" << ts << ",\"dur\":" << dur << common << "}";
+                    break;
+                }
+            }
+
+            ndropped += buf.ndropped;
+            buf.n = 0;
+            buf.ndropped = 0;
+            buf.chunks.clear();
+        }
+        file << "\n]}\n";
+        file.close();
+
+        if (ndropped)
+            std::cerr << "!!! WARNING: WorldTrace dropped " << ndropped << " events on rank " << rank
+                      << " (limit is " << std::size_t(max_events) << " per thread)\n";
+    }
+
+} // namespace madness
@@ -0,0 +1,139 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_WORLD_WORLDTRACE_H__INCLUDED
+#define MADNESS_WORLD_WORLDTRACE_H__INCLUDED
+
+/**
+ \file worldtrace.h
+ \brief Timeline of runtime events in the Chrome trace-event format.
+ \ingroup world
+
+ If the environment variable \c MAD_TRACE is set, every process records
+ task submission and execution, RMI messages, global fences and (in builds
+ with \c WORLD_PROFILE_ENABLE) the \c PROFILE_BLOCK regions into buffers
+ private to each thread.  At finalize each process writes the file
+ <tt>$MAD_TRACE.<rank>.json</tt>, which can be loaded directly into
+ \c chrome://tracing or Perfetto.  The script \c bin/tracemerge.pl merges
+ the files of all processes into one trace, correcting for the offset and
+ drift of the clocks of the processes.
+
+ When tracing is disabled each hook costs a test of a static flag.
+*/
+
+#include <madness/madness_config.h>
+#include <madness/world/timers.h>
+#include <cstddef>
+
+namespace madness {
+
+    class PoolTaskInterface;
+
+    /// Records a timeline of runtime events for the Chrome trace viewer
+
+    /// All members are static; \c begin and \c end are called from
+    /// \c initialize and \c finalize.  Events are appended to a buffer owned
+    /// by the calling thread, so recording needs no locks.  Each thread
+    /// keeps at most \c max_events events; later events are counted and
+    /// dropped.
+    class WorldTrace {
+    public:
+        /// Kinds of recorded events
+        enum Kind {
+            TASK_SUBMIT,    ///< A task was added to the pool (start of a flow)
+            TASK_RUN,       ///< A task ran (slice, end of its flow)
+            RMI_SEND,       ///< An RMI message was sent (instant)
+            RMI_RECV,       ///< The handler of an RMI message ran (slice)
+            FENCE,          ///< A global fence (slice)
+            PROFILE         ///< A \c PROFILE_BLOCK region (slice)
+        };
+
+        /// Maximum number of events recorded by a thread
+        static const std::size_t max_events = std::size_t(1) << 20;
+
+    private:
+        static bool enabled_;       ///< True if events are recorded
+
+        /// Appends an event to the buffer of the calling thread
+
+        /// \param[in] kind The kind of event.
+        /// \param[in] start,stop The wall times of the event (\c stop is ignored for instants).
+        /// \param[in] task The task of the event, used to connect submission and execution.
+        /// \param[in] name Function pointer (\c namekind 1), type name (\c namekind 2) or
+        ///     nothing (\c namekind 0) that names the event; resolved when the trace is written.
+        /// \param[in] arg0,arg1 Arguments of the event depending on its kind.
+        static void record(Kind kind, double start, double stop, const void* task,
+                           const void* name, unsigned short namekind, long arg0, long arg1);
+
+    public:
+        /// Returns true if events are recorded
+        static bool enabled() {
+            return enabled_;
+        }
+
+        /// Starts recording if \c MAD_TRACE is set (collective on COMM_WORLD)
+        static void begin();
+
+        /// Writes this process's trace and stops recording (collective on COMM_WORLD)
+        static void end();
+
+        /// Records the submission of a task
+        static void task_submit(const PoolTaskInterface* task) {
+            record(TASK_SUBMIT, wall_time(), 0.0, task, nullptr, 0, 0, 0);
+        }
+
+        /// Records the execution of a task that started at \c start
+        static void task_run(const PoolTaskInterface* task, double start, int nthread);
+
+        /// Records an RMI message of \c nbyte bytes sent to \c dest
+        static void rmi_send(int dest, std::size_t nbyte) {
+            record(RMI_SEND, wall_time(), 0.0, nullptr, nullptr, 0, dest, long(nbyte));
+        }
+
+        /// Records the handler of an RMI message of \c nbyte bytes from \c src
+        static void rmi_recv(const void* func, int src, std::size_t nbyte, double start) {
+            record(RMI_RECV, start, wall_time(), nullptr, func, 1, src, long(nbyte));
+        }
+
+        /// Records a global fence that started at \c start
+        static void fence(double start, int npass) {
+            record(FENCE, start, wall_time(), nullptr, nullptr, 0, npass, 0);
+        }
+
+        /// Records a region of the world profiler with entry \c id
+        static void profile(int id, double start) {
+            record(PROFILE, start, wall_time(), nullptr, nullptr, 0, id, 0);
+        }
+    };
+
+} // namespace madness
+
+#endif // MADNESS_WORLD_WORLDTRACE_H__INCLUDED
@@ -0,0 +1,206 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_WORLD_WSQUEUE_H__INCLUDED
+#define MADNESS_WORLD_WSQUEUE_H__INCLUDED
+
+/**
+ \file wsqueue.h
+ \brief Implements WSQueue, a lock-free work-stealing deque.
+ \ingroup threads
+*/
+
+#include <atomic>
+#include <cstddef>
+
+namespace madness {
+
+    /// \addtogroup threads
+    /// @{
+
+    /// A lock-free, single-owner work-stealing deque (Chase-Lev).
+
+    /// The owning thread pushes and pops at the bottom (LIFO) without
+    /// taking a lock; any other thread may steal from the top (FIFO). Only
+    /// the last element is contended, and that race is resolved with a
+    /// single compare-and-swap on \c top.
+    ///
+    /// The circular buffer grows as needed but never shrinks. Since a thief
+    /// may still be reading an old buffer when the owner grows it, retired
+    /// buffers are kept until the queue is destroyed. With doubling this
+    /// at most doubles the memory footprint.
+    ///
+    /// Follows N.M. Le, A. Pop, A. Cohen and F. Zappa Nardelli, "Correct and
+    /// efficient work-stealing for weak memory models", PPoPP 2013.
+    /// \tparam T The element type, which must be trivially copyable (in
+    ///     practice a pointer).
+    template <typename T>
+    class WSQueue {
+    private:
+
+        /// Circular buffer of elements.
+        struct Array {
+            const long size; ///< Capacity (a power of 2).
+            const long mask; ///< `size - 1`.
+            std::atomic<T>* const buf; ///< The elements.
+            Array* const prev; ///< Retired, smaller buffer (or null).
+
+            Array(long size, Array* prev)
+                : size(size), mask(size-1), buf(new std::atomic<T>[size]), prev(prev)
+            { }
+
+            ~Array() {
+                delete [] buf;
+                delete prev;
+            }
+
+            T get(long i) const {
+                return buf[i & mask].load(std::memory_order_relaxed);
+            }
+
+            void put(long i, T value) {
+                buf[i & mask].store(value, std::memory_order_relaxed);
+            }
+        };
+
+        char pad0[64]; ///< Keep the hot indices off other cache lines.
+        std::atomic<long> top; ///< Index of the next element to steal.
+        char pad1[64 - sizeof(std::atomic<long>)]; ///< Separates \c top from \c bottom.
+        std::atomic<long> bottom; ///< Index of the next free slot.
+        std::atomic<Array*> array; ///< Current buffer.
+        char pad2[64]; ///< Keep the hot indices off other cache lines.
+
+        WSQueue(const WSQueue&) = delete;
+        WSQueue& operator=(const WSQueue&) = delete;
+
+        /// Double the capacity of the buffer (owner only).
+        Array* grow(Array* a, long b, long t) {
+            Array* na = new Array(a->size*2, a);
+            for (long i=t; i<b; ++i) na->put(i, a->get(i));
+            array.store(na, std::memory_order_release);
+            return na;
+        }
+
+    public:
+
+        /// Construct an empty queue.
+
+        /// \param[in] hint Initial capacity, rounded up to a power of 2.
+        explicit WSQueue(long hint=1024) : top(0), bottom(0), array(nullptr) {
+            long size = 2;
+            while (size < hint) size <<= 1;
+            array.store(new Array(size, nullptr), std::memory_order_relaxed);
+        }
+
+        ~WSQueue() {
+            delete array.load(std::memory_order_relaxed);
+        }
+
+        /// Push an element onto the bottom of the queue (owner only).
+
+        /// \param[in] value The element to push.
+        void push(T value) {
+            const long b = bottom.load(std::memory_order_relaxed);
+            const long t = top.load(std::memory_order_acquire);
+            Array* a = array.load(std::memory_order_relaxed);
+            if (b - t > a->size - 1) a = grow(a, b, t);
+            a->put(b, value);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        /// Pop an element from the bottom of the queue (owner only).
+
+        /// \param[out] value The popped element, if any.
+        /// \return True if an element was popped.
+        bool pop(T& value) {
+            const long b = bottom.load(std::memory_order_relaxed) - 1;
+            Array* const a = array.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            long t = top.load(std::memory_order_relaxed);
+
+            if (t > b) { // Empty
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            value = a->get(b);
+            if (t == b) {
+                // Last element ... race against thieves for it
+                const bool won = top.compare_exchange_strong(t, t + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /// Steal an element from the top of the queue (any thread).
+
+        /// May fail spuriously if another thread wins the race for the
+        /// same element.
+        /// \param[out] value The stolen element, if any.
+        /// \return True if an element was stolen.
+        bool steal(T& value) {
+            long t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const long b = bottom.load(std::memory_order_acquire);
+            if (t >= b) return false;
+
+            Array* const a = array.load(std::memory_order_acquire);
+            value = a->get(t);
+            return top.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        /// Approximate number of elements in the queue.
+
+        /// \return The number of elements; exact only when quiescent.
+        std::size_t size() const {
+            const long b = bottom.load(std::memory_order_relaxed);
+            const long t = top.load(std::memory_order_relaxed);
+            return (b > t) ? std::size_t(b - t) : 0;
+        }
+
+        /// Test if the queue appears empty.
+
+        /// \return True if no elements were visible.
+        bool empty() const {
+            return size() == 0;
+        }
+    };
+
+    /// @}
+
+} // namespace madness
+
+#endif // MADNESS_WORLD_WSQUEUE_H__INCLUDED